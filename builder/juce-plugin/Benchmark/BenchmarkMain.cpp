@@ -0,0 +1,1394 @@
+// Headless processor benchmark.
+//
+// Links PluginProcessor.cpp without the editor and sweeps sample rates, block sizes,
+// channel layouts, parameter scenarios (including per-block automation ramps) and
+// sample precision. Channel layouts go up to 7.1.4 and 16 discrete channels; a
+// summary compares one 7.1.4 instance with the six stereo instances it replaces.
+// Results are written as JSON (default) or CSV so they can be
+// tracked between releases.
+//
+// Precision modes: "float"; "double", a 64-bit host calling the native double
+// processBlock; and "double_via_float", the same host converting every block to
+// float and back around the float processBlock (what hosts do for float-only plug-ins).
+// "double" saves the block copies, not float arithmetic: the tape stages narrow each
+// sample to float either way, so only the gains and the tanh kernel compute in double.
+//
+// State: a session's worth of instances is saved and restored with the binary state
+// format and with the legacy APVTS XML, reporting microseconds per instance and blob size.
+//
+// Tape EQ: the record/playback filter bank on its own, steady and while crossfading between
+// curves, as a share of the whole chain at the same rate, block size and layout.
+//
+// Convolver: the head and transformer IRs on their own, likewise, steady and while crossfading
+// between IRs.
+//
+// Prepare: the same number of instances are prepared one after another. The first builds
+// the process-wide tables; the rest should be flat however many there are.
+//
+// CPU telemetry: each config also reports what the processor's own per-block telemetry
+// measured (mean block time and p99 load) and what measuring cost, as a share of the block.
+//
+// Quality: the fused chain in the 4x IIR scenario, stereo at 512 samples, under each quality
+// profile (Eco, Realtime, Best, and Auto with the host rendering offline) at every sample rate,
+// with its cost relative to Realtime.
+//
+// Threads: the same scenario under Best, at 48 kHz, with the tape stage forced onto 1, 3 and 7
+// worker threads (as many as the machine has cores for) against running it on one thread, per
+// layout and block size; then with the most workers and the split gate deciding, as shipped.
+//
+// Presets: stereo at 48 kHz and 128 samples, recalling the factory presets in turn; what a
+// recall costs the message thread, and the blocks that crossfade (two engines running)
+// against the steady ones.
+//
+// Block sizes: the fused chain, stereo at 48 kHz, at every host block size from 16 to 4096
+// samples and at random sizes up to 512 (hosts around loop points), with the micro-block
+// scheduler and without; per-sample cost should stay flat across sizes with it.
+//
+// Null test: first of all, the fused tanh kernel (every ISA variant this CPU runs, float and
+// double) against the juce::dsp reference chain, with the same random gain automation; the
+// largest difference must stay within fastTanh's 1e-4 bound (plus the ramps' rounding in
+// float), or the benchmark exits 1.
+//
+// Engine graph: Engines/ampex_102.json, embedded in this target, runs wherever the chain runs
+// at 1x and is reported on its own. It is not the whole tape chain (gains, hysteresis and EQ,
+// but no head/transformer IRs or wow and flutter), so it is not compared with the fused path.
+//
+//   HtmlToVstBenchmark [--quick] [--csv] [--seconds <s>] [--precision <mode|all>] [--out <file>]
+
+#include "../Source/PluginProcessor.h"
+#include "../Source/Convolver.h"
+#include "../Source/TapeEq.h"
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+
+struct Scenario
+{
+    const char* name;
+    float inGainDb;
+    float drive;
+    float outGainDb;
+    int osFactorIndex;   // 0..3 -> 1x..8x
+    int osModeIndex;     // 0 = IIR, 1 = FIR
+    bool automate;       // ramp every parameter once per block, like host automation
+    bool silent;         // digital silence in (silence bypass kicks in after the tail)
+    bool allowBypass;
+};
+
+static const Scenario scenarios[] =
+{
+    { "static",           0.0f, 0.0f,  0.0f, 0, 0, false, false, true  },
+    { "drive",            6.0f, 0.8f, -6.0f, 0, 0, false, false, true  },
+    { "automation",       0.0f, 0.5f,  0.0f, 0, 0, true,  false, true  },
+    { "os2x_iir",         6.0f, 0.8f, -6.0f, 1, 0, false, false, true  },
+    { "os4x_iir",         6.0f, 0.8f, -6.0f, 2, 0, false, false, true  },
+    { "os8x_iir",         6.0f, 0.8f, -6.0f, 3, 0, false, false, true  },
+    { "os4x_fir",         6.0f, 0.8f, -6.0f, 2, 1, false, false, true  },
+    { "os4x_automation",  0.0f, 0.5f,  0.0f, 2, 0, true,  false, true  },
+    { "silence",          6.0f, 0.8f, -6.0f, 2, 0, false, true,  true  },
+    { "silence_nobypass", 6.0f, 0.8f, -6.0f, 2, 0, false, true,  false },
+};
+
+enum class Precision
+{
+    single,
+    native64,
+    converted64
+};
+
+static const Precision precisions[] = { Precision::single, Precision::native64, Precision::converted64 };
+
+static const char* getPrecisionName (Precision p)
+{
+    switch (p)
+    {
+        case Precision::single:      return "float";
+        case Precision::native64:    return "double";
+        case Precision::converted64: return "double_via_float";
+    }
+
+    return "unknown";
+}
+
+using Quality = HtmlToVstPluginAudioProcessor::Quality;
+
+static const char* getQualityName (Quality q)
+{
+    switch (q)
+    {
+        case Quality::automatic: return "auto";
+        case Quality::eco:       return "eco";
+        case Quality::realtime:  return "realtime";
+        case Quality::best:      return "best";
+    }
+
+    return "unknown";
+}
+
+struct Config
+{
+    double sampleRate;
+    int blockSize;
+    int numChannels;
+    const Scenario* scenario;
+    HtmlToVstPluginAudioProcessor::DspPath path;
+    Precision precision;
+    Quality quality = Quality::automatic;
+    bool offline = false;       // what the host reports through isNonRealtime()
+    int dspWorkers = 0;
+    bool forceSplit = false;    // skip the split gate
+};
+
+struct Result
+{
+    Config config;
+    double nsPerSample   = 0.0;   // per sample frame (all channels)
+    double realtimeFactor = 0.0;  // audio time / processing time
+    double p50Us = 0.0, p90Us = 0.0, p99Us = 0.0, maxUs = 0.0;
+    int latencySamples = 0;
+    double tailSeconds = 0.0;
+    std::uint64_t skippedBlocks = 0;
+    htmltovst::CpuTelemetry::Summary telemetry;
+    Quality activeQuality = Quality::realtime;
+    bool splitting = false;     // the tape stage ran on the workers at the end
+};
+
+static const char* getPathName (HtmlToVstPluginAudioProcessor::DspPath path)
+{
+    switch (path)
+    {
+        case HtmlToVstPluginAudioProcessor::DspPath::fused:     return "fused";
+        case HtmlToVstPluginAudioProcessor::DspPath::reference: return "reference";
+        case HtmlToVstPluginAudioProcessor::DspPath::graph:     return "graph";
+    }
+
+    return "unknown";
+}
+
+static void setParam (HtmlToVstPluginAudioProcessor& proc, const char* id, float value)
+{
+    if (auto* p = proc.apvts.getParameter (id))
+        p->setValueNotifyingHost (p->convertTo0to1 (value));
+}
+
+static void automateParam (HtmlToVstPluginAudioProcessor& proc, const char* id, float value)
+{
+    // Hosts deliver automation by calling setValue() on the audio thread.
+    if (auto* p = proc.apvts.getParameter (id))
+        p->setValue (p->convertTo0to1 (value));
+}
+
+static void fillNoise (juce::AudioBuffer<float>& buffer, juce::Random& rng)
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        auto* d = buffer.getWritePointer (ch);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            d[i] = 0.5f * (rng.nextFloat() * 2.0f - 1.0f);
+    }
+}
+
+static juce::AudioChannelSet getLayout (int numChannels)
+{
+    switch (numChannels)
+    {
+        case 1:  return juce::AudioChannelSet::mono();
+        case 2:  return juce::AudioChannelSet::stereo();
+        case 6:  return juce::AudioChannelSet::create5point1();
+        case 12: return juce::AudioChannelSet::create7point1point4();
+        default: return juce::AudioChannelSet::discreteChannels (numChannels);
+    }
+}
+
+static bool configureLayout (HtmlToVstPluginAudioProcessor& proc, int numChannels)
+{
+    const auto set = getLayout (numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add (set);
+    layout.outputBuses.add (set);
+    return proc.setBusesLayout (layout);
+}
+
+static double percentile (const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    const auto idx = (size_t) juce::jlimit (0.0, (double) (sorted.size() - 1), std::ceil (p * (double) sorted.size()) - 1.0);
+    return sorted[idx];
+}
+
+static Result runConfig (const Config& c, double secondsOfAudio)
+{
+    HtmlToVstPluginAudioProcessor proc;
+    configureLayout (proc, c.numChannels);
+    proc.setDspPath (c.path);
+
+    if (c.precision == Precision::native64)
+        proc.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+
+    proc.setSilenceBypassEnabled (c.scenario->allowBypass);
+
+    const auto& s = *c.scenario;
+    setParam (proc, "inGain",   s.inGainDb);
+    setParam (proc, "drive",    s.drive);
+    setParam (proc, "outGain",  s.outGainDb);
+    setParam (proc, "osFactor", (float) s.osFactorIndex);
+    setParam (proc, "osMode",   (float) s.osModeIndex);
+    setParam (proc, "quality",  (float) (int) c.quality);
+    proc.setNonRealtime (c.offline);
+    proc.setNumDspWorkers (c.dspWorkers);
+    proc.setDspSplitForced (c.forceSplit);
+
+    proc.setRateAndBufferSizeDetails (c.sampleRate, c.blockSize);
+    proc.prepareToPlay (c.sampleRate, c.blockSize);
+
+    // One second of noise, replayed block by block (copied outside the timed region)
+    juce::Random rng (0x5eed);
+    juce::AudioBuffer<float> source (c.numChannels, (int) c.sampleRate);
+    source.clear();
+
+    if (! s.silent)
+        fillNoise (source, rng);
+
+    juce::AudioBuffer<float> buffer (c.numChannels, c.blockSize);
+    juce::AudioBuffer<double> hostBuffer (c.numChannels, c.blockSize);   // the 64-bit modes' host buffer
+    juce::MidiBuffer midi;
+
+    const auto numBlocks = juce::jmax (1, (int) (secondsOfAudio * c.sampleRate / c.blockSize));
+    const auto warmupBlocks = juce::jmax (8, numBlocks / 20);
+
+    std::vector<double> blockNs;
+    blockNs.reserve ((size_t) numBlocks);
+
+    const auto tickToNs = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    int sourcePos = 0;
+    double totalNs = 0.0;
+
+    htmltovst::CpuTelemetry::Snapshot telemetryStart;
+
+    for (int b = -warmupBlocks; b < numBlocks; ++b)
+    {
+        if (b == 0)
+            telemetryStart = proc.getCpuTelemetry().getSnapshot();
+
+        if (sourcePos + c.blockSize > source.getNumSamples())
+            sourcePos = 0;
+
+        for (int ch = 0; ch < c.numChannels; ++ch)
+            buffer.copyFrom (ch, 0, source, ch, sourcePos, c.blockSize);
+
+        sourcePos += c.blockSize;
+
+        if (c.precision != Precision::single)
+            hostBuffer.makeCopyOf (buffer, true);
+
+        const auto t0 = juce::Time::getHighResolutionTicks();
+
+        if (s.automate)
+        {
+            // ~0.5 Hz LFO sweeping all three gains
+            const auto phase = (float) std::sin (juce::MathConstants<double>::twoPi * 0.5 * (b * c.blockSize) / c.sampleRate);
+            automateParam (proc, "inGain",  12.0f * phase);
+            automateParam (proc, "drive",   0.5f + 0.5f * phase);
+            automateParam (proc, "outGain", -12.0f * phase);
+        }
+
+        switch (c.precision)
+        {
+            case Precision::single:
+                proc.processBlock (buffer, midi);
+                break;
+
+            case Precision::native64:
+                proc.processBlock (hostBuffer, midi);
+                break;
+
+            case Precision::converted64:
+                buffer.makeCopyOf (hostBuffer, true);
+                proc.processBlock (buffer, midi);
+                hostBuffer.makeCopyOf (buffer, true);
+                break;
+        }
+
+        const auto t1 = juce::Time::getHighResolutionTicks();
+
+        if (b >= 0)
+        {
+            const auto ns = (double) (t1 - t0) * tickToNs;
+            blockNs.push_back (ns);
+            totalNs += ns;
+        }
+    }
+
+    proc.releaseResources();
+
+    Result r;
+    r.config = c;
+    r.latencySamples = proc.getLatencySamples();
+    r.tailSeconds = proc.getTailLengthSeconds();
+    r.skippedBlocks = proc.getNumSkippedBlocks();
+    r.activeQuality = proc.getActiveQuality();
+    r.splitting = proc.isSplittingDsp();
+    r.telemetry = htmltovst::CpuTelemetry::summarise (proc.getCpuTelemetry().getSnapshot(), telemetryStart);
+
+    const auto totalSamples = (double) numBlocks * c.blockSize;
+    r.nsPerSample = totalNs / totalSamples;
+    r.realtimeFactor = totalNs > 0.0 ? (totalSamples / c.sampleRate * 1.0e9) / totalNs : 0.0;
+
+    std::sort (blockNs.begin(), blockNs.end());
+    r.p50Us = percentile (blockNs, 0.50) * 1.0e-3;
+    r.p90Us = percentile (blockNs, 0.90) * 1.0e-3;
+    r.p99Us = percentile (blockNs, 0.99) * 1.0e-3;
+    r.maxUs = blockNs.empty() ? 0.0 : blockNs.back() * 1.0e-3;
+    return r;
+}
+
+//==============================================================================
+static juce::var toVar (const Result& r)
+{
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("scenario",       r.config.scenario->name);
+    obj->setProperty ("path",           getPathName (r.config.path));
+    obj->setProperty ("precision",      getPrecisionName (r.config.precision));
+    obj->setProperty ("sampleRate",     r.config.sampleRate);
+    obj->setProperty ("blockSize",      r.config.blockSize);
+    obj->setProperty ("channels",       r.config.numChannels);
+    obj->setProperty ("latency",        r.latencySamples);
+    obj->setProperty ("tailSeconds",    r.tailSeconds);
+    obj->setProperty ("skippedBlocks",  (juce::int64) r.skippedBlocks);
+    obj->setProperty ("nsPerSample",    r.nsPerSample);
+    obj->setProperty ("realtimeFactor", r.realtimeFactor);
+    obj->setProperty ("p50Us",          r.p50Us);
+    obj->setProperty ("p90Us",          r.p90Us);
+    obj->setProperty ("p99Us",          r.p99Us);
+    obj->setProperty ("maxUs",          r.maxUs);
+    obj->setProperty ("telemetryMeanUs",      r.telemetry.meanUs);
+    obj->setProperty ("telemetryP99Load",     r.telemetry.p99Load);
+    obj->setProperty ("telemetryOverheadPct", 100.0 * r.telemetry.overhead);
+    return juce::var (obj.release());
+}
+
+static juce::String toCsv (const std::vector<Result>& results)
+{
+    juce::String csv ("scenario,path,precision,sampleRate,blockSize,channels,latency,tailSeconds,skippedBlocks,nsPerSample,realtimeFactor,p50Us,p90Us,p99Us,maxUs,telemetryMeanUs,telemetryP99Load,telemetryOverheadPct\n");
+
+    for (const auto& r : results)
+    {
+        csv << r.config.scenario->name << ',' << getPathName (r.config.path) << ','
+            << getPrecisionName (r.config.precision) << ','
+            << r.config.sampleRate << ',' << r.config.blockSize << ',' << r.config.numChannels << ','
+            << r.latencySamples << ',' << r.tailSeconds << ',' << (juce::int64) r.skippedBlocks << ','
+            << r.nsPerSample << ',' << r.realtimeFactor << ','
+            << r.p50Us << ',' << r.p90Us << ',' << r.p99Us << ',' << r.maxUs << ','
+            << r.telemetry.meanUs << ',' << r.telemetry.p99Load << ',' << 100.0 * r.telemetry.overhead << '\n';
+    }
+
+    return csv;
+}
+
+/** Mean ns/sample of the fused path per precision, over every config that ran it. */
+static double getMeanNsPerSample (const std::vector<Result>& results, Precision precision)
+{
+    double sum = 0.0;
+    int count = 0;
+
+    for (const auto& r : results)
+    {
+        if (r.config.precision == precision && r.config.path == HtmlToVstPluginAudioProcessor::DspPath::fused)
+        {
+            sum += r.nsPerSample;
+            ++count;
+        }
+    }
+
+    return count > 0 ? sum / count : 0.0;
+}
+
+static juce::var getPrecisionSummary (const std::vector<Result>& results)
+{
+    auto obj = std::make_unique<juce::DynamicObject>();
+
+    for (auto p : precisions)
+        obj->setProperty (getPrecisionName (p), getMeanNsPerSample (results, p));
+
+    // Which way a 64-bit host should run this plug-in on this machine (for speed: the tape
+    // stages compute in float in both modes)
+    const auto native    = getMeanNsPerSample (results, Precision::native64);
+    const auto converted = getMeanNsPerSample (results, Precision::converted64);
+
+    if (native > 0.0 && converted > 0.0)
+        obj->setProperty ("preferred64", getPrecisionName (native <= converted ? Precision::native64 : Precision::converted64));
+
+    return juce::var (obj.release());
+}
+
+/** One 7.1.4 instance against six stereo instances, over every fused float config that ran both. */
+static juce::var getSurroundSummary (const std::vector<Result>& results)
+{
+    double surroundNs = 0.0, stereoNs = 0.0;
+    int count = 0;
+
+    for (const auto& r : results)
+    {
+        if (r.config.numChannels != 12 || r.config.path != HtmlToVstPluginAudioProcessor::DspPath::fused
+             || r.config.precision != Precision::single)
+            continue;
+
+        for (const auto& s : results)
+        {
+            if (s.config.numChannels == 2 && s.config.scenario == r.config.scenario && s.config.path == r.config.path
+                 && s.config.precision == r.config.precision && s.config.sampleRate == r.config.sampleRate
+                 && s.config.blockSize == r.config.blockSize)
+            {
+                surroundNs += r.nsPerSample;
+                stereoNs += 6.0 * s.nsPerSample;
+                ++count;
+                break;
+            }
+        }
+    }
+
+    if (count == 0)
+        return {};
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("layout", "7.1.4");
+    obj->setProperty ("oneInstanceNsPerSample", surroundNs / count);
+    obj->setProperty ("sixStereoNsPerSample",   stereoNs / count);
+    obj->setProperty ("ratio",                  surroundNs / stereoNs);
+    return juce::var (obj.release());
+}
+
+/** ns per sample frame for TapeEq record + playback alone. With fading set, the curve
+    flips between NAB and IEC every block, so it is crossfading most of the time.
+*/
+static double timeTapeEq (const Config& c, double secondsOfAudio, bool fading)
+{
+    using htmltovst::TapeEq;
+
+    TapeEq eq;
+    eq.prepare (std::make_shared<const TapeEq::Bank> (TapeEq::makeBank (c.sampleRate)), c.sampleRate);
+    eq.select (TapeEq::Standard::nab, 1);
+
+    juce::AudioBuffer<float> buffer (c.numChannels, c.blockSize);
+    juce::Random rng (1);
+    fillNoise (buffer, rng);
+
+    const auto numBlocks = juce::jmax (1, (int) (secondsOfAudio * c.sampleRate / c.blockSize));
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        if (fading)
+            eq.select ((b & 1) != 0 ? TapeEq::Standard::iec : TapeEq::Standard::nab, 1);
+
+        eq.processRecord (buffer.getArrayOfWritePointers(), c.numChannels, c.blockSize);
+        eq.processPlayback (buffer.getArrayOfWritePointers(), c.numChannels, c.blockSize);
+    }
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+    return seconds * 1.0e9 / ((double) numBlocks * c.blockSize);
+}
+
+/** TapeEq cost against every fused float "static" config that ran (the full tape chain). */
+static juce::var getEqSummary (const std::vector<Result>& results, double secondsOfAudio)
+{
+    juce::Array<juce::var> rows;
+    double maxShare = 0.0, maxFadingShare = 0.0;
+
+    for (const auto& r : results)
+    {
+        if (std::strcmp (r.config.scenario->name, "static") != 0 || r.config.precision != Precision::single
+             || r.config.path != HtmlToVstPluginAudioProcessor::DspPath::fused || r.nsPerSample <= 0.0)
+            continue;
+
+        const auto steadyNs = timeTapeEq (r.config, secondsOfAudio, false);
+        const auto fadingNs = timeTapeEq (r.config, secondsOfAudio, true);
+
+        maxShare       = juce::jmax (maxShare,       steadyNs / r.nsPerSample);
+        maxFadingShare = juce::jmax (maxFadingShare, fadingNs / r.nsPerSample);
+
+        auto row = std::make_unique<juce::DynamicObject>();
+        row->setProperty ("sampleRate",         r.config.sampleRate);
+        row->setProperty ("blockSize",          r.config.blockSize);
+        row->setProperty ("channels",           r.config.numChannels);
+        row->setProperty ("steadyNsPerSample",  steadyNs);
+        row->setProperty ("fadingNsPerSample",  fadingNs);
+        row->setProperty ("chainNsPerSample",   r.nsPerSample);
+        row->setProperty ("share",              steadyNs / r.nsPerSample);
+        row->setProperty ("fadingShare",        fadingNs / r.nsPerSample);
+        rows.add (juce::var (row.release()));
+    }
+
+    if (rows.isEmpty())
+        return {};
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("maxShare",       maxShare);
+    obj->setProperty ("maxFadingShare", maxFadingShare);
+    obj->setProperty ("configs",        rows);
+    return juce::var (obj.release());
+}
+
+/** ns per sample frame for the Convolver alone, with the longest IR (mono head and transformer).
+    With fading set, the transformer toggles every block, so it is crossfading most of the time.
+*/
+static double timeConvolver (const Config& c, double secondsOfAudio, bool fading)
+{
+    using htmltovst::Convolver;
+
+    Convolver convolver;
+    convolver.prepare (std::make_shared<const Convolver::Bank> (Convolver::makeBank (c.sampleRate)), c.sampleRate, c.numChannels);
+    convolver.select (Convolver::getIrIndex (Convolver::Headblock::mono, true));
+
+    juce::AudioBuffer<float> buffer (c.numChannels, c.blockSize);
+    juce::Random rng (1);
+    fillNoise (buffer, rng);
+
+    const auto numBlocks = juce::jmax (1, (int) (secondsOfAudio * c.sampleRate / c.blockSize));
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        if (fading)
+            convolver.select (Convolver::getIrIndex (Convolver::Headblock::mono, (b & 1) == 0));
+
+        convolver.process (buffer.getArrayOfWritePointers(), c.numChannels, c.blockSize);
+    }
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+    return seconds * 1.0e9 / ((double) numBlocks * c.blockSize);
+}
+
+/** Convolver cost against every fused float "static" config that ran, as for getEqSummary(). */
+static juce::var getConvolverSummary (const std::vector<Result>& results, double secondsOfAudio)
+{
+    juce::Array<juce::var> rows;
+    double maxShare = 0.0, maxFadingShare = 0.0;
+
+    for (const auto& r : results)
+    {
+        if (std::strcmp (r.config.scenario->name, "static") != 0 || r.config.precision != Precision::single
+             || r.config.path != HtmlToVstPluginAudioProcessor::DspPath::fused || r.nsPerSample <= 0.0)
+            continue;
+
+        const auto steadyNs = timeConvolver (r.config, secondsOfAudio, false);
+        const auto fadingNs = timeConvolver (r.config, secondsOfAudio, true);
+
+        maxShare       = juce::jmax (maxShare,       steadyNs / r.nsPerSample);
+        maxFadingShare = juce::jmax (maxFadingShare, fadingNs / r.nsPerSample);
+
+        auto row = std::make_unique<juce::DynamicObject>();
+        row->setProperty ("sampleRate",         r.config.sampleRate);
+        row->setProperty ("blockSize",          r.config.blockSize);
+        row->setProperty ("channels",           r.config.numChannels);
+        row->setProperty ("steadyNsPerSample",  steadyNs);
+        row->setProperty ("fadingNsPerSample",  fadingNs);
+        row->setProperty ("chainNsPerSample",   r.nsPerSample);
+        row->setProperty ("share",              steadyNs / r.nsPerSample);
+        row->setProperty ("fadingShare",        fadingNs / r.nsPerSample);
+        rows.add (juce::var (row.release()));
+    }
+
+    if (rows.isEmpty())
+        return {};
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("maxShare",       maxShare);
+    obj->setProperty ("maxFadingShare", maxFadingShare);
+    obj->setProperty ("configs",        rows);
+    return juce::var (obj.release());
+}
+
+/** Graph schedule cost over every config that ran it: mean and worst ns per sample frame. */
+static juce::var getGraphSummary (const std::vector<Result>& results)
+{
+    double sum = 0.0, maxNs = 0.0;
+    int count = 0;
+
+    for (const auto& r : results)
+    {
+        if (r.config.path != HtmlToVstPluginAudioProcessor::DspPath::graph || r.nsPerSample <= 0.0)
+            continue;
+
+        sum += r.nsPerSample;
+        maxNs = juce::jmax (maxNs, r.nsPerSample);
+        ++count;
+    }
+
+    if (count == 0)
+        return {};
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("configs",         count);
+    obj->setProperty ("meanNsPerSample", sum / count);
+    obj->setProperty ("maxNsPerSample",  maxNs);
+    return juce::var (obj.release());
+}
+
+/** prepareToPlay time of the first instance in the process against the mean of the rest. */
+static juce::var getPrepareSummary (int numInstances)
+{
+    std::vector<std::unique_ptr<HtmlToVstPluginAudioProcessor>> procs;
+    std::vector<double> ms;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        procs.push_back (std::make_unique<HtmlToVstPluginAudioProcessor>());
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        procs.back()->prepareToPlay (48000.0, 512);
+        ms.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e3);
+    }
+
+    double rest = 0.0;
+    for (size_t i = 1; i < ms.size(); ++i)
+        rest += ms[i];
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("instances", numInstances);
+    obj->setProperty ("firstMs",   ms.front());
+    obj->setProperty ("restMeanMs", ms.size() > 1 ? rest / (double) (ms.size() - 1) : 0.0);
+    obj->setProperty ("lastMs",    ms.back());
+    return juce::var (obj.release());
+}
+
+/** Saves every instance, then restores each blob into the next instance along, once
+    through the binary state and once through the legacy XML it replaced.
+*/
+static juce::var getStateSummary (int numInstances)
+{
+    const auto n = (size_t) numInstances;
+    std::vector<std::unique_ptr<HtmlToVstPluginAudioProcessor>> procs;
+    juce::Random rng (1);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        procs.push_back (std::make_unique<HtmlToVstPluginAudioProcessor>());
+
+        for (size_t p = 0; p < kNumHtmlToVstParams; ++p)
+            procs.back()->getParameterByIndex ((int) p)->setValueNotifyingHost (rng.nextFloat());
+    }
+
+    std::vector<juce::MemoryBlock> binary (n), legacy (n), check (n);
+
+    auto usPerInstance = [n] (auto&& fn)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (size_t i = 0; i < n; ++i)
+            fn (i);
+
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e6 / (double) n;
+    };
+
+    const auto binarySaveUs = usPerInstance ([&] (size_t i) { procs[i]->getStateInformation (binary[i]); });
+
+    const auto legacySaveUs = usPerInstance ([&] (size_t i)
+    {
+        if (auto xml = procs[i]->apvts.copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary (*xml, legacy[i]);
+    });
+
+    const auto binaryLoadUs = usPerInstance ([&] (size_t i)
+    {
+        procs[(i + 1) % n]->setStateInformation (binary[i].getData(), (int) binary[i].getSize());
+    });
+
+    // Each instance now holds its predecessor's state and must save the same bytes
+    bool roundTrip = true;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        procs[(i + 1) % n]->getStateInformation (check[i]);
+        roundTrip = roundTrip && check[i] == binary[i];
+    }
+
+    const auto legacyLoadUs = usPerInstance ([&] (size_t i)
+    {
+        procs[(i + 1) % n]->setStateInformation (legacy[i].getData(), (int) legacy[i].getSize());
+    });
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("instances",      numInstances);
+    obj->setProperty ("binarySaveUs",   binarySaveUs);
+    obj->setProperty ("binaryLoadUs",   binaryLoadUs);
+    obj->setProperty ("binaryBytes",    (int) binary.front().getSize());
+    obj->setProperty ("legacySaveUs",   legacySaveUs);
+    obj->setProperty ("legacyLoadUs",   legacyLoadUs);
+    obj->setProperty ("legacyBytes",    (int) legacy.front().getSize());
+    obj->setProperty ("binaryRoundTrip", roundTrip);
+    return juce::var (obj.release());
+}
+
+/** Telemetry overhead across every config: the mean, the worst, and how many went over 1%. */
+static juce::var getTelemetrySummary (const std::vector<Result>& results)
+{
+    double sum = 0.0, worst = 0.0;
+    int count = 0, over = 0;
+
+    for (const auto& r : results)
+    {
+        if (r.telemetry.blocks == 0)
+            continue;
+
+        sum += r.telemetry.overhead;
+        worst = juce::jmax (worst, r.telemetry.overhead);
+        over += r.telemetry.overhead > 0.01 ? 1 : 0;
+        ++count;
+    }
+
+    if (count == 0)
+        return {};
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("configs",         count);
+    obj->setProperty ("meanOverheadPct", 100.0 * sum / count);
+    obj->setProperty ("maxOverheadPct",  100.0 * worst);
+    obj->setProperty ("configsOver1Pct", over);
+    return juce::var (obj.release());
+}
+
+/** Each quality profile on the same config, per sample rate, against Realtime. */
+static juce::var getQualitySummary (const std::vector<double>& sampleRates, double secondsOfAudio)
+{
+    using DspPath = HtmlToVstPluginAudioProcessor::DspPath;
+
+    struct Profile
+    {
+        Quality quality;
+        bool offline;
+        const char* name;
+    };
+
+    static const Profile profiles[] =
+    {
+        { Quality::eco,       false, "eco" },
+        { Quality::realtime,  false, "realtime" },
+        { Quality::best,      false, "best" },
+        { Quality::automatic, true,  "auto_offline" },
+    };
+
+    const auto* scenario = std::find_if (std::begin (scenarios), std::end (scenarios),
+                                         [] (const Scenario& s) { return std::strcmp (s.name, "os4x_iir") == 0; });
+
+    juce::Array<juce::var> rows;
+
+    for (auto sr : sampleRates)
+    {
+        std::vector<Result> runs;
+
+        for (const auto& p : profiles)
+            runs.push_back (runConfig ({ sr, 512, 2, scenario, DspPath::fused, Precision::single, p.quality, p.offline }, secondsOfAudio));
+
+        const auto realtimeNs = runs[1].nsPerSample;     // profiles[1]
+
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            const auto& r = runs[i];
+            const auto ratio = realtimeNs > 0.0 ? r.nsPerSample / realtimeNs : 0.0;
+
+            auto row = std::make_unique<juce::DynamicObject>();
+            row->setProperty ("profile",        profiles[i].name);
+            row->setProperty ("active",         getQualityName (r.activeQuality));
+            row->setProperty ("sampleRate",     sr);
+            row->setProperty ("nsPerSample",    r.nsPerSample);
+            row->setProperty ("realtimeFactor", r.realtimeFactor);
+            row->setProperty ("p99Us",          r.p99Us);
+            row->setProperty ("latency",        r.latencySamples);
+            row->setProperty ("costVsRealtime", ratio);
+            rows.add (juce::var (row.release()));
+
+            std::fprintf (stderr, "quality %-12s (%-8s) %6.0f Hz  %8.2f ns/smp  %8.1fx RT  latency %4d  %.2fx realtime\n",
+                          profiles[i].name, getQualityName (r.activeQuality), sr, r.nsPerSample, r.realtimeFactor,
+                          r.latencySamples, ratio);
+        }
+    }
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("scenario",  scenario->name);
+    obj->setProperty ("blockSize", 512);
+    obj->setProperty ("channels",  2);
+    obj->setProperty ("configs",   rows);
+    return juce::var (obj.release());
+}
+
+/** Worker-thread scaling against one thread, per layout and block size. */
+static juce::var getThreadingSummary (const std::vector<int>& blockSizes, const std::vector<int>& channelCounts, double secondsOfAudio)
+{
+    using DspPath = HtmlToVstPluginAudioProcessor::DspPath;
+
+    const auto* scenario = std::find_if (std::begin (scenarios), std::end (scenarios),
+                                         [] (const Scenario& s) { return std::strcmp (s.name, "os4x_iir") == 0; });
+
+    std::vector<int> workerCounts;
+
+    for (auto n : { 1, 3, 7 })
+        if (n < juce::SystemStats::getNumCpus())
+            workerCounts.push_back (n);
+
+    if (workerCounts.empty())
+        workerCounts.push_back (1);
+
+    juce::Array<juce::var> rows;
+    double bestSpeedup = 0.0;
+
+    for (auto nc : channelCounts)
+    {
+        for (auto bs : blockSizes)
+        {
+            const Config single { 48000.0, bs, nc, scenario, DspPath::fused, Precision::single, Quality::best };
+            const auto base = runConfig (single, secondsOfAudio);
+
+            auto addRow = [&] (const Result& r, const char* mode)
+            {
+                const auto speedup = r.nsPerSample > 0.0 ? base.nsPerSample / r.nsPerSample : 0.0;
+
+                auto row = std::make_unique<juce::DynamicObject>();
+                row->setProperty ("channels",    nc);
+                row->setProperty ("blockSize",   bs);
+                row->setProperty ("workers",     r.config.dspWorkers);
+                row->setProperty ("mode",        mode);
+                row->setProperty ("split",       r.splitting);
+                row->setProperty ("nsPerSample", r.nsPerSample);
+                row->setProperty ("p99Us",       r.p99Us);
+                row->setProperty ("speedup",     speedup);
+                rows.add (juce::var (row.release()));
+
+                std::fprintf (stderr, "threads %2d ch %5d smp  %d workers %-6s %-5s  %8.2f ns/smp  p99 %8.2f us  %.2fx one thread\n",
+                              nc, bs, r.config.dspWorkers, mode, r.splitting ? "split" : "one", r.nsPerSample, r.p99Us, speedup);
+                return speedup;
+            };
+
+            addRow (base, "single");
+
+            for (auto w : workerCounts)
+            {
+                auto forced = single;
+                forced.dspWorkers = w;
+                forced.forceSplit = true;
+                bestSpeedup = juce::jmax (bestSpeedup, addRow (runConfig (forced, secondsOfAudio), "forced"));
+            }
+
+            auto gated = single;
+            gated.dspWorkers = workerCounts.back();
+            addRow (runConfig (gated, secondsOfAudio), "gated");
+        }
+    }
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("scenario",    scenario->name);
+    obj->setProperty ("quality",     getQualityName (Quality::best));
+    obj->setProperty ("cpus",        juce::SystemStats::getNumCpus());
+    obj->setProperty ("bestSpeedup", bestSpeedup);
+    obj->setProperty ("configs",     rows);
+    return juce::var (obj.release());
+}
+
+/** A show's preset changes: cost of the recall on the message thread, and of the blocks that
+    crossfade against steady ones, switching through the factory bank every recallBlocks.
+*/
+static juce::var getPresetSummary (double sampleRate, int blockSize, double secondsOfAudio)
+{
+    constexpr int numChannels = 2;
+    constexpr int recallBlocks = 50;
+
+    HtmlToVstPluginAudioProcessor proc;
+    configureLayout (proc, numChannels);
+    setParam (proc, "quality", (float) (int) Quality::realtime);
+    proc.setRateAndBufferSizeDetails (sampleRate, blockSize);
+    proc.prepareToPlay (sampleRate, blockSize);
+
+    juce::Random rng (0x5eed);
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    const auto numBlocks = juce::jmax (recallBlocks, (int) (secondsOfAudio * sampleRate / blockSize));
+    const auto numFactory = proc.getPresetBank().getNumFactoryPresets();
+    const auto tickToUs = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+
+    std::vector<double> steadyUs, fadingUs, recallUs;
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        if (b % recallBlocks == 0)
+        {
+            const auto t0 = juce::Time::getHighResolutionTicks();
+            proc.setCurrentProgram ((b / recallBlocks) % numFactory);
+            recallUs.push_back ((double) (juce::Time::getHighResolutionTicks() - t0) * tickToUs);
+        }
+
+        fillNoise (buffer, rng);
+
+        const auto t0 = juce::Time::getHighResolutionTicks();
+        proc.processBlock (buffer, midi);
+        const auto us = (double) (juce::Time::getHighResolutionTicks() - t0) * tickToUs;
+
+        // The first blocks after preparing warm up, and don't count
+        if (b >= recallBlocks)
+            (proc.isPresetFading() ? fadingUs : steadyUs).push_back (us);
+    }
+
+    proc.releaseResources();
+
+    auto mean = [] (const std::vector<double>& v)
+    {
+        return v.empty() ? 0.0 : std::accumulate (v.begin(), v.end(), 0.0) / (double) v.size();
+    };
+
+    std::sort (fadingUs.begin(), fadingUs.end());
+    std::sort (recallUs.begin(), recallUs.end());
+
+    const auto steady = mean (steadyUs);
+    const auto fading = mean (fadingUs);
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("sampleRate",      sampleRate);
+    obj->setProperty ("blockSize",       blockSize);
+    obj->setProperty ("channels",        numChannels);
+    obj->setProperty ("recalls",         (int) recallUs.size());
+    obj->setProperty ("fadeMs",          HtmlToVstPluginAudioProcessor::kPresetFadeSeconds * 1000.0);
+    obj->setProperty ("fadingBlocks",    (int) fadingUs.size());
+    obj->setProperty ("steadyUs",        steady);
+    obj->setProperty ("fadingUs",        fading);
+    obj->setProperty ("fadingP99Us",     percentile (fadingUs, 0.99));
+    obj->setProperty ("fadingCostRatio", steady > 0.0 ? fading / steady : 0.0);
+    obj->setProperty ("recallUs",        mean (recallUs));
+    obj->setProperty ("recallMaxUs",     recallUs.empty() ? 0.0 : recallUs.back());
+    return juce::var (obj.release());
+}
+
+/** ns per sample frame against the host's block size, with micro-blocks and without. The
+    irregular row calls with random sizes up to the largest the host prepared for.
+*/
+static juce::var getBlockSizeSummary (double sampleRate, double secondsOfAudio)
+{
+    constexpr int numChannels = 2;
+    constexpr int maxIrregular = 512;
+
+    const auto* scenario = std::find_if (std::begin (scenarios), std::end (scenarios),
+                                         [] (const Scenario& s) { return std::strcmp (s.name, "drive") == 0; });
+
+    auto measure = [&] (int blockSize, bool irregular, bool microBlocks)
+    {
+        HtmlToVstPluginAudioProcessor proc;
+        configureLayout (proc, numChannels);
+        proc.setMicroBlocksEnabled (microBlocks);
+        setParam (proc, "inGain",  scenario->inGainDb);
+        setParam (proc, "drive",   scenario->drive);
+        setParam (proc, "outGain", scenario->outGainDb);
+        setParam (proc, "quality", (float) (int) Quality::realtime);
+        proc.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        proc.prepareToPlay (sampleRate, blockSize);
+
+        juce::Random rng (0x5eed);
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        const auto tickToNs = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+        const auto warmupSamples = juce::jmax (8 * blockSize, (int) (0.05 * sampleRate));
+        const auto numSamples = juce::jmax (8 * blockSize, (int) (secondsOfAudio * sampleRate));
+        double totalNs = 0.0;
+        juce::int64 timedSamples = 0;
+
+        for (int pos = -warmupSamples; pos < numSamples;)
+        {
+            const auto n = irregular ? 1 + rng.nextInt (blockSize) : blockSize;
+            juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), numChannels, n);
+            fillNoise (block, rng);
+
+            const auto t0 = juce::Time::getHighResolutionTicks();
+            proc.processBlock (block, midi);
+            const auto t1 = juce::Time::getHighResolutionTicks();
+
+            if (pos >= 0)
+            {
+                totalNs += (double) (t1 - t0) * tickToNs;
+                timedSamples += n;
+            }
+
+            pos += n;
+        }
+
+        proc.releaseResources();
+        return timedSamples > 0 ? totalNs / (double) timedSamples : 0.0;
+    };
+
+    juce::Array<juce::var> rows;
+    double minOn = 0.0, maxOn = 0.0, minOff = 0.0, maxOff = 0.0;
+
+    auto addRow = [&] (int blockSize, bool irregular)
+    {
+        const auto on  = measure (blockSize, irregular, true);
+        const auto off = measure (blockSize, irregular, false);
+
+        if (! irregular)
+        {
+            minOn  = rows.isEmpty() ? on  : juce::jmin (minOn, on);
+            maxOn  = juce::jmax (maxOn, on);
+            minOff = rows.isEmpty() ? off : juce::jmin (minOff, off);
+            maxOff = juce::jmax (maxOff, off);
+        }
+
+        auto row = std::make_unique<juce::DynamicObject>();
+        row->setProperty ("blockSize",                blockSize);
+        row->setProperty ("irregular",                irregular);
+        row->setProperty ("nsPerSample",              on);
+        row->setProperty ("nsPerSampleNoMicroBlocks", off);
+        rows.add (juce::var (row.release()));
+
+        std::fprintf (stderr, "block size %s%4d smp  %8.2f ns/smp  %8.2f ns/smp without micro-blocks\n",
+                      irregular ? "<=" : "  ", blockSize, on, off);
+    };
+
+    for (auto bs : { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 })
+        addRow (bs, false);
+
+    addRow (maxIrregular, true);
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("scenario",             scenario->name);
+    obj->setProperty ("sampleRate",           sampleRate);
+    obj->setProperty ("channels",             numChannels);
+    obj->setProperty ("microBlockSize",       htmltovst::MicroBlockScheduler::kBlockSize);
+    obj->setProperty ("spread",               minOn > 0.0 ? maxOn / minOn : 0.0);
+    obj->setProperty ("spreadNoMicroBlocks",  minOff > 0.0 ? maxOff / minOff : 0.0);
+    obj->setProperty ("configs",              rows);
+    return juce::var (obj.release());
+}
+
+/** The fused tanh kernel's documented bound (fastTanh, DriveKernel.h). Out gains stay at or
+    below unity in the null test, so it holds at the output too.
+*/
+static constexpr double kNullTolerance = 1.0e-4;
+
+/** Float buffers also carry the gain ramps' rounding: SmoothedValue accumulates its step
+    where the kernel multiplies it out, a few 1e-5 apart at most over a ramp.
+*/
+static constexpr double kNullFloatRounding = 5.0e-5;
+
+template <typename SampleType>
+static SampleType referenceTanh (SampleType x) { return std::tanh (x); }
+
+/** Largest |fused - reference| on the tanh engine, one kernel variant against the juce::dsp
+    chain (inGain -> driveGain -> std::tanh -> outGain), both fed the same noise, random block
+    sizes and the same gain automation: new targets mid-ramp, every other block or so.
+*/
+template <typename SampleType>
+static double getNullDifference (htmltovst::DriveKernel::Isa isa, double sampleRate, int numBlocks)
+{
+    constexpr int numChannels = 2, maxBlockSize = 512;
+    constexpr double rampSeconds = 0.01;
+
+    const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) maxBlockSize, (juce::uint32) numChannels };
+    juce::dsp::Gain<SampleType> inGain, driveGain, outGain;
+    juce::dsp::WaveShaper<SampleType> shaper;
+    shaper.functionToUse = referenceTanh<SampleType>;
+
+    htmltovst::GainRamp inRamp, driveRamp, outRamp;
+
+    auto setTargets = [&] (float in, float drive, float out, bool jump)
+    {
+        inGain.setGainLinear ((SampleType) in);
+        driveGain.setGainLinear ((SampleType) drive);
+        outGain.setGainLinear ((SampleType) out);
+
+        if (jump)
+        {
+            inRamp.setCurrentAndTarget (in);
+            driveRamp.setCurrentAndTarget (drive);
+            outRamp.setCurrentAndTarget (out);
+            return;
+        }
+
+        inRamp.setTarget (in);
+        driveRamp.setTarget (drive);
+        outRamp.setTarget (out);
+    };
+
+    for (auto* gain : { &inGain, &driveGain, &outGain })
+    {
+        gain->prepare (spec);
+        gain->setRampDurationSeconds (rampSeconds);
+    }
+
+    for (auto* ramp : { &inRamp, &driveRamp, &outRamp })
+        ramp->reset (sampleRate, rampSeconds);
+
+    setTargets (1.0f, 4.0f, 0.5f, true);
+
+    for (auto* gain : { &inGain, &driveGain, &outGain })
+        gain->reset();
+
+    const auto process = htmltovst::DriveKernel::getProcessFunction<SampleType> (isa);
+    juce::AudioBuffer<SampleType> fused (numChannels, maxBlockSize), reference (numChannels, maxBlockSize);
+    juce::Random rng (5);
+    double maxDiff = 0.0;
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        if (rng.nextBool())
+            setTargets (juce::Decibels::decibelsToGain (rng.nextFloat() * 24.0f - 12.0f),
+                        1.0f + rng.nextFloat() * 29.0f,
+                        0.1f + rng.nextFloat() * 0.9f,
+                        false);
+
+        const auto n = 1 + rng.nextInt (maxBlockSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < n; ++i)
+                fused.setSample (ch, i, (SampleType) (rng.nextFloat() - 0.5f));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            reference.copyFrom (ch, 0, fused, ch, 0, n);
+
+        process (fused.getArrayOfWritePointers(), numChannels, n, inRamp.getSegment(), driveRamp.getSegment(), outRamp.getSegment());
+        inRamp.skip (n);
+        driveRamp.skip (n);
+        outRamp.skip (n);
+
+        auto block = juce::dsp::AudioBlock<SampleType> (reference).getSubBlock (0, (size_t) n);
+        juce::dsp::ProcessContextReplacing<SampleType> ctx (block);
+        inGain.process (ctx);
+        driveGain.process (ctx);
+        shaper.process (ctx);
+        outGain.process (ctx);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < n; ++i)
+                maxDiff = juce::jmax (maxDiff, std::abs ((double) fused.getSample (ch, i) - (double) reference.getSample (ch, i)));
+    }
+
+    return maxDiff;
+}
+
+/** Null test of the fused path against the reference chain on the tanh engine, for every
+    kernel variant this CPU runs, in float and double. This build's own engine may be another
+    (the tape), so the two chains are driven directly rather than through the processor.
+*/
+static juce::var getNullSummary (double sampleRate, int numBlocks)
+{
+    using htmltovst::DriveKernel::Isa;
+
+    juce::Array<juce::var> rows;
+    double maxDiff = 0.0;
+    bool passed = true;
+
+    for (auto isa : { Isa::scalar, Isa::sse2, Isa::avx2, Isa::neon })
+    {
+        if (! htmltovst::DriveKernel::isSupported (isa))
+            continue;
+
+        for (auto useDouble : { false, true })
+        {
+            const auto diff = useDouble ? getNullDifference<double> (isa, sampleRate, numBlocks)
+                                        : getNullDifference<float>  (isa, sampleRate, numBlocks);
+            const auto tolerance = useDouble ? kNullTolerance : kNullTolerance + kNullFloatRounding;
+            maxDiff = juce::jmax (maxDiff, diff);
+            passed = passed && diff <= tolerance;
+
+            auto row = std::make_unique<juce::DynamicObject>();
+            row->setProperty ("isa",       htmltovst::DriveKernel::getIsaName (isa));
+            row->setProperty ("precision", useDouble ? "double" : "float");
+            row->setProperty ("maxDiff",   diff);
+            row->setProperty ("tolerance", tolerance);
+            rows.add (juce::var (row.release()));
+
+            std::fprintf (stderr, "null %-6s %-6s max |fused - reference| %.3g (tolerance %.2g) %s\n",
+                          htmltovst::DriveKernel::getIsaName (isa), useDouble ? "double" : "float", diff, tolerance,
+                          diff <= tolerance ? "ok" : "FAILED");
+        }
+    }
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("maxDiff",   maxDiff);
+    obj->setProperty ("passed",    passed);
+    obj->setProperty ("configs",   rows);
+    return juce::var (obj.release());
+}
+
+
+                            const juce::var& convolverSummary, const juce::var& stateSummary, const juce::var& prepareSummary,
+                            const juce::var& qualitySummary, const juce::var& threadingSummary,
+                            const juce::var& presetSummary, const juce::var& blockSizeSummary, const juce::var& nullSummary)
+{
+    auto root = std::make_unique<juce::DynamicObject>();
+    root->setProperty ("benchmark", "HtmlToVstProcessor");
+    root->setProperty ("isa", htmltovst::DriveKernel::getIsaName (htmltovst::DriveKernel::getBestIsa()));
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty ("precisionSummary", getPrecisionSummary (results));
+    root->setProperty ("surroundSummary", getSurroundSummary (results));
+    root->setProperty ("eqSummary", eqSummary);
+    root->setProperty ("convolverSummary", convolverSummary);
+    root->setProperty ("stateSummary", stateSummary);
+    root->setProperty ("prepareSummary", prepareSummary);
+    root->setProperty ("qualitySummary", qualitySummary);
+    root->setProperty ("threadingSummary", threadingSummary);
+    root->setProperty ("presetSummary", presetSummary);
+    root->setProperty ("blockSizeSummary", blockSizeSummary);
+    root->setProperty ("nullSummary", nullSummary);
+    root->setProperty ("graphSummary", getGraphSummary (results));
+    root->setProperty ("telemetrySummary", getTelemetrySummary (results));
+
+    juce::Array<juce::var> list;
+    for (const auto& r : results)
+        list.add (toVar (r));
+
+    root->setProperty ("results", list);
+    return juce::JSON::toString (juce::var (root.release()));
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    const bool quick = args.contains ("--quick");
+    const bool csv   = args.contains ("--csv");
+
+    double seconds = quick ? 0.25 : 2.0;
+    if (auto idx = args.indexOf ("--seconds"); idx >= 0 && idx + 1 < args.size())
+        seconds = juce::jmax (0.01, args[idx + 1].getDoubleValue());
+
+    std::vector<Precision> precisionModes (std::begin (precisions), std::end (precisions));
+    if (auto idx = args.indexOf ("--precision"); idx >= 0 && idx + 1 < args.size() && args[idx + 1] != "all")
+    {
+        precisionModes.clear();
+
+        for (auto p : precisions)
+            if (args[idx + 1] == getPrecisionName (p))
+                precisionModes.push_back (p);
+
+        if (precisionModes.empty())
+        {
+            std::fprintf (stderr, "unknown precision '%s'\n", args[idx + 1].toRawUTF8());
+            return 1;
+        }
+    }
+
+    juce::File outFile;
+    if (auto idx = args.indexOf ("--out"); idx >= 0 && idx + 1 < args.size())
+        outFile = juce::File::getCurrentWorkingDirectory().getChildFile (args[idx + 1]);
+
+    const std::vector<double> sampleRates = quick ? std::vector<double> { 48000.0 }
+                                                  : std::vector<double> { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const std::vector<int> blockSizes = quick ? std::vector<int> { 64, 512 }
+                                              : std::vector<int> { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+    const std::vector<int> channelCounts = quick ? std::vector<int> { 1, 2, 12 }
+                                                 : std::vector<int> { 1, 2, 6, 12, 16 };
+
+    // Cheap, and the rest isn't worth reading if it fails
+    const auto nullTest = getNullSummary (48000.0, quick ? 200 : 2000);
+    const auto nulled = (bool) nullTest["passed"];
+    std::fprintf (stderr, "null test: fused vs reference tanh chain, max difference %.3g %s\n",
+                  (double) nullTest["maxDiff"], nulled ? "ok" : "FAILED");
+
+    std::vector<Result> results;
+    const auto hasGraph = HtmlToVstPluginAudioProcessor().hasEngineGraph();
+
+    for (const auto& scenario : scenarios)
+        for (auto path : { HtmlToVstPluginAudioProcessor::DspPath::fused, HtmlToVstPluginAudioProcessor::DspPath::reference,
+                           HtmlToVstPluginAudioProcessor::DspPath::graph })
+        {
+            // Neither the reference chain nor the graph oversamples; only compare them where it means something.
+            if (path != HtmlToVstPluginAudioProcessor::DspPath::fused && scenario.osFactorIndex != 0)
+                continue;
+
+            if (path == HtmlToVstPluginAudioProcessor::DspPath::graph && ! hasGraph)
+                continue;
+
+            for (auto precision : precisionModes)
+                for (auto sr : sampleRates)
+                    for (auto bs : blockSizes)
+                        for (auto nc : channelCounts)
+                        {
+                            results.push_back (runConfig ({ sr, bs, nc, &scenario, path, precision }, seconds));
+
+                            const auto& r = results.back();
+                            std::fprintf (stderr, "%-17s %-9s %-16s %6.0f Hz %5d smp %2dch  %8.2f ns/smp  %8.1fx RT  p99 %8.2f us  skipped %llu\n",
+                                          scenario.name, getPathName (path), getPrecisionName (precision), sr, bs, nc,
+                                          r.nsPerSample, r.realtimeFactor, r.p99Us,
+                                          (unsigned long long) r.skippedBlocks);
+                        }
+        }
+
+    for (auto p : precisionModes)
+        std::fprintf (stderr, "fused %-16s mean %8.2f ns/smp\n", getPrecisionName (p), getMeanNsPerSample (results, p));
+
+    if (const auto surround = getSurroundSummary (results); surround.isObject())
+        std::fprintf (stderr, "7.1.4: one instance %.2f ns/smp vs six stereo %.2f ns/smp (%.2fx)\n",
+                      (double) surround["oneInstanceNsPerSample"], (double) surround["sixStereoNsPerSample"],
+                      (double) surround["ratio"]);
+
+    if (const auto graph = getGraphSummary (results); graph.isObject())
+        std::fprintf (stderr, "engine graph: %.2f ns/smp on average, %.2f at worst (%d configs)\n",
+                      (double) graph["meanNsPerSample"], (double) graph["maxNsPerSample"], (int) graph["configs"]);
+
+    if (const auto telemetry = getTelemetrySummary (results); telemetry.isObject())
+        std::fprintf (stderr, "cpu telemetry: measuring costs %.3f%% of the block on average, %.3f%% at worst (%d of %d configs over 1%%)\n",
+                      (double) telemetry["meanOverheadPct"], (double) telemetry["maxOverheadPct"],
+                      (int) telemetry["configsOver1Pct"], (int) telemetry["configs"]);
+
+    const auto eq = getEqSummary (results, seconds);
+
+    if (eq.isObject())
+        std::fprintf (stderr, "tape EQ: at most %.1f%% of the chain steady, %.1f%% while crossfading\n",
+                      100.0 * (double) eq["maxShare"], 100.0 * (double) eq["maxFadingShare"]);
+
+    const auto convolver = getConvolverSummary (results, seconds);
+
+    if (convolver.isObject())
+        std::fprintf (stderr, "convolver: at most %.1f%% of the chain steady, %.1f%% while crossfading\n",
+                      100.0 * (double) convolver["maxShare"], 100.0 * (double) convolver["maxFadingShare"]);
+
+    const auto state = getStateSummary (quick ? 100 : 300);
+    std::fprintf (stderr, "state x%d: binary save %.2f us load %.2f us (%d B, round trip %s), xml save %.2f us load %.2f us (%d B)\n",
+                  (int) state["instances"], (double) state["binarySaveUs"], (double) state["binaryLoadUs"],
+                  (int) state["binaryBytes"], (bool) state["binaryRoundTrip"] ? "ok" : "FAILED",
+                  (double) state["legacySaveUs"], (double) state["legacyLoadUs"], (int) state["legacyBytes"]);
+
+    const auto prepare = getPrepareSummary (quick ? 100 : 300);
+    std::fprintf (stderr, "prepare x%d: first %.2f ms, rest mean %.2f ms, last %.2f ms\n",
+                  (int) prepare["instances"], (double) prepare["firstMs"], (double) prepare["restMeanMs"],
+                  (double) prepare["lastMs"]);
+
+    const auto quality = getQualitySummary (sampleRates, seconds);
+    const auto threading = getThreadingSummary (blockSizes, quick ? std::vector<int> { 2, 12 } : std::vector<int> { 2, 6, 12, 16 }, seconds);
+
+    const auto presetSwitch = getPresetSummary (48000.0, 128, seconds);
+    std::fprintf (stderr, "presets: recall %.1f us (max %.1f), %d fading blocks %.2f us vs %.2f us steady (%.2fx, p99 %.2f us)\n",
+                  (double) presetSwitch["recallUs"], (double) presetSwitch["recallMaxUs"], (int) presetSwitch["fadingBlocks"],
+                  (double) presetSwitch["fadingUs"], (double) presetSwitch["steadyUs"], (double) presetSwitch["fadingCostRatio"],
+                  (double) presetSwitch["fadingP99Us"]);
+
+    const auto sizeSweep = getBlockSizeSummary (48000.0, seconds);
+    std::fprintf (stderr, "block sizes 16-4096: slowest/fastest per sample %.2fx with micro-blocks, %.2fx without\n",
+                  (double) sizeSweep["spread"], (double) sizeSweep["spreadNoMicroBlocks"]);
+
+    const auto text = csv ? toCsv (results) : toJson (results, eq, convolver, state, prepare, quality, threading, presetSwitch, sizeSweep, nullTest);
+
+    if (outFile != juce::File())
+        outFile.replaceWithText (text);
+    else
+        std::printf ("%s\n", text.toRawUTF8());
+
+    return nulled ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+// Headless real-time safety check.
+//
+// Built with HTMLTOVST_RT_CHECK=1 (see Source/RealtimeCheck.h): every processBlock runs
+// inside a ScopedRealtime, so any allocation, lock, sleep or I/O made under it is reported
+// with a stack trace. Each DSP path and precision is driven through mono, stereo and 7.1.4,
+// at small and large host blocks plus the odd block longer than prepared, the odd single
+// sample and runs of irregular sizes, with micro-blocks on and off and the meters running,
+// every parameter automated across its range (oversampling, EQ curve, tape type and quality
+// profile switch mid-stream, and the host's offline flag flips so the Auto profile follows
+// it), presets recalled and A/B flipped every few blocks so the crossfade runs on every path
+// and block shape, and stretches of silence for the gate.
+//
+// The fused path runs once more with the tape stage forced onto two worker threads; tasks
+// the workers take run checked too.
+//
+// Automation and recalls are applied between blocks, outside the checked scope: the processor
+// only reads the parameters' atomics and the preset handoff, and the host's side of setValue()
+// is JUCE's business.
+//
+// Exits 1 if anything was reported; the build runs it after linking (HTMLTOVST_RT_CHECK_ON_BUILD).
+//
+//   HtmlToVstRtCheck [--quick] [--abort]
+
+#include "../Source/PluginProcessor.h"
+#include "../Source/RealtimeCheck.h"
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+
+using DspPath = HtmlToVstPluginAudioProcessor::DspPath;
+
+static const char* getPathName (DspPath path)
+{
+    switch (path)
+    {
+        case DspPath::fused:     return "fused";
+        case DspPath::reference: return "reference";
+        case DspPath::graph:     return "graph";
+    }
+
+    return "unknown";
+}
+
+static juce::AudioChannelSet getLayout (int numChannels)
+{
+    switch (numChannels)
+    {
+        case 1:  return juce::AudioChannelSet::mono();
+        case 2:  return juce::AudioChannelSet::stereo();
+        case 12: return juce::AudioChannelSet::create7point1point4();
+        default: return juce::AudioChannelSet::discreteChannels (numChannels);
+    }
+}
+
+/** Moves every parameter along its own triangle wave, so choices step through all their options,
+    goes offline and back every 50 blocks, turns micro-blocks off and on every 70, and recalls a
+    preset or flips A/B every 30.
+*/
+static void automateAll (HtmlToVstPluginAudioProcessor& proc, int block)
+{
+    proc.setNonRealtime ((block / 50) % 2 == 1);
+    proc.setMicroBlocksEnabled ((block / 70) % 2 == 0);
+
+    if (block % 30 == 0)
+    {
+        if ((block / 30) % 4 == 3)
+            proc.selectCompareSlot (1 - proc.getCompareSlot());
+        else
+            proc.setCurrentProgram ((block / 30) % proc.getNumPrograms());
+    }
+
+    const auto& params = proc.getParameters();
+
+    for (int i = 0; i < params.size(); ++i)
+    {
+        const auto period = 24.0 + 7.0 * i;
+        const auto phase = std::fmod ((double) block / period, 1.0);
+        params.getUnchecked (i)->setValue ((float) (1.0 - std::abs (2.0 * phase - 1.0)));
+    }
+}
+
+template <typename SampleType>
+static void fillBlock (juce::AudioBuffer<SampleType>& buffer, int numSamples, bool silent, juce::Random& rng)
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        auto* d = buffer.getWritePointer (ch);
+
+        for (int i = 0; i < numSamples; ++i)
+            d[i] = silent ? SampleType (0) : (SampleType) (0.5f * (rng.nextFloat() * 2.0f - 1.0f));
+    }
+}
+
+template <typename SampleType>
+static void runBlocks (HtmlToVstPluginAudioProcessor& proc, int numChannels, int blockSize, int numBlocks)
+{
+    // Three times the prepared size, for the blocks hosts aren't supposed to send
+    juce::AudioBuffer<SampleType> storage (numChannels, blockSize * 3);
+    juce::MidiBuffer midi;
+    juce::Random rng (0x5eed);
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        auto numSamples = block % 7 == 3 ? blockSize * 3 : (block % 11 == 5 ? 1 : blockSize);
+
+        // Every fourth stretch of 20 blocks, sizes the micro-block grid never lines up with
+        if ((block / 20) % 4 == 1)
+            numSamples = 1 + rng.nextInt (blockSize);
+
+        const auto silent = (block / 40) % 3 == 2;
+
+        automateAll (proc, block);
+
+        juce::AudioBuffer<SampleType> buffer (storage.getArrayOfWritePointers(), numChannels, numSamples);
+        fillBlock (buffer, numSamples, silent, rng);
+        proc.processBlock (buffer, midi);
+    }
+}
+
+/** Runs one configuration and returns the number of violations it caused. */
+static int runCase (DspPath path, bool useDouble, int numChannels, int blockSize, int numBlocks, int numWorkers)
+{
+    HtmlToVstPluginAudioProcessor proc;
+    proc.setNumDspWorkers (numWorkers);
+    proc.setDspSplitForced (numWorkers > 0);
+
+    const auto set = getLayout (numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add (set);
+    layout.outputBuses.add (set);
+
+    if (! proc.setBusesLayout (layout))
+        return 0;
+
+    proc.setDspPath (path);
+
+    if (useDouble)
+        proc.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+
+    proc.getMeterStream().setActive (true);
+    proc.setRateAndBufferSizeDetails (48000.0, blockSize);
+    proc.prepareToPlay (48000.0, blockSize);
+
+    const auto before = htmltovst::RealtimeCheck::getNumViolations();
+
+    if (useDouble)
+        runBlocks<double> (proc, numChannels, blockSize, numBlocks);
+    else
+        runBlocks<float> (proc, numChannels, blockSize, numBlocks);
+
+    const auto found = htmltovst::RealtimeCheck::getNumViolations() - before;
+
+    std::fprintf (stderr, "%-9s  %-6s  %2d ch  %4d smp  %d workers  %s\n", getPathName (path), useDouble ? "double" : "float",
+                  numChannels, blockSize, numWorkers, found == 0 ? "ok" : juce::String (found).toRawUTF8());
+
+    proc.releaseResources();
+    return found;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg (argv[i]);
+
+        if (arg == "--quick")       quick = true;
+        else if (arg == "--abort")  htmltovst::RealtimeCheck::setAbortOnViolation (true);
+    }
+
+    if (! htmltovst::RealtimeCheck::isEnabled())
+    {
+        std::fprintf (stderr, "HtmlToVstRtCheck: built without HTMLTOVST_RT_CHECK, nothing is checked\n");
+        return 1;
+    }
+
+    std::vector<DspPath> paths { DspPath::fused, DspPath::reference };
+
+    if (HtmlToVstPluginAudioProcessor().hasEngineGraph())
+        paths.push_back (DspPath::graph);
+
+    const auto numBlocks = quick ? 120 : 600;
+    int total = 0;
+
+    for (auto path : paths)
+        for (auto numWorkers : { 0, 2 })
+            for (auto useDouble : { false, true })
+                for (auto numChannels : { 1, 2, 12 })
+                    for (auto blockSize : { 64, 512 })
+                        if (numWorkers == 0 || path == DspPath::fused)
+                            total += runCase (path, useDouble, numChannels, blockSize, numBlocks, numWorkers);
+
+    if (total == 0)
+        std::fprintf (stderr, "HtmlToVstRtCheck: no real-time violations\n");
+    else
+        std::fprintf (stderr, "HtmlToVstRtCheck: %d real-time violations\n", total);
+
+    return total == 0 ? 0 : 1;
+}
@@ -0,0 +1,461 @@
+// Headless multi-instance scaling test.
+//
+// Sessions run 100-300 instances in one host, which single-instance numbers say nothing
+// about: the instances' state competes for cache, the process-wide tables are shared
+// between them, and memory grows with every one. This builds what a host builds: the
+// instances as nodes of juce::AudioProcessorGraphs, one graph per render thread (a host's
+// tracks spread over its audio workers), every cycle released to all threads at once and
+// over when the slowest one finishes.
+//
+// Two topologies at each instance count: parallel, each of a graph's instances fed from its
+// input and summed into its output (one plug-in per track); serial, the graph's instances
+// chained one into the next (a long insert chain). Instances are added as the count grows
+// rather than rebuilt, so the memory figures are the process's resident set with them all
+// prepared and running: per instance overall, and per instance added since the last step.
+//
+// Reported per count and topology: total CPU (time spent in the graphs per second of audio,
+// in cores) and per instance, p99 and worst cycle time against the block's duration, cycles
+// that missed it, p99 time of one graph's block, and the memory figures. Stereo at 48 kHz;
+// drive is turned up so the tape stage does real work and the silence gate never idles.
+//
+//   HtmlToVstScaling [--quick] [--threads <n>] [--block <n>] [--seconds <s>] [--out <file>]
+
+#include "../Source/PluginProcessor.h"
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+namespace
+{
+
+using Graph = juce::AudioProcessorGraph;
+
+enum class Topology
+{
+    parallel,
+    serial
+};
+
+static const char* getTopologyName (Topology t)
+{
+    return t == Topology::parallel ? "parallel" : "serial";
+}
+
+/** Resident set of the whole process in bytes; 0 where it can't be read. */
+static double getResidentBytes()
+{
+   #if JUCE_LINUX
+    long pages = 0, resident = 0;
+
+    if (auto* f = std::fopen ("/proc/self/statm", "r"))
+    {
+        const auto ok = std::fscanf (f, "%ld %ld", &pages, &resident) == 2;
+        std::fclose (f);
+
+        if (ok)
+            return (double) resident * (double) sysconf (_SC_PAGESIZE);
+    }
+
+    return 0.0;
+   #elif JUCE_MAC
+    mach_task_basic_info info {};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+        return (double) info.resident_size;
+
+    return 0.0;
+   #else
+    return 0.0;
+   #endif
+}
+
+static double percentile (const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    const auto idx = (size_t) juce::jlimit (0.0, (double) (sorted.size() - 1), std::ceil (p * (double) sorted.size()) - 1.0);
+    return sorted[idx];
+}
+
+/** Spins for a while, then yields: a render thread waiting for its next cycle. */
+template <typename Predicate>
+static void waitUntil (Predicate&& done) noexcept
+{
+    for (int spins = 0; ! done(); ++spins)
+        if (spins > 1000)
+            std::this_thread::yield();
+}
+
+//==============================================================================
+// One render thread's graph: its instances between the graph's audio input and output.
+struct Track
+{
+    Track()
+    {
+        input  = graph.addNode (std::make_unique<Graph::AudioGraphIOProcessor> (Graph::AudioGraphIOProcessor::audioInputNode));
+        output = graph.addNode (std::make_unique<Graph::AudioGraphIOProcessor> (Graph::AudioGraphIOProcessor::audioOutputNode));
+    }
+
+    void addInstance()
+    {
+        auto proc = std::make_unique<HtmlToVstPluginAudioProcessor>();
+
+        if (auto* p = proc->apvts.getParameter ("drive"))
+            p->setValueNotifyingHost (p->convertTo0to1 (0.6f));
+
+        instances.push_back (graph.addNode (std::move (proc), {}, Graph::UpdateKind::none));
+    }
+
+    void wire (Topology topology)
+    {
+        for (const auto& c : graph.getConnections())
+            graph.removeConnection (c, Graph::UpdateKind::none);
+
+        auto connect = [this] (Graph::NodeID from, Graph::NodeID to)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                graph.addConnection ({ { from, ch }, { to, ch } }, Graph::UpdateKind::none);
+        };
+
+        if (topology == Topology::parallel)
+        {
+            for (const auto& node : instances)
+            {
+                connect (input->nodeID, node->nodeID);
+                connect (node->nodeID, output->nodeID);
+            }
+        }
+        else
+        {
+            auto previous = input->nodeID;
+
+            for (const auto& node : instances)
+            {
+                connect (previous, node->nodeID);
+                previous = node->nodeID;
+            }
+
+            connect (previous, output->nodeID);
+        }
+
+        graph.rebuild();
+    }
+
+    void prepare (double sampleRate, int blockSize, int numCycles, int seed)
+    {
+        graph.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+        graph.prepareToPlay (sampleRate, blockSize);
+
+        buffer.setSize (2, blockSize);
+        source.setSize (2, blockSize);
+
+        juce::Random rng (seed);
+
+        for (int ch = 0; ch < source.getNumChannels(); ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                source.setSample (ch, i, 0.5f * (rng.nextFloat() * 2.0f - 1.0f));
+
+        blockUs.clear();
+        blockUs.reserve ((size_t) numCycles);
+        busySeconds = 0.0;
+    }
+
+    /** On the track's render thread: one block through the graph, timed. */
+    void render() noexcept
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            buffer.copyFrom (ch, 0, source, ch, 0, buffer.getNumSamples());
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        graph.processBlock (buffer, midi);
+        const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+        busySeconds += seconds;
+
+        if (blockUs.size() < blockUs.capacity())
+            blockUs.push_back (seconds * 1.0e6);
+    }
+
+    Graph graph;
+    Graph::Node::Ptr input, output;
+    std::vector<Graph::Node::Ptr> instances;
+
+    juce::AudioBuffer<float> buffer, source;
+    juce::MidiBuffer midi;
+
+    std::vector<double> blockUs;
+    double busySeconds = 0.0;
+};
+
+//==============================================================================
+// A host's audio workers: one thread per track, all released together each cycle.
+class RenderThreads
+{
+public:
+    explicit RenderThreads (const std::vector<Track*>& tracksToRun)
+        : tracks (tracksToRun)
+    {
+        for (auto* track : tracks)
+            threads.emplace_back ([this, track] { run (*track); });
+    }
+
+    ~RenderThreads()
+    {
+        quit.store (true);
+        cycle.fetch_add (1, std::memory_order_release);
+
+        for (auto& t : threads)
+            t.join();
+    }
+
+    /** Every track renders one block; returns when the last has finished. */
+    void renderCycle() noexcept
+    {
+        pending.store ((int) tracks.size(), std::memory_order_relaxed);
+        cycle.fetch_add (1, std::memory_order_release);
+        waitUntil ([this] { return pending.load (std::memory_order_acquire) == 0; });
+    }
+
+private:
+    void run (Track& track) noexcept
+    {
+        for (auto seen = 0;;)
+        {
+            waitUntil ([&] { return cycle.load (std::memory_order_acquire) != seen; });
+            seen = cycle.load (std::memory_order_acquire);
+
+            if (quit.load())
+                return;
+
+            track.render();
+            pending.fetch_sub (1, std::memory_order_release);
+        }
+    }
+
+    std::vector<Track*> tracks;
+    std::vector<std::thread> threads;
+    std::atomic<int> cycle { 0 }, pending { 0 };
+    std::atomic<bool> quit { false };
+};
+
+//==============================================================================
+struct Result
+{
+    Topology topology = Topology::parallel;
+    int instances = 0;
+    int threads = 0;
+    double cores = 0.0;                 // seconds spent in the graphs per second of audio
+    double nsPerInstanceSample = 0.0;
+    double deadlineUs = 0.0;
+    double cycleP99Us = 0.0, cycleMaxUs = 0.0;
+    int lateCycles = 0;
+    double blockP99Us = 0.0;
+    double residentBytes = 0.0, bytesPerInstance = 0.0, bytesPerAddedInstance = 0.0;
+};
+
+static Result measure (const std::vector<Track*>& tracks, int numInstances, Topology topology,
+                       double sampleRate, int blockSize, double secondsOfAudio)
+{
+    const auto numCycles = juce::jmax (1, (int) (secondsOfAudio * sampleRate / blockSize));
+    const auto warmUpCycles = juce::jmax (1, (int) (0.1 * sampleRate / blockSize));
+
+    for (size_t t = 0; t < tracks.size(); ++t)
+    {
+        tracks[t]->wire (topology);
+        tracks[t]->prepare (sampleRate, blockSize, numCycles, (int) t + 1);
+    }
+
+    RenderThreads threads (tracks);
+
+    for (int i = 0; i < warmUpCycles; ++i)
+        threads.renderCycle();
+
+    // The threads only wait between cycles, so their stats can be reset from here
+    for (auto* track : tracks)
+    {
+        track->blockUs.clear();
+        track->busySeconds = 0.0;
+    }
+
+    std::vector<double> cycleUs;
+    cycleUs.reserve ((size_t) numCycles);
+
+    for (int i = 0; i < numCycles; ++i)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        threads.renderCycle();
+        cycleUs.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e6);
+    }
+
+    Result r;
+    r.topology = topology;
+    r.instances = numInstances;
+    r.threads = (int) tracks.size();
+    r.deadlineUs = 1.0e6 * blockSize / sampleRate;
+
+    double busy = 0.0;
+    std::vector<double> blockUs;
+
+    for (auto* track : tracks)
+    {
+        busy += track->busySeconds;
+        blockUs.insert (blockUs.end(), track->blockUs.begin(), track->blockUs.end());
+    }
+
+    const auto audioSeconds = (double) numCycles * blockSize / sampleRate;
+    r.cores = busy / audioSeconds;
+    r.nsPerInstanceSample = busy * 1.0e9 / ((double) numInstances * numCycles * blockSize);
+
+    std::sort (cycleUs.begin(), cycleUs.end());
+    std::sort (blockUs.begin(), blockUs.end());
+    r.cycleP99Us = percentile (cycleUs, 0.99);
+    r.cycleMaxUs = cycleUs.back();
+    r.lateCycles = (int) std::count_if (cycleUs.begin(), cycleUs.end(), [&] (double us) { return us > r.deadlineUs; });
+    r.blockP99Us = percentile (blockUs, 0.99);
+    return r;
+}
+
+static juce::var toVar (const Result& r, double nsAtFewest)
+{
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("topology",              getTopologyName (r.topology));
+    obj->setProperty ("instances",             r.instances);
+    obj->setProperty ("threads",               r.threads);
+    obj->setProperty ("cores",                 r.cores);
+    obj->setProperty ("nsPerInstanceSample",   r.nsPerInstanceSample);
+    obj->setProperty ("vsFewest",              nsAtFewest > 0.0 ? r.nsPerInstanceSample / nsAtFewest : 0.0);
+    obj->setProperty ("deadlineUs",            r.deadlineUs);
+    obj->setProperty ("cycleP99Us",            r.cycleP99Us);
+    obj->setProperty ("cycleMaxUs",            r.cycleMaxUs);
+    obj->setProperty ("lateCycles",            r.lateCycles);
+    obj->setProperty ("blockP99Us",            r.blockP99Us);
+    obj->setProperty ("residentBytes",         r.residentBytes);
+    obj->setProperty ("bytesPerInstance",      r.bytesPerInstance);
+    obj->setProperty ("bytesPerAddedInstance", r.bytesPerAddedInstance);
+    return juce::var (obj.release());
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    const bool quick = args.contains ("--quick");
+
+    double seconds = quick ? 0.5 : 3.0;
+    if (auto idx = args.indexOf ("--seconds"); idx >= 0 && idx + 1 < args.size())
+        seconds = juce::jmax (0.01, args[idx + 1].getDoubleValue());
+
+    // Hosts leave a core or two for the UI and disk; half the machine is a fair stand-in
+    int numThreads = juce::jlimit (1, 16, juce::SystemStats::getNumCpus() / 2);
+    if (auto idx = args.indexOf ("--threads"); idx >= 0 && idx + 1 < args.size())
+        numThreads = juce::jlimit (1, 64, args[idx + 1].getIntValue());
+
+    int blockSize = 128;
+    if (auto idx = args.indexOf ("--block"); idx >= 0 && idx + 1 < args.size())
+        blockSize = juce::jlimit (16, 4096, args[idx + 1].getIntValue());
+
+    juce::File outFile;
+    if (auto idx = args.indexOf ("--out"); idx >= 0 && idx + 1 < args.size())
+        outFile = juce::File::getCurrentWorkingDirectory().getChildFile (args[idx + 1]);
+
+    const auto sampleRate = 48000.0;
+    const std::vector<int> counts = quick ? std::vector<int> { 1, 10, 50, 100 }
+                                          : std::vector<int> { 1, 10, 25, 50, 100, 150, 200, 250, 300 };
+
+    const auto baseline = getResidentBytes();
+    auto lastResident = baseline;
+
+    std::vector<std::unique_ptr<Track>> tracks;
+    for (int t = 0; t < numThreads; ++t)
+        tracks.push_back (std::make_unique<Track>());
+
+    std::vector<Result> results;
+    int numInstances = 0;
+
+    for (const auto count : counts)
+    {
+        const auto added = count - numInstances;
+
+        // Round robin, as hosts spread tracks over their workers
+        for (; numInstances < count; ++numInstances)
+            tracks[(size_t) (numInstances % numThreads)]->addInstance();
+
+        std::vector<Track*> active;
+        for (auto& t : tracks)
+            if (! t->instances.empty())
+                active.push_back (t.get());
+
+        double resident = 0.0;
+
+        for (const auto topology : { Topology::parallel, Topology::serial })
+        {
+            auto r = measure (active, count, topology, sampleRate, blockSize, seconds);
+
+            // Everything is prepared and has run by now
+            if (topology == Topology::parallel)
+                resident = getResidentBytes();
+
+            r.residentBytes = resident;
+            r.bytesPerInstance = baseline > 0.0 ? (resident - baseline) / count : 0.0;
+            r.bytesPerAddedInstance = baseline > 0.0 && added > 0 ? (resident - lastResident) / added : 0.0;
+            results.push_back (r);
+
+            std::fprintf (stderr, "%-8s %3d instances on %2d threads  %6.2f cores  %8.2f ns/smp each  cycle p99 %8.1f us (max %8.1f) of %6.1f us, %d late  block p99 %8.1f us  %7.1f KiB each (%7.1f KiB added)\n",
+                          getTopologyName (r.topology), r.instances, r.threads, r.cores, r.nsPerInstanceSample,
+                          r.cycleP99Us, r.cycleMaxUs, r.deadlineUs, r.lateCycles, r.blockP99Us,
+                          r.bytesPerInstance / 1024.0, r.bytesPerAddedInstance / 1024.0);
+        }
+
+        lastResident = resident;
+    }
+
+    // Per-instance cost against the fewest instances in the same topology: flat is ideal,
+    // growth is cache pressure or contention
+    juce::Array<juce::var> list;
+
+    for (const auto& r : results)
+    {
+        const auto fewest = std::find_if (results.begin(), results.end(), [&] (const Result& o) { return o.topology == r.topology; });
+        list.add (toVar (r, fewest->nsPerInstanceSample));
+    }
+
+    auto root = std::make_unique<juce::DynamicObject>();
+    root->setProperty ("benchmark", "HtmlToVstScaling");
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty ("sampleRate", sampleRate);
+    root->setProperty ("blockSize", blockSize);
+    root->setProperty ("threads", numThreads);
+    root->setProperty ("baselineResidentBytes", baseline);
+    root->setProperty ("results", list);
+
+    const auto text = juce::JSON::toString (juce::var (root.release()));
+
+    if (outFile != juce::File())
+        outFile.replaceWithText (text);
+    else
+        std::printf ("%s\n", text.toRawUTF8());
+
+    return 0;
+}
@@ -0,0 +1,374 @@
+#include "Convolver.h"
+#include "SharedTables.h"
+
+#include "IrData.h"
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+namespace htmltovst
+{
+
+//==============================================================================
+/** The IR in an embedded WAV, first channel, resampled to sampleRate; a unit impulse if it
+    can't be read.
+*/
+static std::vector<float> loadIr (const void* data, int dataSize, double sampleRate)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (new juce::MemoryInputStream (data, (size_t) dataSize, false), true));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+    {
+        jassertfalse;
+        return { 1.0f };
+    }
+
+    const auto length = (int) reader->lengthInSamples;
+    juce::AudioBuffer<float> file (1, length + 8);      // the interpolator reads a little past the end
+    file.clear();
+    reader->read (&file, 0, length, 0, true, false);
+
+    const auto ratio = reader->sampleRate / sampleRate;
+
+    if (std::abs (ratio - 1.0) < 1.0e-9)
+        return { file.getReadPointer (0), file.getReadPointer (0) + length };
+
+    std::vector<float> ir ((size_t) juce::jmax (1, juce::roundToInt (length / ratio)));
+    juce::LagrangeInterpolator interpolator;
+    interpolator.process (ratio, file.getReadPointer (0), ir.data(), (int) ir.size());
+    return ir;
+}
+
+static std::vector<float> convolve (const std::vector<float>& a, const std::vector<float>& b)
+{
+    std::vector<float> out (a.size() + b.size() - 1, 0.0f);
+
+    for (size_t i = 0; i < a.size(); ++i)
+        for (size_t j = 0; j < b.size(); ++j)
+            out[i + j] += a[i] * b[j];
+
+    return out;
+}
+
+/** Unity at 1 kHz, whatever the file's level and the resampling did to it. */
+static void normalise (std::vector<float>& ir, double sampleRate)
+{
+    double re = 0.0, im = 0.0;
+
+    for (size_t i = 0; i < ir.size(); ++i)
+    {
+        const auto w = juce::MathConstants<double>::twoPi * 1000.0 * (double) i / sampleRate;
+        re += ir[i] * std::cos (w);
+        im -= ir[i] * std::sin (w);
+    }
+
+    if (const auto gain = std::hypot (re, im); gain > 1.0e-6)
+        for (auto& v : ir)
+            v = (float) (v / gain);
+}
+
+//==============================================================================
+Convolver::Bank Convolver::makeBank (double sampleRate)
+{
+    const std::vector<float> heads[] = { loadIr (IrData::headblock_stereo_wav, IrData::headblock_stereo_wavSize, sampleRate),
+                                         loadIr (IrData::headblock_mono_wav, IrData::headblock_mono_wavSize, sampleRate) };
+    const auto transformer = loadIr (IrData::transformer_wav, IrData::transformer_wavSize, sampleRate);
+
+    // The FFT engine JUCE picks may or may not scale its inverse; measure the round trip
+    // and fold its reciprocal into the IR spectra
+    juce::dsp::FFT fft (kFftOrder);
+    std::vector<float> buffer ((size_t) (2 * kFftSize), 0.0f);
+    buffer[0] = 1.0f;
+    fft.performRealOnlyForwardTransform (buffer.data(), true);
+    fft.performRealOnlyInverseTransform (buffer.data());
+    const auto scale = 1.0f / buffer[0];
+
+    Bank bank {};
+
+    for (int hb = 0; hb < 2; ++hb)
+    {
+        for (int tr = 0; tr < 2; ++tr)
+        {
+            auto h = tr != 0 ? convolve (heads[hb], transformer) : heads[hb];
+            normalise (h, sampleRate);
+
+            auto& ir = bank[(size_t) getIrIndex ((Headblock) hb, tr != 0)];
+            ir.length = (int) h.size();
+            ir.numPartitions = juce::jmax (0, (ir.length - 1) / kPartitionSize);
+            ir.re.assign ((size_t) (ir.numPartitions * kNumBins), 0.0f);
+            ir.im.assign ((size_t) (ir.numPartitions * kNumBins), 0.0f);
+
+            // Reversed, so that the direct part is a dot product with the input in order
+            for (int k = 0; k < kPartitionSize && k < ir.length; ++k)
+                ir.head[(size_t) (kPartitionSize - 1 - k)] = h[(size_t) k];
+
+            // Each later partition zero-padded to the FFT size: overlap-save keeps the
+            // second half of the circular result, which is then exact
+            for (int p = 0; p < ir.numPartitions; ++p)
+            {
+                std::fill (buffer.begin(), buffer.end(), 0.0f);
+                const auto first = (p + 1) * kPartitionSize;
+
+                for (int k = 0; k < kPartitionSize && first + k < ir.length; ++k)
+                    buffer[(size_t) k] = h[(size_t) (first + k)];
+
+                fft.performRealOnlyForwardTransform (buffer.data(), true);
+
+                for (int b = 0; b < kNumBins; ++b)
+                {
+                    ir.re[(size_t) (p * kNumBins + b)] = buffer[(size_t) (2 * b)] * scale;
+                    ir.im[(size_t) (p * kNumBins + b)] = buffer[(size_t) (2 * b + 1)] * scale;
+                }
+            }
+        }
+    }
+
+    return bank;
+}
+
+std::shared_ptr<const Convolver::Bank> Convolver::getSharedBank (SharedTables& tables, double sampleRate)
+{
+    return tables.get<Bank> ("convolver/" + juce::String (sampleRate), [sampleRate] { return makeBank (sampleRate); });
+}
+
+int Convolver::getIrIndex (Headblock headblock, bool transformer) noexcept
+{
+    return juce::jlimit (0, 1, (int) headblock) * 2 + (transformer ? 1 : 0);
+}
+
+//==============================================================================
+void Convolver::prepare (std::shared_ptr<const Bank> newBank, double newSampleRate, int numChannels)
+{
+    bank = std::move (newBank);
+    sampleRate = newSampleRate;
+    numPrepared = juce::jlimit (0, kMaxChannels, numChannels);
+    maxPartitions = 1;
+
+    if (bank != nullptr)
+        for (const auto& ir : *bank)
+            maxPartitions = juce::jmax (maxPartitions, ir.numPartitions);
+
+    window.assign ((size_t) (numPrepared * kFftSize), 0.0f);
+    spectraRe.assign ((size_t) (numPrepared * maxPartitions * kNumBins), 0.0f);
+    spectraIm.assign (spectraRe.size(), 0.0f);
+
+    for (auto& tail : tails)
+        tail.assign ((size_t) (numPrepared * kPartitionSize), 0.0f);
+
+    fftBuffer.assign ((size_t) (2 * kFftSize), 0.0f);
+    fadeLength = juce::jmax (1, juce::roundToInt (kCrossfadeSeconds * sampleRate));
+    selectedIr = -1;
+    reset();
+}
+
+void Convolver::reset() noexcept
+{
+    for (auto* v : { &window, &spectraRe, &spectraIm, &tails[0], &tails[1] })
+        std::fill (v->begin(), v->end(), 0.0f);
+
+    position = 0;
+    newest = 0;
+    fadeRemaining = 0;
+    atRest = true;
+
+    // Nothing is playing any more, so a pending or half-finished switch lands straight away
+    if (selectedIr >= 0)
+        slotIr[(size_t) activeSlot] = selectedIr;
+}
+
+void Convolver::select (int irIndex) noexcept
+{
+    irIndex = juce::jlimit (0, kNumIrs - 1, irIndex);
+
+    if (irIndex == selectedIr)
+        return;
+
+    // First choice after prepare or reset: nothing is playing yet, so there is nothing to fade from
+    if (selectedIr < 0 || atRest)
+        slotIr[(size_t) activeSlot] = irIndex;
+
+    // Otherwise runPartition() starts the fade once the current one, if any, has finished
+    selectedIr = irIndex;
+}
+
+double Convolver::getTailSeconds() const noexcept
+{
+    if (bank == nullptr || selectedIr < 0 || sampleRate <= 0.0)
+        return 0.0;
+
+    return (double) (*bank)[(size_t) selectedIr].length / sampleRate;
+}
+
+//==============================================================================
+void Convolver::runPartition (int numChannels) noexcept
+{
+    // Both IRs have a tail ready for the partition after a boundary, so that is where a fade starts
+    if (fadeRemaining == 0 && slotIr[(size_t) activeSlot] != selectedIr && selectedIr >= 0)
+    {
+        activeSlot = 1 - activeSlot;
+        slotIr[(size_t) activeSlot] = selectedIr;
+        fadeRemaining = fadeLength;
+    }
+
+    newest = (newest + 1) % maxPartitions;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* w = window.data() + ch * kFftSize;
+
+        std::copy (w, w + kFftSize, fftBuffer.begin());
+        fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+        const auto offset = (size_t) ((ch * maxPartitions + newest) * kNumBins);
+
+        for (int b = 0; b < kNumBins; ++b)
+        {
+            spectraRe[offset + (size_t) b] = fftBuffer[(size_t) (2 * b)];
+            spectraIm[offset + (size_t) b] = fftBuffer[(size_t) (2 * b + 1)];
+        }
+
+        // The partition just finished becomes the head's history
+        std::copy (w + kPartitionSize, w + kFftSize, w);
+
+        computeTail (activeSlot, ch);
+
+        if (fadeRemaining > 0)
+            computeTail (1 - activeSlot, ch);
+    }
+}
+
+void Convolver::computeTail (int slot, int channel) noexcept
+{
+    const auto& ir = (*bank)[(size_t) slotIr[(size_t) slot]];
+    auto* tail = tails[(size_t) slot].data() + channel * kPartitionSize;
+
+    if (ir.numPartitions == 0)
+    {
+        std::fill (tail, tail + kPartitionSize, 0.0f);
+        return;
+    }
+
+    accRe.fill (0.0f);
+    accIm.fill (0.0f);
+
+    // Partition p of the IR meets the input spectrum from p partitions ago
+    for (int p = 0; p < ir.numPartitions; ++p)
+    {
+        const auto k = (newest - p + maxPartitions) % maxPartitions;
+        const auto* xr = spectraRe.data() + (channel * maxPartitions + k) * kNumBins;
+        const auto* xi = spectraIm.data() + (channel * maxPartitions + k) * kNumBins;
+        const auto* hr = ir.re.data() + p * kNumBins;
+        const auto* hi = ir.im.data() + p * kNumBins;
+
+        int b = 0;
+
+        for (; b + Float4::size <= kNumBins; b += Float4::size)
+        {
+            const auto ar = Float4::load (xr + b), ai = Float4::load (xi + b);
+            const auto br = Float4::load (hr + b), bi = Float4::load (hi + b);
+
+            (Float4::load (accRe.data() + b) + ar * br - ai * bi).store (accRe.data() + b);
+            (Float4::load (accIm.data() + b) + ar * bi + ai * br).store (accIm.data() + b);
+        }
+
+        for (; b < kNumBins; ++b)
+        {
+            accRe[(size_t) b] += xr[b] * hr[b] - xi[b] * hi[b];
+            accIm[(size_t) b] += xr[b] * hi[b] + xi[b] * hr[b];
+        }
+    }
+
+    for (int b = 0; b < kNumBins; ++b)
+    {
+        fftBuffer[(size_t) (2 * b)] = accRe[(size_t) b];
+        fftBuffer[(size_t) (2 * b + 1)] = accIm[(size_t) b];
+    }
+
+    fft.performRealOnlyInverseTransform (fftBuffer.data());
+    std::copy (fftBuffer.begin() + kPartitionSize, fftBuffer.begin() + kFftSize, tail);
+}
+
+//==============================================================================
+/** The direct part of one output sample: the reversed head against the last kPartitionSize inputs. */
+static inline float runHead (const float* head, const float* history) noexcept
+{
+    auto acc0 = Float4::broadcast (0.0f), acc1 = acc0;
+
+    for (int k = 0; k < Convolver::kPartitionSize; k += 2 * Float4::size)
+    {
+        acc0 = acc0 + Float4::load (head + k) * Float4::load (history + k);
+        acc1 = acc1 + Float4::load (head + k + Float4::size) * Float4::load (history + k + Float4::size);
+    }
+
+    float lanes[Float4::size];
+    (acc0 + acc1).store (lanes);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+template <typename SampleType>
+void Convolver::process (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin (numChannels, numPrepared);
+
+    if (bank == nullptr || numChannels <= 0 || numSamples <= 0)
+        return;
+
+    atRest = false;
+
+    // Up to the next partition boundary at a time: the tails in hand cover exactly that far
+    for (int done = 0; done < numSamples;)
+    {
+        const auto n = juce::jmin (numSamples - done, kPartitionSize - position);
+        const auto fading = fadeRemaining > 0;
+        const auto inc = 1.0f / (float) fadeLength;
+        const auto start = 1.0f - (float) fadeRemaining * inc;
+        const auto& to = (*bank)[(size_t) slotIr[(size_t) activeSlot]];
+        const auto& from = (*bank)[(size_t) slotIr[(size_t) (1 - activeSlot)]];
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* x = channels[ch] + done;
+            auto* w = window.data() + ch * kFftSize;
+            auto* in = w + kPartitionSize + position;
+            const auto* tailTo = tails[(size_t) activeSlot].data() + ch * kPartitionSize + position;
+
+            for (int i = 0; i < n; ++i)
+                in[i] = (float) x[i];
+
+            if (! fading)
+            {
+                for (int i = 0; i < n; ++i)
+                    x[i] = (SampleType) (runHead (to.head.data(), w + position + i + 1) + tailTo[i]);
+            }
+            else
+            {
+                // Both IRs run for the length of the fade; the output slides from one to the other
+                const auto* tailFrom = tails[(size_t) (1 - activeSlot)].data() + ch * kPartitionSize + position;
+
+                for (int i = 0; i < n; ++i)
+                {
+                    const auto a = runHead (from.head.data(), w + position + i + 1) + tailFrom[i];
+                    const auto b = runHead (to.head.data(), w + position + i + 1) + tailTo[i];
+                    x[i] = (SampleType) (a + juce::jmin (1.0f, start + inc * (float) (i + 1)) * (b - a));
+                }
+            }
+        }
+
+        if (fading)
+            fadeRemaining = juce::jmax (0, fadeRemaining - n);
+
+        done += n;
+        position += n;
+
+        if (position == kPartitionSize)
+        {
+            runPartition (numChannels);
+            position = 0;
+        }
+    }
+}
+
+template void Convolver::process (float* const*, int, int) noexcept;
+template void Convolver::process (double* const*, int, int) noexcept;
+
+} // namespace htmltovst
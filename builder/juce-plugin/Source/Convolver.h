@@ -0,0 +1,123 @@
+#pragma once
+
+#include "SimdLanes.h"
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Head and transformer character for the "ampex_102" engine: short impulse responses
+// (Assets/IR, embedded with juce_add_binary_data) run through a uniformly partitioned
+// convolution.
+//
+// The first kPartitionSize taps run directly, so the stage adds no latency; the rest run
+// as FFT partitions of the same size (overlap-save) against a delay line of input spectra,
+// each finishing just before its output is due. The IR spectra depend only on the rate and
+// are shared by every instance. The input spectra don't depend on the IR, so a new IR
+// starts with its whole history and fades in over kCrossfadeSeconds: switching neither
+// clicks nor allocates.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class SharedTables;
+
+class Convolver
+{
+public:
+    enum class Headblock
+    {
+        stereo = 0,     // half-track heads
+        mono   = 1      // full-track head
+    };
+
+    static constexpr int kPartitionSize = 128;  // direct taps, and the FFT hop
+    static constexpr int kNumIrs = 4;           // headblock x transformer in / out
+    static constexpr int kMaxChannels = 16;
+    static constexpr double kCrossfadeSeconds = 0.01;
+
+    static constexpr int kNumBins = kPartitionSize + 1;
+
+    /** One IR at one rate: its first kPartitionSize taps reversed, and the spectra of the
+        partitions after them (numPartitions x kNumBins each, scaled for the inverse FFT).
+    */
+    struct Ir
+    {
+        std::array<float, kPartitionSize> head {};
+        std::vector<float> re, im;
+        int numPartitions = 0;
+        int length = 0;
+    };
+
+    /** Every IR at one sample rate, indexed by getIrIndex(). */
+    using Bank = std::array<Ir, kNumIrs>;
+
+    /** Loads, resamples and partitions the embedded IRs. Build once per rate (see SharedTables). */
+    static Bank makeBank (double sampleRate);
+
+    /** makeBank()'s result from the process-wide cache, built on first use at each rate. */
+    static std::shared_ptr<const Bank> getSharedBank (SharedTables& tables, double sampleRate);
+
+    static int getIrIndex (Headblock headblock, bool transformer) noexcept;
+
+    /** Takes the bank and sizes the delay lines for its longest IR; the first select() after
+        this, or after reset(), doesn't fade.
+    */
+    void prepare (std::shared_ptr<const Bank> newBank, double sampleRate, int numChannels);
+    void reset() noexcept;
+
+    /** Block-rate. A new IR fades in from the next partition; changes that arrive during a
+        fade wait for it to finish.
+    */
+    void select (int irIndex) noexcept;
+
+    /** Buffers may be float or double; the convolution runs in float. Channels past the
+        prepared count, and everything before prepare(), pass through.
+    */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** How long the IR in use rings on once the input stops. */
+    double getTailSeconds() const noexcept;
+
+private:
+    static constexpr int kFftOrder = 8;
+    static constexpr int kFftSize = 2 * kPartitionSize;
+
+    static_assert (1 << kFftOrder == kFftSize);
+    static_assert (kPartitionSize % (2 * Float4::size) == 0);
+
+    void runPartition (int numChannels) noexcept;
+    void computeTail (int slot, int channel) noexcept;
+
+    std::shared_ptr<const Bank> bank;
+    juce::dsp::FFT fft { kFftOrder };
+    double sampleRate = 0.0;
+    int numPrepared = 0;
+    int maxPartitions = 1;
+
+    // Per channel: the last two partitions of input (the head's history and the FFT window),
+    // the input spectra of the last maxPartitions partitions, and each slot's tail output
+    // for the partition being played
+    std::vector<float> window;
+    std::vector<float> spectraRe, spectraIm;
+    std::array<std::vector<float>, 2> tails;
+
+    std::vector<float> fftBuffer;
+    std::array<float, kNumBins> accRe {}, accIm {};
+
+    int position = 0;                   // samples into the current partition
+    int newest = 0;                     // spectra slot of the latest partition
+
+    std::array<int, 2> slotIr {};       // IR in each slot
+    int activeSlot = 0;                 // the slot being faded to (or playing)
+    int selectedIr = -1;
+    int fadeLength = 1, fadeRemaining = 0;
+    bool atRest = true;                 // reset and not processed since
+};
+
+} // namespace htmltovst
@@ -0,0 +1,113 @@
+#include "CpuTelemetry.h"
+
+namespace htmltovst
+{
+
+double CpuTelemetry::getTicksPerSecond()
+{
+   #if JUCE_INTEL || (JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC)
+    // The counter runs at a fixed rate on any CPU this builds for, but the rate isn't
+    // reported portably: count it against the system clock over a short sleep.
+    static const double ticksPerSecond = []
+    {
+        const auto clockStart = juce::Time::getHighResolutionTicks();
+        const auto start = now();
+        juce::Thread::sleep (20);
+        const auto ticks = now() - start;
+        const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - clockStart);
+
+        return seconds > 0.0 ? (double) ticks / seconds : 1.0e9;
+    }();
+
+    return ticksPerSecond;
+   #else
+    return (double) juce::Time::getHighResolutionTicksPerSecond();
+   #endif
+}
+
+void CpuTelemetry::prepare (double sampleRate)
+{
+    ticksPerSample = sampleRate > 0.0 ? getTicksPerSecond() / sampleRate : 0.0;
+}
+
+void CpuTelemetry::record (Ticks start, Ticks end, int numSamples) noexcept
+{
+    if (numSamples <= 0 || ticksPerSample <= 0.0)
+        return;
+
+    const auto elapsed = end - start;
+    const auto budget = (double) numSamples * ticksPerSample;
+    const auto load = (float) ((double) elapsed / budget);
+    const auto bin = juce::jmin (kNumBins - 1, (int) (load * (float) kBinsPerUnit));
+
+    add (bins[(size_t) bin], std::uint32_t (1));
+    add (blocks, std::uint64_t (1));
+    add (busyTicks, elapsed);
+    add (budgetTicks, (Ticks) budget);
+
+    if (load > maxLoad.load (std::memory_order_relaxed))
+        maxLoad.store (load, std::memory_order_relaxed);
+
+    add (overheadTicks, now() - end);
+}
+
+CpuTelemetry::Snapshot CpuTelemetry::getSnapshot() const noexcept
+{
+    Snapshot s;
+
+    for (size_t i = 0; i < bins.size(); ++i)
+        s.bins[i] = bins[i].load (std::memory_order_relaxed);
+
+    s.blocks        = blocks.load (std::memory_order_relaxed);
+    s.busyTicks     = busyTicks.load (std::memory_order_relaxed);
+    s.budgetTicks   = budgetTicks.load (std::memory_order_relaxed);
+    s.overheadTicks = overheadTicks.load (std::memory_order_relaxed);
+    s.maxLoad       = maxLoad.load (std::memory_order_relaxed);
+    return s;
+}
+
+CpuTelemetry::Summary CpuTelemetry::summarise (const Snapshot& later, const Snapshot& earlier) noexcept
+{
+    Summary r;
+
+    if (later.blocks <= earlier.blocks)
+        return r;
+
+    r.blocks = later.blocks - earlier.blocks;
+
+    const auto busy = (double) (later.busyTicks - earlier.busyTicks);
+    const auto budget = (double) (later.budgetTicks - earlier.budgetTicks);
+
+    r.meanUs   = busy * 1.0e6 / (getTicksPerSecond() * (double) r.blocks);
+    r.meanLoad = budget > 0.0 ? busy / budget : 0.0;
+    r.overhead = busy > 0.0 ? (double) (later.overheadTicks - earlier.overheadTicks) / busy : 0.0;
+
+    // Upper edges of the bins holding the 99th percentile and the last block
+    const auto p99Rank = (std::uint64_t) std::ceil (0.99 * (double) r.blocks);
+    std::uint64_t seen = 0;
+
+    for (int i = 0; i < kNumBins; ++i)
+    {
+        const auto count = (std::uint64_t) (later.bins[(size_t) i] - earlier.bins[(size_t) i]);
+
+        if (count == 0)
+            continue;
+
+        const auto edge = (double) (i + 1) / (double) kBinsPerUnit;
+
+        if (seen < p99Rank && seen + count >= p99Rank)
+            r.p99Load = edge;
+
+        seen += count;
+        r.maxLoad = edge;
+    }
+
+    // Past the last bin, or over everything so far, the exact maximum is the better answer
+    if (earlier.blocks == 0 || r.maxLoad > (double) (kNumBins - 1) / (double) kBinsPerUnit)
+        r.maxLoad = (double) later.maxLoad;
+
+    r.p99Load = juce::jmin (r.p99Load, r.maxLoad);
+    return r;
+}
+
+} // namespace htmltovst
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+// Per-instance CPU load of processBlock.
+//
+// Each block is timed with the CPU's cycle counter (rdtsc, cntvct_el0 on 64-bit ARM,
+// the high-resolution clock elsewhere) and its load, time spent over the block's
+// duration at the host rate, is counted into a histogram of 0.25% bins. The audio thread
+// is the only writer: relaxed stores to atomics, no locks, no allocation. The counters
+// only ever grow; readers take a Snapshot and difference it against their previous one,
+// so the editor and the log each get their own window without resetting anything.
+//
+// The bookkeeping times itself: the histogram update and one counter read after every
+// block are summed as overhead and reported as a share of the measured block cost.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class CpuTelemetry
+{
+public:
+    static constexpr int kBinsPerUnit = 400;                    // 0.25% of a block's duration
+    static constexpr int kNumBins = 2 * kBinsPerUnit + 1;       // up to 200%; the last bin is everything above
+
+    using Ticks = std::uint64_t;
+
+    static Ticks now() noexcept
+    {
+       #if JUCE_INTEL
+        return (Ticks) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+        Ticks t;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (t));
+        return t;
+       #else
+        return (Ticks) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    /** Rate of now(), measured against the system clock once per process (sleeps ~20 ms the first time). */
+    static double getTicksPerSecond();
+
+    /** Not on the audio thread. */
+    void prepare (double sampleRate);
+
+    /** Audio thread: times everything between construction and destruction as one block. */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (CpuTelemetry& owner, int numSamplesIn) noexcept
+            : telemetry (owner), numSamples (numSamplesIn), start (now()) {}
+
+        ~ScopedBlock()                      { telemetry.record (start, now(), numSamples); }
+
+        ScopedBlock (const ScopedBlock&) = delete;
+        ScopedBlock& operator= (const ScopedBlock&) = delete;
+
+    private:
+        CpuTelemetry& telemetry;
+        const int numSamples;
+        const Ticks start;
+    };
+
+    //==============================================================================
+    /** Cumulative counters; copy them with getSnapshot(). */
+    struct Snapshot
+    {
+        std::array<std::uint32_t, kNumBins> bins {};
+        std::uint64_t blocks = 0;
+        Ticks busyTicks = 0;            // measured processing
+        Ticks budgetTicks = 0;          // the blocks' durations at the host rate
+        Ticks overheadTicks = 0;        // the measurement itself
+        float maxLoad = 0.0f;           // over the instance's life, exact
+    };
+
+    /** Any thread. The counters are copied one by one, so a block finishing mid-copy may
+        be in some and not others: negligible next to a window of hundreds.
+    */
+    Snapshot getSnapshot() const noexcept;
+
+    struct Summary
+    {
+        std::uint64_t blocks = 0;
+        double meanUs = 0.0;            // per block
+        double meanLoad = 0.0;          // share of the block's duration: 1 is the whole budget
+        double p99Load = 0.0;
+        double maxLoad = 0.0;           // exact from the start, else to the bin
+        double overhead = 0.0;          // share of the measured cost spent measuring it
+    };
+
+    /** The blocks between two snapshots; pass a default Snapshot as earlier for everything so far. */
+    static Summary summarise (const Snapshot& later, const Snapshot& earlier) noexcept;
+
+private:
+    void record (Ticks start, Ticks end, int numSamples) noexcept;
+
+    template <typename T>
+    static void add (std::atomic<T>& counter, T amount) noexcept
+    {
+        // Only the audio thread writes, so load + store is enough
+        counter.store (counter.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    double ticksPerSample = 0.0;
+
+    std::array<std::atomic<std::uint32_t>, kNumBins> bins {};
+    std::atomic<std::uint64_t> blocks { 0 };
+    std::atomic<Ticks> busyTicks { 0 }, budgetTicks { 0 }, overheadTicks { 0 };
+    std::atomic<float> maxLoad { 0.0f };
+};
+
+} // namespace htmltovst
@@ -0,0 +1,646 @@
+#include "DriveKernel.h"
+#include "SimdLanes.h"   // ISA detection + intrinsics headers
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <cmath>
+
+// GCC/Clang need per-function target attributes to emit AVX2 code in a TU compiled
+// for the baseline ISA. MSVC allows the intrinsics anywhere.
+#if HTMLTOVST_X86_SIMD && ! defined (_MSC_VER)
+  #define HTMLTOVST_TARGET_AVX2 __attribute__ ((target ("avx2,fma")))
+#else
+  #define HTMLTOVST_TARGET_AVX2
+#endif
+
+namespace htmltovst
+{
+
+//==============================================================================
+void GainRamp::reset (double sampleRate, double rampLengthSeconds) noexcept
+{
+    stepsToTarget = (int) std::floor (rampLengthSeconds * sampleRate);
+    setCurrentAndTarget (target);
+}
+
+void GainRamp::setCurrentAndTarget (float newValue) noexcept
+{
+    target = current = newValue;
+    countdown = 0;
+}
+
+void GainRamp::setTarget (float newValue) noexcept
+{
+    if (juce::exactlyEqual (newValue, target))
+        return;
+
+    if (stepsToTarget <= 0)
+    {
+        setCurrentAndTarget (newValue);
+        return;
+    }
+
+    target = newValue;
+    countdown = stepsToTarget;
+    step = (target - current) / (float) countdown;
+}
+
+RampSegment GainRamp::getSegment() const noexcept
+{
+    if (countdown <= 0)
+        return RampSegment::constant (target);
+
+    return { current, step, countdown, target };
+}
+
+void GainRamp::skip (int numSamples) noexcept
+{
+    if (numSamples >= countdown)
+    {
+        setCurrentAndTarget (target);
+        return;
+    }
+
+    current += step * (float) numSamples;
+    countdown -= numSamples;
+}
+
+//==============================================================================
+namespace DriveKernel
+{
+
+// [7/6] Pade approximant of tanh, exact to ~1e-4 once the input is clamped to +-4.97.
+static constexpr float kTanhClamp = 4.97f;
+
+template <typename SampleType>
+static inline SampleType padeTanh (SampleType x) noexcept
+{
+    constexpr auto limit = (SampleType) kTanhClamp;
+    x = juce::jlimit (-limit, limit, x);
+    const SampleType x2 = x * x;
+    const SampleType num = x * ((SampleType) 135135 + x2 * ((SampleType) 17325 + x2 * ((SampleType) 378 + x2)));
+    const SampleType den = (SampleType) 135135 + x2 * ((SampleType) 62370 + x2 * ((SampleType) 3150 + x2 * (SampleType) 28));
+    return num / den;
+}
+
+float fastTanh (float x) noexcept     { return padeTanh (x); }
+double fastTanh (double x) noexcept   { return padeTanh (x); }
+
+// The ramps themselves are always float (they are what juce::SmoothedValue<float> yields)
+static inline float rampValue (const RampSegment& s, int i) noexcept
+{
+    return (i + 1) < s.count ? s.start + s.step * (float) (i + 1) : s.target;
+}
+
+template <typename SampleType>
+static void processScalarRange (SampleType* const* channels, int numChannels, int begin, int end,
+                                const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    for (int i = begin; i < end; ++i)
+    {
+        const auto a = (SampleType) rampValue (pre, i) * (SampleType) rampValue (drive, i);
+        const auto g = (SampleType) rampValue (post, i);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch][i] = g * fastTanh (a * channels[ch][i]);
+    }
+}
+
+template <typename SampleType>
+static void processScalar (SampleType* const* channels, int numChannels, int numSamples,
+                           const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    processScalarRange (channels, numChannels, 0, numSamples, pre, drive, post);
+}
+
+static bool anyRamping (const RampSegment& a, const RampSegment& b, const RampSegment& c) noexcept
+{
+    return a.isRamping() || b.isRamping() || c.isRamping();
+}
+
+//==============================================================================
+#if HTMLTOVST_X86_SIMD
+
+static inline __m128 tanhSse (__m128 x) noexcept
+{
+    x = _mm_min_ps (_mm_max_ps (x, _mm_set1_ps (-kTanhClamp)), _mm_set1_ps (kTanhClamp));
+    const auto x2 = _mm_mul_ps (x, x);
+
+    auto num = _mm_add_ps (x2, _mm_set1_ps (378.0f));
+    num = _mm_add_ps (_mm_mul_ps (num, x2), _mm_set1_ps (17325.0f));
+    num = _mm_add_ps (_mm_mul_ps (num, x2), _mm_set1_ps (135135.0f));
+    num = _mm_mul_ps (num, x);
+
+    auto den = _mm_add_ps (_mm_mul_ps (x2, _mm_set1_ps (28.0f)), _mm_set1_ps (3150.0f));
+    den = _mm_add_ps (_mm_mul_ps (den, x2), _mm_set1_ps (62370.0f));
+    den = _mm_add_ps (_mm_mul_ps (den, x2), _mm_set1_ps (135135.0f));
+
+    return _mm_div_ps (num, den);
+}
+
+static inline __m128 rampSse (const RampSegment& s, __m128 idx) noexcept
+{
+    const auto ramp = _mm_add_ps (_mm_set1_ps (s.start), _mm_mul_ps (_mm_set1_ps (s.step), idx));
+    const auto mask = _mm_cmplt_ps (idx, _mm_set1_ps ((float) s.count));
+    return _mm_or_ps (_mm_and_ps (mask, ramp), _mm_andnot_ps (mask, _mm_set1_ps (s.target)));
+}
+
+static void processSse2 (float* const* channels, int numChannels, int numSamples,
+                         const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    const int vecEnd = numSamples & ~3;
+    const bool ramping = anyRamping (pre, drive, post);
+    const auto a0 = _mm_set1_ps (pre.target * drive.target);
+    const auto g0 = _mm_set1_ps (post.target);
+
+    if (! ramping)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* x = channels[ch];
+
+            for (int i = 0; i < vecEnd; i += 4)
+                _mm_storeu_ps (x + i, _mm_mul_ps (g0, tanhSse (_mm_mul_ps (a0, _mm_loadu_ps (x + i)))));
+        }
+    }
+    else
+    {
+        auto idx = _mm_setr_ps (1.0f, 2.0f, 3.0f, 4.0f);
+        const auto four = _mm_set1_ps (4.0f);
+
+        // The ramps are the same for every channel: build each vector once, apply it to all of them
+        for (int i = 0; i < vecEnd; i += 4, idx = _mm_add_ps (idx, four))
+        {
+            const auto a = _mm_mul_ps (rampSse (pre, idx), rampSse (drive, idx));
+            const auto g = rampSse (post, idx);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* x = channels[ch];
+                _mm_storeu_ps (x + i, _mm_mul_ps (g, tanhSse (_mm_mul_ps (a, _mm_loadu_ps (x + i)))));
+            }
+        }
+    }
+
+    processScalarRange (channels, numChannels, vecEnd, numSamples, pre, drive, post);
+}
+
+// Double: same kernel, two lanes
+static inline __m128d tanhSse (__m128d x) noexcept
+{
+    x = _mm_min_pd (_mm_max_pd (x, _mm_set1_pd (-kTanhClamp)), _mm_set1_pd (kTanhClamp));
+    const auto x2 = _mm_mul_pd (x, x);
+
+    auto num = _mm_add_pd (x2, _mm_set1_pd (378.0));
+    num = _mm_add_pd (_mm_mul_pd (num, x2), _mm_set1_pd (17325.0));
+    num = _mm_add_pd (_mm_mul_pd (num, x2), _mm_set1_pd (135135.0));
+    num = _mm_mul_pd (num, x);
+
+    auto den = _mm_add_pd (_mm_mul_pd (x2, _mm_set1_pd (28.0)), _mm_set1_pd (3150.0));
+    den = _mm_add_pd (_mm_mul_pd (den, x2), _mm_set1_pd (62370.0));
+    den = _mm_add_pd (_mm_mul_pd (den, x2), _mm_set1_pd (135135.0));
+
+    return _mm_div_pd (num, den);
+}
+
+static inline __m128d rampSse (const RampSegment& s, __m128d idx) noexcept
+{
+    const auto ramp = _mm_add_pd (_mm_set1_pd (s.start), _mm_mul_pd (_mm_set1_pd (s.step), idx));
+    const auto mask = _mm_cmplt_pd (idx, _mm_set1_pd ((double) s.count));
+    return _mm_or_pd (_mm_and_pd (mask, ramp), _mm_andnot_pd (mask, _mm_set1_pd (s.target)));
+}
+
+static void processSse2 (double* const* channels, int numChannels, int numSamples,
+                         const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    const int vecEnd = numSamples & ~1;
+    const bool ramping = anyRamping (pre, drive, post);
+    const auto a0 = _mm_set1_pd ((double) pre.target * drive.target);
+    const auto g0 = _mm_set1_pd (post.target);
+
+    if (! ramping)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* x = channels[ch];
+
+            for (int i = 0; i < vecEnd; i += 2)
+                _mm_storeu_pd (x + i, _mm_mul_pd (g0, tanhSse (_mm_mul_pd (a0, _mm_loadu_pd (x + i)))));
+        }
+    }
+    else
+    {
+        auto idx = _mm_setr_pd (1.0, 2.0);
+        const auto two = _mm_set1_pd (2.0);
+
+        // The ramps are the same for every channel: build each vector once, apply it to all of them
+        for (int i = 0; i < vecEnd; i += 2, idx = _mm_add_pd (idx, two))
+        {
+            const auto a = _mm_mul_pd (rampSse (pre, idx), rampSse (drive, idx));
+            const auto g = rampSse (post, idx);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* x = channels[ch];
+                _mm_storeu_pd (x + i, _mm_mul_pd (g, tanhSse (_mm_mul_pd (a, _mm_loadu_pd (x + i)))));
+            }
+        }
+    }
+
+    processScalarRange (channels, numChannels, vecEnd, numSamples, pre, drive, post);
+}
+
+//==============================================================================
+HTMLTOVST_TARGET_AVX2 static inline __m256 tanhAvx2 (__m256 x) noexcept
+{
+    x = _mm256_min_ps (_mm256_max_ps (x, _mm256_set1_ps (-kTanhClamp)), _mm256_set1_ps (kTanhClamp));
+    const auto x2 = _mm256_mul_ps (x, x);
+
+    auto num = _mm256_add_ps (x2, _mm256_set1_ps (378.0f));
+    num = _mm256_fmadd_ps (num, x2, _mm256_set1_ps (17325.0f));
+    num = _mm256_fmadd_ps (num, x2, _mm256_set1_ps (135135.0f));
+    num = _mm256_mul_ps (num, x);
+
+    auto den = _mm256_fmadd_ps (x2, _mm256_set1_ps (28.0f), _mm256_set1_ps (3150.0f));
+    den = _mm256_fmadd_ps (den, x2, _mm256_set1_ps (62370.0f));
+    den = _mm256_fmadd_ps (den, x2, _mm256_set1_ps (135135.0f));
+
+    return _mm256_div_ps (num, den);
+}
+
+HTMLTOVST_TARGET_AVX2 static inline __m256 rampAvx2 (const RampSegment& s, __m256 idx) noexcept
+{
+    const auto ramp = _mm256_fmadd_ps (_mm256_set1_ps (s.step), idx, _mm256_set1_ps (s.start));
+    const auto mask = _mm256_cmp_ps (idx, _mm256_set1_ps ((float) s.count), _CMP_LT_OQ);
+    return _mm256_blendv_ps (_mm256_set1_ps (s.target), ramp, mask);
+}
+
+HTMLTOVST_TARGET_AVX2 static void processAvx2 (float* const* channels, int numChannels, int numSamples,
+                                               const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    const int vecEnd = numSamples & ~7;
+    const bool ramping = anyRamping (pre, drive, post);
+    const auto a0 = _mm256_set1_ps (pre.target * drive.target);
+    const auto g0 = _mm256_set1_ps (post.target);
+
+    if (! ramping)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* x = channels[ch];
+
+            for (int i = 0; i < vecEnd; i += 8)
+                _mm256_storeu_ps (x + i, _mm256_mul_ps (g0, tanhAvx2 (_mm256_mul_ps (a0, _mm256_loadu_ps (x + i)))));
+        }
+    }
+    else
+    {
+        auto idx = _mm256_setr_ps (1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+        const auto eight = _mm256_set1_ps (8.0f);
+
+        // The ramps are the same for every channel: build each vector once, apply it to all of them
+        for (int i = 0; i < vecEnd; i += 8, idx = _mm256_add_ps (idx, eight))
+        {
+            const auto a = _mm256_mul_ps (rampAvx2 (pre, idx), rampAvx2 (drive, idx));
+            const auto g = rampAvx2 (post, idx);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* x = channels[ch];
+                _mm256_storeu_ps (x + i, _mm256_mul_ps (g, tanhAvx2 (_mm256_mul_ps (a, _mm256_loadu_ps (x + i)))));
+            }
+        }
+    }
+
+    processScalarRange (channels, numChannels, vecEnd, numSamples, pre, drive, post);
+}
+
+HTMLTOVST_TARGET_AVX2 static inline __m256d tanhAvx2 (__m256d x) noexcept
+{
+    x = _mm256_min_pd (_mm256_max_pd (x, _mm256_set1_pd (-kTanhClamp)), _mm256_set1_pd (kTanhClamp));
+    const auto x2 = _mm256_mul_pd (x, x);
+
+    auto num = _mm256_add_pd (x2, _mm256_set1_pd (378.0));
+    num = _mm256_fmadd_pd (num, x2, _mm256_set1_pd (17325.0));
+    num = _mm256_fmadd_pd (num, x2, _mm256_set1_pd (135135.0));
+    num = _mm256_mul_pd (num, x);
+
+    auto den = _mm256_fmadd_pd (x2, _mm256_set1_pd (28.0), _mm256_set1_pd (3150.0));
+    den = _mm256_fmadd_pd (den, x2, _mm256_set1_pd (62370.0));
+    den = _mm256_fmadd_pd (den, x2, _mm256_set1_pd (135135.0));
+
+    return _mm256_div_pd (num, den);
+}
+
+HTMLTOVST_TARGET_AVX2 static inline __m256d rampAvx2 (const RampSegment& s, __m256d idx) noexcept
+{
+    const auto ramp = _mm256_fmadd_pd (_mm256_set1_pd (s.step), idx, _mm256_set1_pd (s.start));
+    const auto mask = _mm256_cmp_pd (idx, _mm256_set1_pd ((double) s.count), _CMP_LT_OQ);
+    return _mm256_blendv_pd (_mm256_set1_pd (s.target), ramp, mask);
+}
+
+HTMLTOVST_TARGET_AVX2 static void processAvx2 (double* const* channels, int numChannels, int numSamples,
+                                               const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    const int vecEnd = numSamples & ~3;
+    const bool ramping = anyRamping (pre, drive, post);
+    const auto a0 = _mm256_set1_pd ((double) pre.target * drive.target);
+    const auto g0 = _mm256_set1_pd (post.target);
+
+    if (! ramping)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* x = channels[ch];
+
+            for (int i = 0; i < vecEnd; i += 4)
+                _mm256_storeu_pd (x + i, _mm256_mul_pd (g0, tanhAvx2 (_mm256_mul_pd (a0, _mm256_loadu_pd (x + i)))));
+        }
+    }
+    else
+    {
+        auto idx = _mm256_setr_pd (1.0, 2.0, 3.0, 4.0);
+        const auto four = _mm256_set1_pd (4.0);
+
+        // The ramps are the same for every channel: build each vector once, apply it to all of them
+        for (int i = 0; i < vecEnd; i += 4, idx = _mm256_add_pd (idx, four))
+        {
+            const auto a = _mm256_mul_pd (rampAvx2 (pre, idx), rampAvx2 (drive, idx));
+            const auto g = rampAvx2 (post, idx);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* x = channels[ch];
+                _mm256_storeu_pd (x + i, _mm256_mul_pd (g, tanhAvx2 (_mm256_mul_pd (a, _mm256_loadu_pd (x + i)))));
+            }
+        }
+    }
+
+    processScalarRange (channels, numChannels, vecEnd, numSamples, pre, drive, post);
+}
+
+#endif // HTMLTOVST_X86_SIMD
+
+//==============================================================================
+#if HTMLTOVST_NEON_SIMD
+
+static inline float32x4_t tanhNeon (float32x4_t x) noexcept
+{
+    x = vminq_f32 (vmaxq_f32 (x, vdupq_n_f32 (-kTanhClamp)), vdupq_n_f32 (kTanhClamp));
+    const auto x2 = vmulq_f32 (x, x);
+
+    auto num = vaddq_f32 (x2, vdupq_n_f32 (378.0f));
+    num = vfmaq_f32 (vdupq_n_f32 (17325.0f), num, x2);
+    num = vfmaq_f32 (vdupq_n_f32 (135135.0f), num, x2);
+    num = vmulq_f32 (num, x);
+
+    auto den = vfmaq_f32 (vdupq_n_f32 (3150.0f), x2, vdupq_n_f32 (28.0f));
+    den = vfmaq_f32 (vdupq_n_f32 (62370.0f), den, x2);
+    den = vfmaq_f32 (vdupq_n_f32 (135135.0f), den, x2);
+
+    return vdivq_f32 (num, den);
+}
+
+static inline float32x4_t rampNeon (const RampSegment& s, float32x4_t idx) noexcept
+{
+    const auto ramp = vfmaq_f32 (vdupq_n_f32 (s.start), vdupq_n_f32 (s.step), idx);
+    const auto mask = vcltq_f32 (idx, vdupq_n_f32 ((float) s.count));
+    return vbslq_f32 (mask, ramp, vdupq_n_f32 (s.target));
+}
+
+static void processNeon (float* const* channels, int numChannels, int numSamples,
+                         const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    const int vecEnd = numSamples & ~3;
+    const bool ramping = anyRamping (pre, drive, post);
+    const auto a0 = vdupq_n_f32 (pre.target * drive.target);
+    const auto g0 = vdupq_n_f32 (post.target);
+
+    if (! ramping)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* x = channels[ch];
+
+            for (int i = 0; i < vecEnd; i += 4)
+                vst1q_f32 (x + i, vmulq_f32 (g0, tanhNeon (vmulq_f32 (a0, vld1q_f32 (x + i)))));
+        }
+    }
+    else
+    {
+        const float first[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+        auto idx = vld1q_f32 (first);
+        const auto four = vdupq_n_f32 (4.0f);
+
+        // The ramps are the same for every channel: build each vector once, apply it to all of them
+        for (int i = 0; i < vecEnd; i += 4, idx = vaddq_f32 (idx, four))
+        {
+            const auto a = vmulq_f32 (rampNeon (pre, idx), rampNeon (drive, idx));
+            const auto g = rampNeon (post, idx);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* x = channels[ch];
+                vst1q_f32 (x + i, vmulq_f32 (g, tanhNeon (vmulq_f32 (a, vld1q_f32 (x + i)))));
+            }
+        }
+    }
+
+    processScalarRange (channels, numChannels, vecEnd, numSamples, pre, drive, post);
+}
+
+static inline float64x2_t tanhNeon (float64x2_t x) noexcept
+{
+    x = vminq_f64 (vmaxq_f64 (x, vdupq_n_f64 (-kTanhClamp)), vdupq_n_f64 (kTanhClamp));
+    const auto x2 = vmulq_f64 (x, x);
+
+    auto num = vaddq_f64 (x2, vdupq_n_f64 (378.0));
+    num = vfmaq_f64 (vdupq_n_f64 (17325.0), num, x2);
+    num = vfmaq_f64 (vdupq_n_f64 (135135.0), num, x2);
+    num = vmulq_f64 (num, x);
+
+    auto den = vfmaq_f64 (vdupq_n_f64 (3150.0), x2, vdupq_n_f64 (28.0));
+    den = vfmaq_f64 (vdupq_n_f64 (62370.0), den, x2);
+    den = vfmaq_f64 (vdupq_n_f64 (135135.0), den, x2);
+
+    return vdivq_f64 (num, den);
+}
+
+static inline float64x2_t rampNeon (const RampSegment& s, float64x2_t idx) noexcept
+{
+    const auto ramp = vfmaq_f64 (vdupq_n_f64 (s.start), vdupq_n_f64 (s.step), idx);
+    const auto mask = vcltq_f64 (idx, vdupq_n_f64 ((double) s.count));
+    return vbslq_f64 (mask, ramp, vdupq_n_f64 (s.target));
+}
+
+static void processNeon (double* const* channels, int numChannels, int numSamples,
+                         const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    const int vecEnd = numSamples & ~1;
+    const bool ramping = anyRamping (pre, drive, post);
+    const auto a0 = vdupq_n_f64 ((double) pre.target * drive.target);
+    const auto g0 = vdupq_n_f64 (post.target);
+
+    if (! ramping)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* x = channels[ch];
+
+            for (int i = 0; i < vecEnd; i += 2)
+                vst1q_f64 (x + i, vmulq_f64 (g0, tanhNeon (vmulq_f64 (a0, vld1q_f64 (x + i)))));
+        }
+    }
+    else
+    {
+        const double first[2] = { 1.0, 2.0 };
+        auto idx = vld1q_f64 (first);
+        const auto two = vdupq_n_f64 (2.0);
+
+        // The ramps are the same for every channel: build each vector once, apply it to all of them
+        for (int i = 0; i < vecEnd; i += 2, idx = vaddq_f64 (idx, two))
+        {
+            const auto a = vmulq_f64 (rampNeon (pre, idx), rampNeon (drive, idx));
+            const auto g = rampNeon (post, idx);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* x = channels[ch];
+                vst1q_f64 (x + i, vmulq_f64 (g, tanhNeon (vmulq_f64 (a, vld1q_f64 (x + i)))));
+            }
+        }
+    }
+
+    processScalarRange (channels, numChannels, vecEnd, numSamples, pre, drive, post);
+}
+
+#endif // HTMLTOVST_NEON_SIMD
+
+//==============================================================================
+bool isSupported (Isa isa) noexcept
+{
+    switch (isa)
+    {
+        case Isa::scalar: return true;
+       #if HTMLTOVST_X86_SIMD
+        case Isa::sse2:   return true; // baseline on x86-64
+        case Isa::avx2:   return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+       #else
+        case Isa::sse2:
+        case Isa::avx2:   return false;
+       #endif
+        case Isa::neon:   return HTMLTOVST_NEON_SIMD != 0;
+    }
+
+    return false;
+}
+
+const char* getIsaName (Isa isa) noexcept
+{
+    switch (isa)
+    {
+        case Isa::scalar: return "scalar";
+        case Isa::sse2:   return "sse2";
+        case Isa::avx2:   return "avx2";
+        case Isa::neon:   return "neon";
+    }
+
+    return "unknown";
+}
+
+Isa getBestIsa() noexcept
+{
+    static const Isa best = []
+    {
+        for (auto isa : { Isa::avx2, Isa::neon, Isa::sse2 })
+            if (isSupported (isa))
+                return isa;
+
+        return Isa::scalar;
+    }();
+
+    return best;
+}
+
+// Every variant is overloaded on the sample type; the return type picks the overload.
+template <typename SampleType>
+ProcessFn<SampleType> getProcessFunction (Isa isa) noexcept
+{
+    if (! isSupported (isa))
+        return processScalar<SampleType>;
+
+    switch (isa)
+    {
+        case Isa::scalar: break;
+       #if HTMLTOVST_X86_SIMD
+        case Isa::sse2:   return processSse2;
+        case Isa::avx2:   return processAvx2;
+       #else
+        case Isa::sse2:
+        case Isa::avx2:   break;
+       #endif
+       #if HTMLTOVST_NEON_SIMD
+        case Isa::neon:   return processNeon;
+       #else
+        case Isa::neon:   break;
+       #endif
+    }
+
+    return processScalar<SampleType>;
+}
+
+template ProcessFn<float>  getProcessFunction<float>  (Isa) noexcept;
+template ProcessFn<double> getProcessFunction<double> (Isa) noexcept;
+
+template <typename SampleType>
+static void applyGainImpl (SampleType* const* channels, int numChannels, int numSamples,
+                           const RampSegment& a, const RampSegment& b) noexcept
+{
+    if (! a.isRamping() && ! b.isRamping())
+    {
+        const auto g = (SampleType) (a.target * b.target);
+
+        if (! juce::exactlyEqual (g, (SampleType) 1))
+            for (int ch = 0; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::multiply (channels[ch], g, numSamples);
+
+        return;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* x = channels[ch];
+
+        for (int i = 0; i < numSamples; ++i)
+            x[i] *= (SampleType) (rampValue (a, i) * rampValue (b, i));
+    }
+}
+
+void applyGain (float* const* channels, int numChannels, int numSamples,
+                const RampSegment& a, const RampSegment& b) noexcept
+{
+    applyGainImpl (channels, numChannels, numSamples, a, b);
+}
+
+void applyGain (double* const* channels, int numChannels, int numSamples,
+                const RampSegment& a, const RampSegment& b) noexcept
+{
+    applyGainImpl (channels, numChannels, numSamples, a, b);
+}
+
+void process (float* const* channels, int numChannels, int numSamples,
+              const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    static const ProcessFn<float> best = getProcessFunction<float> (getBestIsa());
+    best (channels, numChannels, numSamples, pre, drive, post);
+}
+
+void process (double* const* channels, int numChannels, int numSamples,
+              const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept
+{
+    static const ProcessFn<double> best = getProcessFunction<double> (getBestIsa());
+    best (channels, numChannels, numSamples, pre, drive, post);
+}
+
+} // namespace DriveKernel
+} // namespace htmltovst
@@ -0,0 +1,113 @@
+#pragma once
+
+//==============================================================================
+// Fused inGain -> drive -> tanh -> outGain kernel.
+//
+// One pass applies the three smoothed gains and a bounded-error tanh approximation.
+// Each ramp vector is built once per step and applied to every channel, so wide
+// (surround) layouts pay for the smoothing once, not per channel. The ISA-specific
+// variant (scalar / SSE2 / AVX2+FMA / NEON) is picked once at runtime from the host
+// CPU. Every variant exists for float and double buffers, so a 64-bit host's samples
+// never go through a conversion.
+//==============================================================================
+
+namespace htmltovst
+{
+
+/** A block-sized slice of a linear gain ramp.
+
+    Sample i (0-based) of the block gets:
+        (i + 1) < count ? start + step * (i + 1) : target
+
+    which is exactly what juce::SmoothedValue<float, Linear>::getNextValue() yields,
+    so the fused kernel nulls against the juce::dsp::Gain reference chain.
+*/
+struct RampSegment
+{
+    float start  = 1.0f;
+    float step   = 0.0f;
+    int   count  = 0;
+    float target = 1.0f;
+
+    bool isRamping() const noexcept { return count > 1; }
+
+    /** The same ramp seen at an oversampled rate (factor samples per host sample). */
+    RampSegment stretched (int factor) const noexcept
+    {
+        return { start, step / (float) factor, count * factor, target };
+    }
+
+    static RampSegment constant (float value) noexcept { return { value, 0.0f, 0, value }; }
+};
+
+/** Linear gain smoother with the same semantics as juce::SmoothedValue<float>,
+    but able to hand out whole-block RampSegments instead of per-sample values.
+*/
+class GainRamp
+{
+public:
+    void reset (double sampleRate, double rampLengthSeconds) noexcept;
+
+    void setCurrentAndTarget (float newValue) noexcept;
+    void setTarget (float newValue) noexcept;
+
+    float getCurrent() const noexcept  { return current; }
+    float getTarget() const noexcept   { return target; }
+    bool isSmoothing() const noexcept  { return countdown > 0; }
+
+    /** Describes the next block without advancing. */
+    RampSegment getSegment() const noexcept;
+
+    /** Advances the ramp by numSamples. */
+    void skip (int numSamples) noexcept;
+
+private:
+    float current = 0.0f, target = 0.0f, step = 0.0f;
+    int countdown = 0, stepsToTarget = 0;
+};
+
+namespace DriveKernel
+{
+    enum class Isa
+    {
+        scalar,
+        sse2,
+        avx2,
+        neon
+    };
+
+    /** y = post * tanh (drive * pre * x), in place on every channel. */
+    template <typename SampleType>
+    using ProcessFn = void (*) (SampleType* const* channels, int numChannels, int numSamples,
+                                const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept;
+
+    /** Best ISA supported by this build and this CPU (resolved once). */
+    Isa getBestIsa() noexcept;
+
+    bool isSupported (Isa isa) noexcept;
+    const char* getIsaName (Isa isa) noexcept;
+
+    /** The variant for a given ISA; falls back to scalar if unsupported.
+        Instantiated for float and double.
+    */
+    template <typename SampleType>
+    ProcessFn<SampleType> getProcessFunction (Isa isa) noexcept;
+
+    /** Runs the best available variant. */
+    void process (float* const* channels, int numChannels, int numSamples,
+                  const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept;
+    void process (double* const* channels, int numChannels, int numSamples,
+                  const RampSegment& pre, const RampSegment& drive, const RampSegment& post) noexcept;
+
+    /** y = a * b * x in place, no shaper (for engines that bring their own nonlinearity). */
+    void applyGain (float* const* channels, int numChannels, int numSamples,
+                    const RampSegment& a, const RampSegment& b) noexcept;
+    void applyGain (double* const* channels, int numChannels, int numSamples,
+                    const RampSegment& a, const RampSegment& b) noexcept;
+
+    /** Scalar fast tanh used by every variant (|error| < 1e-4 over the whole real line). */
+    float fastTanh (float x) noexcept;
+    double fastTanh (double x) noexcept;
+}
+
+} // namespace htmltovst
@@ -0,0 +1,929 @@
+#include "EngineGraph.h"
+#include "SharedTables.h"
+
+#if HTMLTOVST_ENGINE_DATA
+  #include "EngineData.h"
+#endif
+
+#include <cmath>
+#include <type_traits>
+
+namespace htmltovst
+{
+
+//==============================================================================
+namespace
+{
+
+struct NodeTypeInfo
+{
+    const char* name;
+    NodeType type;
+    int numInputs;
+    std::array<const char*, EngineSpec::kMaxRoles> roles;
+    std::array<float, EngineSpec::kMaxRoles> defaults;
+};
+
+// Roles in the order a node's params are stored; unbound roles take the default
+const NodeTypeInfo kNodeTypes[] =
+{
+    { "gain",     NodeType::gain,     1, { "db" },     { 0.0f } },
+    { "drive",    NodeType::drive,    1, { "amount" }, { 0.0f } },
+    { "tape",     NodeType::tape,     1, { "drive", "tapeType", "flux", "bias", "recordDb", "reproDb", "autoCal", "solver", "eq", "speed" },
+                                         { 0.0f, 1.0f, TapeHysteresis::kReferenceFluxivity, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 15.0f } },
+    { "mix",      NodeType::mix,      2, { "mix" },    { 0.5f } },
+    { "lowpass",  NodeType::lowpass,  1, { "hz" },     { 20000.0f } },
+    { "highpass", NodeType::highpass, 1, { "hz" },     { 20.0f } }
+};
+
+namespace TapeRole
+{
+    enum { drive, tapeType, flux, bias, recordDb, reproDb, autoCal, solver, eq, speed };
+}
+
+const NodeTypeInfo* findNodeType (const juce::String& name) noexcept
+{
+    for (const auto& info : kNodeTypes)
+        if (name == info.name)
+            return &info;
+
+    return nullptr;
+}
+
+const NodeTypeInfo& getNodeType (NodeType type) noexcept
+{
+    for (const auto& info : kNodeTypes)
+        if (info.type == type)
+            return info;
+
+    jassertfalse;
+    return kNodeTypes[0];
+}
+
+int findRole (const NodeTypeInfo& info, const juce::String& role) noexcept
+{
+    for (int r = 0; r < EngineSpec::kMaxRoles && info.roles[(size_t) r] != nullptr; ++r)
+        if (role == info.roles[(size_t) r])
+            return r;
+
+    return -1;
+}
+
+bool isNumber (const juce::var& v) noexcept
+{
+    return v.isInt() || v.isInt64() || v.isDouble();
+}
+
+float getDriveFactor (float amount) noexcept
+{
+    return 1.0f + 12.0f * juce::jlimit (0.0f, 1.0f, amount);    // 1x..13x, as the fused chain
+}
+
+} // namespace
+
+//==============================================================================
+std::unique_ptr<const EngineSpec> EngineSpec::parse (const juce::String& json, juce::String& error)
+{
+    juce::var root;
+
+    if (const auto result = juce::JSON::parse (json, root); result.failed())
+    {
+        error = result.getErrorMessage();
+        return nullptr;
+    }
+
+    // The converter's { ok, spec } envelope, or the spec itself
+    if (root.hasProperty ("spec"))
+        root = root["spec"];
+
+    if (! root.isObject())
+    {
+        error = "not a JSON object";
+        return nullptr;
+    }
+
+    auto spec = std::make_unique<EngineSpec>();
+    spec->name = root["name"].toString();
+
+    if (const auto* params = root["params"].getArray())
+        for (const auto& p : *params)
+            if (! spec->addParam (p, error))
+                return nullptr;
+
+    const auto* graph = root["graph"].getArray();
+
+    if (graph == nullptr || graph->isEmpty())
+    {
+        error = "no graph";
+        return nullptr;
+    }
+
+    for (const auto& n : *graph)
+        if (! spec->addNode (n, error))
+            return nullptr;
+
+    return spec;
+}
+
+// Mirrors the generator's toTableEntry(), so an @plugin spec's params load unchanged
+bool EngineSpec::addParam (const juce::var& p, juce::String& error)
+{
+    const auto id = p["id"].toString();
+
+    if (id.isEmpty())
+    {
+        error = "a parameter has no id";
+        return false;
+    }
+
+    for (const auto& existing : params)
+    {
+        if (id == existing.id)
+        {
+            error = "parameter '" + id + "' is defined twice";
+            return false;
+        }
+    }
+
+    HtmlToVstParamSpec s {};
+    s.id    = store (id);
+    s.label = store (p.hasProperty ("label") ? p["label"].toString() : id);
+    s.type  = HtmlToVstParamType::knob;
+    s.maxValue = 1.0;
+
+    const auto type = p.getProperty ("type", "knob").toString();
+
+    if (type == "bool")
+    {
+        s.type = HtmlToVstParamType::toggle;
+        s.defaultValue = (bool) p["default"] ? 1.0 : 0.0;
+    }
+    else if (type == "enum")
+    {
+        const auto* options = p["options"].getArray();
+
+        if (options == nullptr || options->isEmpty())
+        {
+            error = "parameter '" + id + "' is an enum without options";
+            return false;
+        }
+
+        // Numeric options keep their value for the DSP, unless "values" overrides them
+        const auto* values = p["values"].getArray();
+        auto& labels = optionLabels.emplace_back();
+        auto& numbers = optionValues.emplace_back();
+        bool foundDefault = false;
+
+        for (int i = 0; i < options->size(); ++i)
+        {
+            const auto& option = options->getReference (i);
+            labels.push_back (store (option.toString()));
+
+            if (values != nullptr && i < values->size())
+                numbers.push_back ((double) values->getReference (i));
+            else
+                numbers.push_back (isNumber (option) ? (double) option : (double) i);
+
+            // The first option matching the default wins
+            if (! foundDefault && p.hasProperty ("default") && option == p["default"])
+            {
+                s.defaultValue = (double) i;
+                foundDefault = true;
+            }
+        }
+
+        s.type = HtmlToVstParamType::choice;
+        s.maxValue = (double) (options->size() - 1);
+        s.interval = 1.0;
+        s.options = labels.data();
+        s.optionValues = numbers.data();
+        s.numOptions = options->size();
+    }
+    else
+    {
+        // "knob", "slider" and anything unknown are continuous
+        if (isNumber (p["min"]))     s.minValue = (double) p["min"];
+        if (isNumber (p["max"]))     s.maxValue = (double) p["max"];
+        if (isNumber (p["default"])) s.defaultValue = (double) p["default"];
+        if (isNumber (p["step"]))    s.interval = (double) p["step"];
+
+        if (! (s.maxValue > s.minValue))
+        {
+            error = "parameter '" + id + "' has an empty range";
+            return false;
+        }
+
+        s.defaultValue = juce::jlimit (s.minValue, s.maxValue, s.defaultValue);
+    }
+
+    params.push_back (s);
+    return true;
+}
+
+bool EngineSpec::addNode (const juce::var& n, juce::String& error)
+{
+    const auto typeName = n["type"].toString();
+    const auto* info = findNodeType (typeName);
+
+    if (info == nullptr)
+    {
+        error = "unknown node type '" + typeName + "'";
+        return false;
+    }
+
+    Node node;
+    node.type = info->type;
+    node.id = n["id"].toString();
+
+    if (node.id == "input")
+    {
+        error = "'input' is reserved for the host buffer";
+        return false;
+    }
+
+    if (const auto* inputs = n["inputs"].getArray())
+        for (const auto& input : *inputs)
+            node.inputs.add (input.toString());
+
+    for (size_t r = 0; r < node.bindings.size(); ++r)
+        node.bindings[r].constant = info->defaults[r];
+
+    if (const auto* bindings = n["params"].getDynamicObject())
+    {
+        for (const auto& binding : bindings->getProperties())
+        {
+            const auto role = findRole (*info, binding.name.toString());
+
+            if (role < 0)
+            {
+                error = typeName + " node has no '" + binding.name.toString() + "'";
+                return false;
+            }
+
+            auto& b = node.bindings[(size_t) role];
+
+            if (binding.value.isString())
+                b.paramId = binding.value.toString();
+            else if (isNumber (binding.value) || binding.value.isBool())
+                b.constant = (float) (double) binding.value;
+            else
+            {
+                error = typeName + "." + binding.name.toString() + " must be a parameter ID or a number";
+                return false;
+            }
+        }
+    }
+
+    nodes.push_back (std::move (node));
+    return true;
+}
+
+const char* EngineSpec::store (const juce::String& text)
+{
+    // A deque never moves its elements, so the pointer stays valid with the spec
+    return strings.emplace_back (text.toStdString()).c_str();
+}
+
+const EngineSpec* EngineSpec::getEmbedded()
+{
+   #if HTMLTOVST_ENGINE_DATA
+    static const auto spec = []
+    {
+        int size = 0;
+        const auto* data = EngineData::getNamedResource (EngineData::namedResourceList[0], size);
+
+        juce::String error;
+        auto parsed = parse (juce::String::fromUTF8 (data, size), error);
+
+        if (parsed == nullptr)
+            juce::Logger::writeToLog ("HTMLtoVST: embedded engine spec ignored: " + error);
+
+        return parsed;
+    }();
+
+    return spec.get();
+   #else
+    return nullptr;
+   #endif
+}
+
+//==============================================================================
+float EngineGraph::ParamRef::get() const noexcept
+{
+    if (value == nullptr)
+        return constant;
+
+    const auto v = value->load (std::memory_order_relaxed);
+
+    if (optionValues == nullptr)
+        return v;
+
+    return (float) optionValues[juce::jlimit (0, numOptions - 1, juce::roundToInt (v))];
+}
+
+float EngineGraph::ParamRef::getGain() const noexcept
+{
+    return juce::Decibels::decibelsToGain (get(), -80.0f);
+}
+
+float EngineGraph::Op::getMainTarget() const noexcept
+{
+    switch (type)
+    {
+        case OpType::gain:  return params[0].getGain();
+        case OpType::drive:
+        case OpType::tape:  return getDriveFactor (params[0].get());
+        case OpType::mix:   return juce::jlimit (0.0f, 1.0f, params[0].get());
+        case OpType::copy:
+        case OpType::lowpass:
+        case OpType::highpass:
+            break;
+    }
+
+    return 1.0f;
+}
+
+//==============================================================================
+bool EngineGraph::compile (const EngineSpec& spec, const Resolver& resolve, juce::String& error)
+{
+    ops.clear();
+    ramps.clear();
+    tapes.clear();
+    filters.clear();
+    numBuffers = 1;
+
+    const auto numNodes = (int) spec.nodes.size();
+
+    if (numNodes == 0)
+    {
+        error = "the graph has no nodes";
+        return false;
+    }
+
+    // Values are numbered -1 (the host input) and 0 .. numNodes - 1 (each node's output)
+    constexpr int hostInput = -1;
+    const auto output = numNodes - 1;
+    std::vector<std::array<int, 2>> inputs ((size_t) numNodes, { hostInput, hostInput });
+    std::vector<int> numInputs ((size_t) numNodes, 1);
+
+    auto findValue = [&spec] (const juce::String& id)
+    {
+        if (id == "input")
+            return hostInput;
+
+        for (size_t i = 0; i < spec.nodes.size(); ++i)
+            if (id == spec.nodes[i].id)
+                return (int) i;
+
+        return -2;
+    };
+
+    for (int i = 0; i < numNodes; ++i)
+    {
+        const auto& node = spec.nodes[(size_t) i];
+        const auto expected = getNodeType (node.type).numInputs;
+        numInputs[(size_t) i] = expected;
+
+        if (node.inputs.isEmpty() && expected == 1)
+        {
+            inputs[(size_t) i][0] = i - 1;
+            continue;
+        }
+
+        if (node.inputs.size() != expected)
+        {
+            error = "node " + juce::String (i) + " needs " + juce::String (expected) + " input(s)";
+            return false;
+        }
+
+        for (int k = 0; k < expected; ++k)
+        {
+            const auto v = findValue (node.inputs[k]);
+
+            if (v < hostInput)
+            {
+                error = "node " + juce::String (i) + " reads unknown node '" + node.inputs[k] + "'";
+                return false;
+            }
+
+            inputs[(size_t) i][(size_t) k] = v;
+        }
+    }
+
+    // Only what the output depends on is scheduled
+    std::vector<bool> live ((size_t) numNodes, false);
+    std::vector<int> stack { output };
+
+    while (! stack.empty())
+    {
+        const auto i = stack.back();
+        stack.pop_back();
+
+        if (live[(size_t) i])
+            continue;
+
+        live[(size_t) i] = true;
+
+        for (int k = 0; k < numInputs[(size_t) i]; ++k)
+            if (inputs[(size_t) i][(size_t) k] >= 0)
+                stack.push_back (inputs[(size_t) i][(size_t) k]);
+    }
+
+    // Topological order, earliest declared first among the ready nodes
+    std::vector<int> order, pending ((size_t) numNodes, 0);
+    int numLive = 0;
+
+    for (int i = 0; i < numNodes; ++i)
+    {
+        if (! live[(size_t) i])
+            continue;
+
+        ++numLive;
+
+        for (int k = 0; k < numInputs[(size_t) i]; ++k)
+            if (inputs[(size_t) i][(size_t) k] >= 0)
+                ++pending[(size_t) i];
+    }
+
+    std::vector<bool> scheduled ((size_t) numNodes, false);
+
+    while ((int) order.size() < numLive)
+    {
+        int next = -1;
+
+        for (int i = 0; i < numNodes && next < 0; ++i)
+            if (live[(size_t) i] && ! scheduled[(size_t) i] && pending[(size_t) i] == 0)
+                next = i;
+
+        if (next < 0)
+        {
+            error = "the graph has a cycle";
+            return false;
+        }
+
+        scheduled[(size_t) next] = true;
+        order.push_back (next);
+
+        for (int i = 0; i < numNodes; ++i)
+            if (live[(size_t) i])
+                for (int k = 0; k < numInputs[(size_t) i]; ++k)
+                    if (inputs[(size_t) i][(size_t) k] == next)
+                        --pending[(size_t) i];
+    }
+
+    // Buffers: a node takes over its input's buffer when it is that value's last reader,
+    // otherwise it gets a free one (released values first) and copies its input in.
+    std::vector<int> readers ((size_t) numNodes + 1, 0), bufferOf ((size_t) numNodes + 1, -1), freeBuffers;
+    auto readersOf = [&readers] (int v) -> int&   { return readers[(size_t) (v + 1)]; };
+    auto bufferFor = [&bufferOf] (int v) -> int&  { return bufferOf[(size_t) (v + 1)]; };
+
+    for (const auto i : order)
+        for (int k = 0; k < numInputs[(size_t) i]; ++k)
+            ++readersOf (inputs[(size_t) i][(size_t) k]);
+
+    ++readersOf (output);
+    bufferFor (hostInput) = 0;
+
+    auto allocate = [&]
+    {
+        if (freeBuffers.empty())
+            return numBuffers++;
+
+        const auto b = freeBuffers.back();
+        freeBuffers.pop_back();
+        return b;
+    };
+
+    auto release = [&] (int v)
+    {
+        if (--readersOf (v) == 0)
+            freeBuffers.push_back (bufferFor (v));
+    };
+
+    auto bind = [&resolve, &error] (const EngineSpec::Binding& b, ParamRef& ref)
+    {
+        ref = {};
+        ref.constant = b.constant;
+
+        if (b.paramId.isEmpty())
+            return true;
+
+        const auto source = resolve (b.paramId);
+
+        if (source.value == nullptr)
+        {
+            error = "unknown parameter '" + b.paramId + "'";
+            return false;
+        }
+
+        ref.value = source.value;
+
+        if (source.spec != nullptr && source.spec->type == HtmlToVstParamType::choice)
+        {
+            ref.optionValues = source.spec->optionValues;
+            ref.numOptions = source.spec->numOptions;
+        }
+
+        return true;
+    };
+
+    std::vector<Op> schedule;
+
+    for (const auto i : order)
+    {
+        const auto& node = spec.nodes[(size_t) i];
+
+        Op op;
+        op.type = node.type == NodeType::gain  ? OpType::gain
+                : node.type == NodeType::drive ? OpType::drive
+                : node.type == NodeType::tape  ? OpType::tape
+                : node.type == NodeType::mix   ? OpType::mix
+                : node.type == NodeType::lowpass ? OpType::lowpass
+                                                 : OpType::highpass;
+
+        for (size_t r = 0; r < op.params.size(); ++r)
+            if (! bind (node.bindings[r], op.params[r]))
+                return false;
+
+        const auto a = inputs[(size_t) i][0];
+
+        if (numInputs[(size_t) i] == 1)
+        {
+            if (readersOf (a) == 1)
+            {
+                op.dst = bufferFor (a);
+                readersOf (a) = 0;
+            }
+            else
+            {
+                op.dst = allocate();
+                op.src = bufferFor (a);
+                release (a);
+            }
+        }
+        else
+        {
+            const auto b = inputs[(size_t) i][1];
+
+            if (a != b && readersOf (a) == 1)
+            {
+                op.dst = bufferFor (a);
+                op.other = bufferFor (b);
+                readersOf (a) = 0;
+                release (b);
+            }
+            else if (a != b && readersOf (b) == 1)
+            {
+                op.dst = bufferFor (b);
+                op.other = bufferFor (a);
+                op.swapped = true;
+                readersOf (b) = 0;
+                release (a);
+            }
+            else
+            {
+                op.dst = allocate();
+                op.src = bufferFor (a);
+                op.other = bufferFor (b);
+                release (a);
+                release (b);
+            }
+        }
+
+        bufferFor (i) = op.dst;
+        schedule.push_back (op);
+    }
+
+    if (bufferFor (output) != 0)
+    {
+        Op copy;
+        copy.dst = 0;
+        copy.src = bufferFor (output);
+        schedule.push_back (copy);
+    }
+
+    if (numBuffers > kMaxBuffers)
+    {
+        error = "the graph needs more than " + juce::String (kMaxBuffers) + " buffers";
+        numBuffers = 1;
+        return false;
+    }
+
+    // Gains working in place right before or after a drive / tape node ride along with its
+    // own ramps, as in the hand-written chain, instead of costing a pass each.
+    for (auto& op : schedule)
+    {
+        const auto isShaper = op.type == OpType::drive || op.type == OpType::tape;
+
+        if (isShaper && op.src < 0 && ! ops.empty())
+        {
+            const auto& prev = ops.back();
+
+            if (prev.type == OpType::gain && prev.dst == op.dst)
+            {
+                op.hasPre = true;
+                op.pre = prev.params[0];
+                op.src = prev.src;
+                ops.pop_back();
+            }
+        }
+
+        if (op.type == OpType::gain && op.src < 0 && ! ops.empty())
+        {
+            auto& prev = ops.back();
+
+            if ((prev.type == OpType::drive || prev.type == OpType::tape) && prev.dst == op.dst && ! prev.hasPost)
+            {
+                prev.hasPost = true;
+                prev.post = op.params[0];
+                continue;
+            }
+        }
+
+        ops.push_back (op);
+    }
+
+    for (auto& op : ops)
+    {
+        if (op.type == OpType::gain || op.type == OpType::drive || op.type == OpType::tape || op.type == OpType::mix)
+        {
+            op.ramps = (int) ramps.size();
+            ramps.emplace_back();
+        }
+
+        if (op.type == OpType::tape)
+        {
+            op.node = (int) tapes.size();
+            tapes.emplace_back();
+        }
+        else if (op.type == OpType::lowpass || op.type == OpType::highpass)
+        {
+            op.node = (int) filters.size();
+            filters.emplace_back();
+        }
+    }
+
+    sampleRate = 0.0;
+    return true;
+}
+
+//==============================================================================
+void EngineGraph::prepare (double newSampleRate, int newMaxBlockSize, int numChannels, bool doublePrecision, SharedTables& tables)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax (1, newMaxBlockSize);
+    numPreparedChannels = juce::jlimit (1, kMaxChannels, numChannels);
+    preparedForDouble = doublePrecision;
+
+    // Only the processing precision gets scratch memory
+    const auto numScratch = (numBuffers - 1) * numPreparedChannels;
+    scratchFloat.setSize (doublePrecision ? 0 : numScratch, doublePrecision ? 0 : maxBlockSize);
+    scratchDouble.setSize (doublePrecision ? numScratch : 0, doublePrecision ? maxBlockSize : 0);
+
+    for (auto& r : ramps)
+        for (auto* ramp : { &r.pre, &r.main, &r.post })
+            ramp->reset (sampleRate, 0.01);
+
+    for (auto& t : tapes)
+    {
+        t.tape.prepare (TapeHysteresis::getSharedCalibration (tables));
+        t.eq.prepare (TapeEq::getSharedBank (tables, sampleRate), sampleRate);
+    }
+
+    reset();
+}
+
+void EngineGraph::reset() noexcept
+{
+    for (auto& t : tapes)
+    {
+        t.tape.reset();
+        t.eq.reset();
+    }
+
+    for (auto& f : filters)
+        f.z.fill (0.0);
+
+    initialiseRamps();
+}
+
+void EngineGraph::initialiseRamps() noexcept
+{
+    // Start at the current settings rather than fading in from silence
+    for (const auto& op : ops)
+    {
+        if (op.ramps < 0)
+            continue;
+
+        auto& r = ramps[(size_t) op.ramps];
+        r.pre.setCurrentAndTarget (op.hasPre ? op.pre.getGain() : 1.0f);
+        r.main.setCurrentAndTarget (op.getMainTarget());
+        r.post.setCurrentAndTarget (op.hasPost ? op.post.getGain() : 1.0f);
+    }
+}
+
+template <typename SampleType>
+juce::AudioBuffer<SampleType>& EngineGraph::getScratch() noexcept
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return scratchDouble;
+    else
+        return scratchFloat;
+}
+
+template <typename SampleType>
+void EngineGraph::process (juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    if (ops.empty() || sampleRate <= 0.0 || preparedForDouble != std::is_same_v<SampleType, double>)
+        return;
+
+    auto& scratch = getScratch<SampleType>();
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), numPreparedChannels);
+    const auto numSamples = buffer.getNumSamples();
+    Buffers<SampleType> buffers {};
+
+    for (int b = 1; b < numBuffers; ++b)
+        for (int ch = 0; ch < numChannels; ++ch)
+            buffers[(size_t) b][(size_t) ch] = scratch.getWritePointer ((b - 1) * numPreparedChannels + ch);
+
+    for (int pos = 0; pos < numSamples; pos += maxBlockSize)
+    {
+        const auto n = juce::jmin (maxBlockSize, numSamples - pos);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            buffers[0][(size_t) ch] = buffer.getWritePointer (ch, pos);
+
+        for (auto& op : ops)
+            run (op, buffers, numChannels, n);
+    }
+}
+
+template <typename SampleType>
+void EngineGraph::run (Op& op, const Buffers<SampleType>& buffers, int numChannels, int numSamples) noexcept
+{
+    auto* const* y = buffers[(size_t) op.dst].data();
+
+    if (op.src >= 0)
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::copy (y[ch], buffers[(size_t) op.src][(size_t) ch], numSamples);
+
+    switch (op.type)
+    {
+        case OpType::copy:
+            break;
+
+        case OpType::gain:
+        {
+            auto& r = ramps[(size_t) op.ramps];
+            r.main.setTarget (op.getMainTarget());
+            DriveKernel::applyGain (y, numChannels, numSamples, r.main.getSegment(), RampSegment::constant (1.0f));
+            r.main.skip (numSamples);
+            break;
+        }
+
+        case OpType::drive:
+        {
+            auto& r = ramps[(size_t) op.ramps];
+            r.pre.setTarget (op.hasPre ? op.pre.getGain() : 1.0f);
+            r.main.setTarget (op.getMainTarget());
+            r.post.setTarget (op.hasPost ? op.post.getGain() : 1.0f);
+
+            DriveKernel::process (y, numChannels, numSamples, r.pre.getSegment(), r.main.getSegment(), r.post.getSegment());
+
+            for (auto* ramp : { &r.pre, &r.main, &r.post })
+                ramp->skip (numSamples);
+
+            break;
+        }
+
+        case OpType::tape:
+        {
+            auto& r = ramps[(size_t) op.ramps];
+            auto& t = tapes[(size_t) op.node];
+            const auto& p = op.params;
+
+            r.pre.setTarget (op.hasPre ? op.pre.getGain() : 1.0f);
+            r.main.setTarget (op.getMainTarget());
+            DriveKernel::applyGain (y, numChannels, numSamples, r.pre.getSegment(), r.main.getSegment());
+            r.pre.skip (numSamples);
+            r.main.skip (numSamples);
+
+            TapeHysteresis::Settings s;
+            s.tapeType  = juce::roundToInt (p[TapeRole::tapeType].get());
+            s.fluxivity = p[TapeRole::flux].get();
+            s.bias      = p[TapeRole::bias].get();
+            s.recordDb  = p[TapeRole::recordDb].get();
+            s.reproDb   = p[TapeRole::reproDb].get();
+            s.autoCal   = p[TapeRole::autoCal].get() >= 0.5f;
+            s.solver    = (TapeHysteresis::Solver) juce::roundToInt (p[TapeRole::solver].get());
+            t.tape.setSettings (s);
+
+            t.eq.select ((TapeEq::Standard) juce::roundToInt (p[TapeRole::eq].get()),
+                         TapeEq::getSpeedIndex (p[TapeRole::speed].get()));
+
+            t.eq.processRecord (y, numChannels, numSamples);
+            t.tape.process (y, numChannels, numSamples, sampleRate);
+            t.eq.processPlayback (y, numChannels, numSamples);
+
+            if (op.hasPost)
+            {
+                r.post.setTarget (op.post.getGain());
+                DriveKernel::applyGain (y, numChannels, numSamples, r.post.getSegment(), RampSegment::constant (1.0f));
+                r.post.skip (numSamples);
+            }
+
+            break;
+        }
+
+        case OpType::mix:
+        {
+            auto& r = ramps[(size_t) op.ramps];
+            r.main.setTarget (op.getMainTarget());
+            const auto seg = r.main.getSegment();
+
+            // y holds the first input (the second if swapped): out = first + mix * (second - first)
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* out = y[ch];
+                const auto* o = buffers[(size_t) op.other][(size_t) ch];
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto m = (SampleType) (i + 1 < seg.count ? seg.start + seg.step * (float) (i + 1) : seg.target);
+                    out[i] = op.swapped ? o[i] + m * (out[i] - o[i]) : out[i] + m * (o[i] - out[i]);
+                }
+            }
+
+            r.main.skip (numSamples);
+            break;
+        }
+
+        case OpType::lowpass:
+        case OpType::highpass:
+        {
+            const auto hz = juce::jlimit (1.0, 0.49 * sampleRate, (double) op.params[0].get());
+            const auto a = std::exp (-juce::MathConstants<double>::twoPi * hz / sampleRate);
+            const auto highPass = op.type == OpType::highpass;
+            auto& z = filters[(size_t) op.node].z;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* out = y[ch];
+                auto s = z[(size_t) ch];
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto x = (double) out[i];
+                    s = x + a * (s - x);
+                    out[i] = (SampleType) (highPass ? x - s : s);
+                }
+
+                // A NaN from the host must not latch in the recursion
+                z[(size_t) ch] = std::isfinite (s) ? s : 0.0;
+            }
+
+            break;
+        }
+    }
+}
+
+template void EngineGraph::process (juce::AudioBuffer<float>&) noexcept;
+template void EngineGraph::process (juce::AudioBuffer<double>&) noexcept;
+
+//==============================================================================
+double EngineGraph::getTailSeconds (float threshold) const noexcept
+{
+    double seconds = 0.0;
+
+    for (const auto& t : tapes)
+        seconds += t.tape.getTailSeconds (threshold) + t.eq.getTailSeconds (threshold);
+
+    // One pole: e^(-2 pi fc t) falls below the threshold
+    for (const auto& op : ops)
+        if (op.type == OpType::lowpass || op.type == OpType::highpass)
+            seconds += std::log (1.0 / (double) threshold)
+                     / (juce::MathConstants<double>::twoPi * juce::jmax (1.0, (double) op.params[0].get()));
+
+    return seconds;
+}
+
+float EngineGraph::getSmallSignalGain() const noexcept
+{
+    auto gain = 1.0f;
+
+    for (const auto& op : ops)
+    {
+        if (op.type == OpType::gain || op.type == OpType::drive || op.type == OpType::tape)
+        {
+            const auto& r = ramps[(size_t) op.ramps];
+            gain *= r.pre.getTarget() * r.main.getTarget() * r.post.getTarget();
+        }
+
+        if (op.type == OpType::tape)
+            gain *= tapes[(size_t) op.node].tape.getSmallSignalGain();
+    }
+
+    return gain;
+}
+
+} // namespace htmltovst
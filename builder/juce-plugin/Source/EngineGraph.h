@@ -0,0 +1,213 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "DriveKernel.h"
+#include "GeneratedParams.h"
+#include "TapeEq.h"
+#include "TapeHysteresis.h"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// Data-driven engine: a spec (parameters plus a small graph of built-in nodes) is read
+// from embedded data at startup and compiled into a flat schedule, so a new design is a
+// resource swap rather than a regenerated GeneratedParams.h and a full rebuild.
+//
+//   { "name":   "...",
+//     "params": [ same shape as an @plugin spec's params ],
+//     "graph":  [ { "id": "in", "type": "gain", "params": { "db": "inGain" } },
+//                 { "type": "tape", "params": { "drive": "drive", "bias": 0.5 } },
+//                 { "type": "mix", "inputs": [ "input", "tape" ], "params": { "mix": "wet" } } ] }
+//
+// Each node binds its roles (see kNodeTypes in EngineGraph.cpp) to a parameter ID, from
+// GeneratedParams.h or the spec's own list, or to a constant; unbound roles take the
+// node type's default. inputs default to the previous node ("input", the host buffer,
+// for the first) and the last node is the output.
+//
+// compile() sorts the nodes, drops any the output doesn't depend on, gives each result a
+// buffer (in place wherever the input has no other reader, reusing buffers once their
+// last reader has run) and folds gains into the drive or tape node next to them. What
+// is left is a flat array of ops, dispatched once per block through a switch: no
+// per-sample virtual calls, and all memory is allocated in prepare().
+//==============================================================================
+
+namespace htmltovst
+{
+
+class SharedTables;
+
+enum class NodeType
+{
+    gain,       // db
+    drive,      // amount: 0..1 -> 1x..13x into tanh
+    tape,       // drive, tapeType, flux, bias, recordDb, reproDb, autoCal, solver, eq, speed
+    mix,        // mix: 0 = first input .. 1 = second
+    lowpass,    // hz, one pole
+    highpass    // hz, one pole
+};
+
+struct EngineSpec
+{
+    static constexpr int kMaxRoles = 10;
+
+    struct Binding
+    {
+        juce::String paramId;       // empty: the constant
+        float constant = 0.0f;
+    };
+
+    struct Node
+    {
+        NodeType type = NodeType::gain;
+        juce::String id;
+        juce::StringArray inputs;
+        std::array<Binding, kMaxRoles> bindings;
+    };
+
+    juce::String name;
+    std::vector<HtmlToVstParamSpec> params;     // the spec's own; strings live below
+    std::vector<Node> nodes;
+
+    /** Null, with error set, if the JSON isn't a usable spec. */
+    static std::unique_ptr<const EngineSpec> parse (const juce::String& json, juce::String& error);
+
+    /** The spec compiled into this binary (HTMLTOVST_ENGINE_SPEC), parsed once; null if none. */
+    static const EngineSpec* getEmbedded();
+
+private:
+    bool addParam (const juce::var& param, juce::String& error);
+    bool addNode (const juce::var& node, juce::String& error);
+    const char* store (const juce::String& text);
+
+    std::deque<std::string> strings;
+    std::deque<std::vector<const char*>> optionLabels;
+    std::deque<std::vector<double>> optionValues;
+};
+
+//==============================================================================
+class EngineGraph
+{
+public:
+    static constexpr int kMaxChannels = 16;
+    static constexpr int kMaxBuffers  = 8;     // host buffer included
+
+    /** Where a parameter's value lives. Choices are read through spec's option values. */
+    struct ParamSource
+    {
+        const std::atomic<float>* value = nullptr;
+        const HtmlToVstParamSpec* spec = nullptr;
+    };
+
+    using Resolver = std::function<ParamSource (const juce::String& paramId)>;
+
+    /** Builds the schedule (message thread). False, with error set, if the graph is unusable. */
+    bool compile (const EngineSpec& spec, const Resolver& resolve, juce::String& error);
+    bool isCompiled() const noexcept                { return ! ops.empty(); }
+
+    /** Allocates the scratch buffers for one precision and readies every node. Not on the audio thread. */
+    void prepare (double sampleRate, int maxBlockSize, int numChannels, bool doublePrecision, SharedTables& tables);
+    void reset() noexcept;
+
+    /** Runs the schedule in place. Blocks longer than the prepared size go in chunks;
+        a precision that wasn't prepared passes through untouched.
+    */
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    double getTailSeconds (float threshold) const noexcept;
+
+    /** Product of every node's small-signal gain: exact for serial graphs, an estimate with mixes. */
+    float getSmallSignalGain() const noexcept;
+
+    int getNumOps() const noexcept                  { return (int) ops.size(); }
+    int getNumBuffers() const noexcept              { return numBuffers; }
+
+private:
+    enum class OpType
+    {
+        copy,
+        gain,
+        drive,
+        tape,
+        mix,
+        lowpass,
+        highpass
+    };
+
+    struct ParamRef
+    {
+        const std::atomic<float>* value = nullptr;
+        const double* optionValues = nullptr;
+        int numOptions = 0;
+        float constant = 0.0f;
+
+        float get() const noexcept;
+        float getGain() const noexcept;     // the value as dB, as a linear gain
+    };
+
+    struct Op
+    {
+        OpType type = OpType::copy;
+        int dst = 0;
+        int src = -1;           // copied into dst before the op runs; -1: already there
+        int other = -1;         // mix: buffer holding the other input
+        bool swapped = false;   // mix: dst holds the second input, other the first
+        bool hasPre = false, hasPost = false;
+        int ramps = -1, node = -1;
+        std::array<ParamRef, EngineSpec::kMaxRoles> params;
+        ParamRef pre, post;     // gains folded in from neighbouring gain nodes
+
+        float getMainTarget() const noexcept;
+    };
+
+    struct Ramps
+    {
+        GainRamp pre, main, post;
+    };
+
+    struct TapeNode
+    {
+        TapeHysteresis tape;
+        TapeEq eq;
+    };
+
+    struct FilterNode
+    {
+        std::array<double, kMaxChannels> z {};
+    };
+
+    template <typename SampleType>
+    using Buffers = std::array<std::array<SampleType*, kMaxChannels>, kMaxBuffers>;
+
+    template <typename SampleType>
+    void run (Op& op, const Buffers<SampleType>& buffers, int numChannels, int numSamples) noexcept;
+
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType>& getScratch() noexcept;
+
+    void initialiseRamps() noexcept;
+
+    std::vector<Op> ops;
+    std::vector<Ramps> ramps;
+    std::vector<TapeNode> tapes;
+    std::vector<FilterNode> filters;
+    int numBuffers = 1;
+
+    double sampleRate = 0.0;
+    int maxBlockSize = 0;
+    int numPreparedChannels = 0;
+    bool preparedForDouble = false;
+
+    // Buffer b > 0 is channels [(b - 1) * numPreparedChannels, b * numPreparedChannels)
+    juce::AudioBuffer<float> scratchFloat;
+    juce::AudioBuffer<double> scratchDouble;
+};
+
+} // namespace htmltovst
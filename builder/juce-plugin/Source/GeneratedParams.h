@@ -0,0 +1,110 @@
+// ===================================================================
+//  AUTO-GENERATED FILE — DO NOT EDIT BY HAND
+//  Generated from generator/currentSpec.json
+//  Plugin: AMPEX TAPE MACHINE
+//  Engine: ampex_102
+// ===================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+enum class HtmlToVstParamType { knob, choice, toggle };
+
+struct HtmlToVstParamSpec {
+    const char* id;
+    const char* label;
+    HtmlToVstParamType type;
+    double minValue;
+    double maxValue;
+    double defaultValue;
+    double interval;               // 0 = continuous
+    const char* const* options;    // choice labels, nullptr otherwise
+    const double* optionValues;    // numeric value of each choice
+    int numOptions;
+};
+
+static constexpr std::string_view kHtmlToVstPluginName = "AMPEX TAPE MACHINE";
+static constexpr std::string_view kHtmlToVstEngine = "ampex_102";
+
+static constexpr const char* kHtmlToVstOptions_osFactor[] = { "1x", "2x", "4x", "8x" };
+static constexpr double kHtmlToVstOptionValues_osFactor[] = { 1.0, 2.0, 4.0, 8.0 };
+static constexpr const char* kHtmlToVstOptions_osMode[] = { "IIR (low latency)", "FIR (linear phase)" };
+static constexpr double kHtmlToVstOptionValues_osMode[] = { 0.0, 1.0 };
+static constexpr const char* kHtmlToVstOptions_quality[] = { "Auto", "Eco", "Realtime", "Best" };
+static constexpr double kHtmlToVstOptionValues_quality[] = { 0.0, 1.0, 2.0, 3.0 };
+static constexpr const char* kHtmlToVstOptions_tapeSolver[] = { "RK2", "RK4", "NR x4", "NR x8" };
+static constexpr double kHtmlToVstOptionValues_tapeSolver[] = { 0.0, 1.0, 2.0, 3.0 };
+static constexpr const char* kHtmlToVstOptions_wowInterp[] = { "Linear", "Cubic", "Allpass", "Sinc" };
+static constexpr double kHtmlToVstOptionValues_wowInterp[] = { 0.0, 1.0, 2.0, 3.0 };
+static constexpr const char* kHtmlToVstOptions_speed[] = { "7.5", "15", "30" };
+static constexpr double kHtmlToVstOptionValues_speed[] = { 7.5, 15.0, 30.0 };
+static constexpr const char* kHtmlToVstOptions_flux[] = { "185", "250", "370" };
+static constexpr double kHtmlToVstOptionValues_flux[] = { 185.0, 250.0, 370.0 };
+static constexpr const char* kHtmlToVstOptions_eq[] = { "NAB", "IEC" };
+static constexpr double kHtmlToVstOptionValues_eq[] = { 0.0, 1.0 };
+static constexpr const char* kHtmlToVstOptions_tapeType[] = { "406", "456", "499", "GP9", "SM900", "SM911" };
+static constexpr double kHtmlToVstOptionValues_tapeType[] = { 0.0, 1.0, 2.0, 3.0, 4.0, 5.0 };
+static constexpr const char* kHtmlToVstOptions_headblock[] = { "stereo", "mono" };
+static constexpr double kHtmlToVstOptionValues_headblock[] = { 0.0, 1.0 };
+
+namespace HtmlToVstParam {
+    enum Index : int {
+        inGain,
+        drive,
+        outGain,
+        osFactor,
+        osMode,
+        quality,
+        tapeSolver,
+        wow,
+        flutter,
+        wowInterp,
+        inDb,
+        outDb,
+        bias,
+        speed,
+        flux,
+        eq,
+        tapeType,
+        headblock,
+        transformer,
+        autoCal,
+        numParams
+    };
+}
+
+static constexpr HtmlToVstParamSpec kHtmlToVstParams[] = {
+    { "inGain", "Input Gain", HtmlToVstParamType::knob, -24.0, 24.0, 0.0, 0.01, nullptr, nullptr, 0 },
+    { "drive", "Drive", HtmlToVstParamType::knob, 0.0, 1.0, 0.0, 0.0001, nullptr, nullptr, 0 },
+    { "outGain", "Output Gain", HtmlToVstParamType::knob, -24.0, 24.0, 0.0, 0.01, nullptr, nullptr, 0 },
+    { "osFactor", "Oversampling", HtmlToVstParamType::choice, 0.0, 3.0, 0.0, 1.0, kHtmlToVstOptions_osFactor, kHtmlToVstOptionValues_osFactor, 4 },
+    { "osMode", "Oversampling Filter", HtmlToVstParamType::choice, 0.0, 1.0, 0.0, 1.0, kHtmlToVstOptions_osMode, kHtmlToVstOptionValues_osMode, 2 },
+    { "quality", "Quality", HtmlToVstParamType::choice, 0.0, 3.0, 0.0, 1.0, kHtmlToVstOptions_quality, kHtmlToVstOptionValues_quality, 4 },
+    { "tapeSolver", "Tape Solver", HtmlToVstParamType::choice, 0.0, 3.0, 0.0, 1.0, kHtmlToVstOptions_tapeSolver, kHtmlToVstOptionValues_tapeSolver, 4 },
+    { "wow", "Wow", HtmlToVstParamType::knob, 0.0, 1.0, 0.0, 0.001, nullptr, nullptr, 0 },
+    { "flutter", "Flutter", HtmlToVstParamType::knob, 0.0, 1.0, 0.0, 0.001, nullptr, nullptr, 0 },
+    { "wowInterp", "Wow/Flutter Interpolation", HtmlToVstParamType::choice, 0.0, 3.0, 1.0, 1.0, kHtmlToVstOptions_wowInterp, kHtmlToVstOptionValues_wowInterp, 4 },
+    { "inDb", "Input", HtmlToVstParamType::knob, -12.0, 12.0, 0.0, 0.0, nullptr, nullptr, 0 },
+    { "outDb", "Output", HtmlToVstParamType::knob, -24.0, 6.0, 0.0, 0.0, nullptr, nullptr, 0 },
+    { "bias", "Bias", HtmlToVstParamType::knob, -5.0, 5.0, 0.0, 0.0, nullptr, nullptr, 0 },
+    { "speed", "Speed (ips)", HtmlToVstParamType::choice, 0.0, 2.0, 1.0, 1.0, kHtmlToVstOptions_speed, kHtmlToVstOptionValues_speed, 3 },
+    { "flux", "Fluxivity (nWb/m)", HtmlToVstParamType::choice, 0.0, 2.0, 1.0, 1.0, kHtmlToVstOptions_flux, kHtmlToVstOptionValues_flux, 3 },
+    { "eq", "EQ Standard", HtmlToVstParamType::choice, 0.0, 1.0, 0.0, 1.0, kHtmlToVstOptions_eq, kHtmlToVstOptionValues_eq, 2 },
+    { "tapeType", "Tape Type", HtmlToVstParamType::choice, 0.0, 5.0, 1.0, 1.0, kHtmlToVstOptions_tapeType, kHtmlToVstOptionValues_tapeType, 6 },
+    { "headblock", "Headblock", HtmlToVstParamType::choice, 0.0, 1.0, 0.0, 1.0, kHtmlToVstOptions_headblock, kHtmlToVstOptionValues_headblock, 2 },
+    { "transformer", "Transformer", HtmlToVstParamType::toggle, 0.0, 1.0, 1.0, 0.0, nullptr, nullptr, 0 },
+    { "autoCal", "Auto Cal", HtmlToVstParamType::toggle, 0.0, 1.0, 1.0, 0.0, nullptr, nullptr, 0 }
+};
+
+static constexpr std::size_t kNumHtmlToVstParams = sizeof(kHtmlToVstParams) / sizeof(HtmlToVstParamSpec);
+static_assert(kNumHtmlToVstParams == HtmlToVstParam::numParams, "param table and index enum out of sync");
+
+// Compile-time lookup by ID; -1 if the current spec doesn't define it.
+static constexpr int findHtmlToVstParam(std::string_view id) {
+    for (std::size_t i = 0; i < kNumHtmlToVstParams; ++i)
+        if (std::string_view(kHtmlToVstParams[i].id) == id)
+            return (int) i;
+    return -1;
+}
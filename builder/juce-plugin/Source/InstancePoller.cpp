@@ -0,0 +1,40 @@
+#include "InstancePoller.h"
+
+namespace htmltovst
+{
+
+static constexpr int kPollHz = 20;
+
+InstancePoller::~InstancePoller()
+{
+    stopTimer();
+}
+
+void InstancePoller::add (Client& client)
+{
+    const std::lock_guard<std::recursive_mutex> sl (lock);
+    clients.addIfNotAlreadyThere (&client);
+
+    if (! isTimerRunning())
+        startTimerHz (kPollHz);
+}
+
+void InstancePoller::remove (Client& client)
+{
+    const std::lock_guard<std::recursive_mutex> sl (lock);
+    clients.removeFirstMatchingValue (&client);
+
+    if (clients.isEmpty())
+        stopTimer();
+}
+
+void InstancePoller::timerCallback()
+{
+    const std::lock_guard<std::recursive_mutex> sl (lock);
+
+    // By index: a client may be added or removed during the loop
+    for (int i = 0; i < clients.size(); ++i)
+        clients.getUnchecked (i)->pollMessageThread();
+}
+
+} // namespace htmltovst
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_events/juce_events.h>
+
+#include <mutex>
+
+//==============================================================================
+// One message-thread timer for every plug-in instance in the process.
+//
+// The audio thread can't call back into the host (latency changes) or write logs, so it
+// leaves flags that the message thread picks up. Instead of a 20 Hz timer apiece, each
+// instance registers here and a single timer walks them; it only runs while at least one
+// is registered. Shared through juce::SharedResourcePointer.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class InstancePoller final : private juce::Timer
+{
+public:
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        /** Message thread, about 20 times a second. */
+        virtual void pollMessageThread() = 0;
+    };
+
+    ~InstancePoller() override;
+
+    void add (Client& client);
+
+    /** Once this returns, client won't be polled again (safe from any thread). */
+    void remove (Client& client);
+
+private:
+    void timerCallback() override;
+
+    // Recursive: a host may create or delete instances from inside a poll (e.g. reacting to
+    // a latency change), which comes back here on the same thread
+    std::recursive_mutex lock;
+    juce::Array<Client*> clients;
+};
+
+} // namespace htmltovst
@@ -0,0 +1,310 @@
+#include "MeterStream.h"
+
+namespace htmltovst
+{
+
+static constexpr float kMinDb = -120.0f;
+static constexpr float kBandLowHz = 20.0f;
+static constexpr float kBandReleaseDbPerSecond = 60.0f;
+
+static float toDb (float gain) noexcept
+{
+    return juce::Decibels::gainToDecibels (gain, kMinDb);
+}
+
+//==============================================================================
+MeterStream::MeterStream()
+{
+    working.bandsDb.fill (kMinDb);
+    published.bandsDb.fill (kMinDb);
+}
+
+void MeterStream::prepare (double sampleRate) noexcept
+{
+    const auto d = juce::jmax (1, juce::roundToInt (sampleRate / kAnalysisRate));
+    decimation.store (d);
+    analysisRate.store (sampleRate / d);
+}
+
+template <typename SampleType>
+float MeterStream::getRms (const SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (numChannels <= 0 || numSamples <= 0)
+        return 0.0f;
+
+    double sum = 0.0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* x = channels[ch];
+        SampleType s = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+            s += x[i] * x[i];
+
+        sum += (double) s;
+    }
+
+    return (float) std::sqrt (sum / ((double) numChannels * numSamples));
+}
+
+template <typename SampleType>
+void MeterStream::pushBlock (const SampleType* const* channels, int numChannels, int numSamples,
+                             float inRms, float smallSignalGain, float drive) noexcept
+{
+    if (! isActive() || numChannels <= 0 || numSamples <= 0)
+        return;
+
+    MeterFrame f {};
+    double outSq = 0.0;
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        // Mono feeds both sides; channels past the first two aren't metered.
+        const auto* x = channels[juce::jmin (ch, numChannels - 1)];
+        const auto range = juce::FloatVectorOperations::findMinAndMax (x, numSamples);
+        SampleType s = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+            s += x[i] * x[i];
+
+        f.peak[ch] = (float) juce::jmax (-range.getStart(), range.getEnd());
+        f.rms[ch]  = (float) std::sqrt (s / (SampleType) numSamples);
+        outSq += (double) s;
+    }
+
+    const auto outRms = (float) std::sqrt (outSq / (2.0 * numSamples));
+    const auto expected = inRms * smallSignalGain;
+
+    f.gainReductionDb = expected > 1.0e-5f ? juce::jmin (0.0f, toDb (outRms / expected)) : 0.0f;
+    f.drive = drive;
+    f.numSamples = numSamples;
+
+    {
+        const auto w = frameFifo.write (1);
+
+        if (w.blockSize1 > 0)
+            frames[(size_t) w.startIndex1] = f;
+        else
+            overruns.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    // Mono sum, box-car decimated to ~kAnalysisRate, written in scratch-sized chunks
+    const auto d = decimation.load (std::memory_order_relaxed);
+    const auto scale = 1.0f / (float) (d * numChannels);
+    int numScratch = 0;
+
+    auto flush = [this, &numScratch]
+    {
+        const auto w = sampleFifo.write (numScratch);
+
+        if (w.blockSize1 > 0)
+            std::copy_n (decimScratch.data(), w.blockSize1, samples.data() + w.startIndex1);
+
+        if (w.blockSize2 > 0)
+            std::copy_n (decimScratch.data() + w.blockSize1, w.blockSize2, samples.data() + w.startIndex2);
+
+        if (w.blockSize1 + w.blockSize2 < numScratch)
+            overruns.fetch_add (1, std::memory_order_relaxed);
+
+        numScratch = 0;
+    };
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            decimAccum += (float) channels[ch][i];
+
+        if (++decimCount < d)
+            continue;
+
+        decimScratch[(size_t) numScratch++] = decimAccum * scale;
+        decimAccum = 0.0f;
+        decimCount = 0;
+
+        if (numScratch == (int) decimScratch.size())
+            flush();
+    }
+
+    if (numScratch > 0)
+        flush();
+}
+
+template float MeterStream::getRms (const float* const*, int, int) noexcept;
+template float MeterStream::getRms (const double* const*, int, int) noexcept;
+template void MeterStream::pushBlock (const float* const*, int, int, float, float, float) noexcept;
+template void MeterStream::pushBlock (const double* const*, int, int, float, float, float) noexcept;
+
+//==============================================================================
+bool MeterStream::analyse()
+{
+    bool updated = false;
+
+    // Levels: peak is the max over the frames, RMS the power mean, GR the deepest
+    {
+        auto r = frameFifo.read (frameFifo.getNumReady());
+
+        if (r.blockSize1 + r.blockSize2 > 0)
+        {
+            double sumSq[2] {};
+            double total = 0.0;
+            float peak[2] {};
+            float gr = 0.0f;
+
+            r.forEach ([&] (int index)
+            {
+                const auto& f = frames[(size_t) index];
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    peak[ch] = juce::jmax (peak[ch], f.peak[ch]);
+                    sumSq[ch] += (double) f.rms[ch] * f.rms[ch] * f.numSamples;
+                }
+
+                gr = juce::jmin (gr, f.gainReductionDb);
+                working.drive = f.drive;
+                total += f.numSamples;
+            });
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                working.peak[ch] = peak[ch];
+                working.rms[ch]  = total > 0.0 ? (float) std::sqrt (sumSq[ch] / total) : 0.0f;
+            }
+
+            working.gainReductionDb = gr;
+            updated = true;
+        }
+        else if (working.peak[0] > 0.0f || working.peak[1] > 0.0f)
+        {
+            // The host stopped calling processBlock: let the meters fall.
+            working.peak[0] = working.peak[1] = working.rms[0] = working.rms[1] = 0.0f;
+            working.gainReductionDb = 0.0f;
+            updated = true;
+        }
+    }
+
+    // Spectrum: keep the latest kFftSize samples, transform every kHopSize
+    {
+        auto r = sampleFifo.read (sampleFifo.getNumReady());
+
+        r.forEach ([this] (int index)
+        {
+            history[(size_t) historyPos] = samples[(size_t) index];
+            historyPos = (historyPos + 1) & (kFftSize - 1);
+            ++samplesSinceFft;
+        });
+    }
+
+    if (samplesSinceFft >= kHopSize)
+    {
+        computeSpectrum();
+        updated = true;
+    }
+
+    if (updated)
+    {
+        working.overruns = overruns.load (std::memory_order_relaxed);
+
+        const std::lock_guard<std::mutex> sl (snapshotLock);
+        ++working.counter;
+        published = working;
+    }
+
+    return updated;
+}
+
+void MeterStream::computeSpectrum()
+{
+    const auto rate = (float) analysisRate.load();
+    const auto elapsedSeconds = (float) samplesSinceFft / rate;
+    samplesSinceFft = 0;
+
+    // Oldest sample first
+    for (int i = 0; i < kFftSize; ++i)
+        fftData[(size_t) i] = history[(size_t) ((historyPos + i) & (kFftSize - 1))];
+
+    std::fill (fftData.begin() + kFftSize, fftData.end(), 0.0f);
+
+    window.multiplyWithWindowingTable (fftData.data(), (size_t) kFftSize);
+    fft.performFrequencyOnlyForwardTransform (fftData.data(), true);
+
+    // Hann window has a coherent gain of 1/2: a full-scale sine reads 0 dB
+    const auto norm = 4.0f / (float) kFftSize;
+    const auto nyquist = rate * 0.5f;
+    const auto binHz = rate / (float) kFftSize;
+    const auto release = kBandReleaseDbPerSecond * elapsedSeconds;
+
+    for (int b = 0; b < kNumBands; ++b)
+    {
+        const auto loHz = kBandLowHz * std::pow (nyquist / kBandLowHz, (float) b / kNumBands);
+        const auto hiHz = kBandLowHz * std::pow (nyquist / kBandLowHz, (float) (b + 1) / kNumBands);
+        const auto lo = juce::jlimit (1, kFftSize / 2, (int) (loHz / binHz));
+        const auto hi = juce::jlimit (lo, kFftSize / 2, (int) (hiHz / binHz));
+
+        float mag = 0.0f;
+
+        for (int i = lo; i <= hi; ++i)
+            mag = juce::jmax (mag, fftData[(size_t) i]);
+
+        const auto db = toDb (mag * norm);
+        auto& band = working.bandsDb[(size_t) b];
+        band = juce::jmax (db, band - release);
+    }
+}
+
+MeterStream::Snapshot MeterStream::getSnapshot() const
+{
+    const std::lock_guard<std::mutex> sl (snapshotLock);
+    return published;
+}
+
+//==============================================================================
+MeterAnalyser::MeterAnalyser()
+    : juce::Thread ("HtmlToVst meter analysis")
+{
+}
+
+MeterAnalyser::~MeterAnalyser()
+{
+    stopThread (1000);
+}
+
+void MeterAnalyser::add (MeterStream& stream)
+{
+    {
+        const std::lock_guard<std::mutex> sl (lock);
+        streams.addIfNotAlreadyThere (&stream);
+    }
+
+    stream.setActive (true);
+
+    if (! isThreadRunning())
+        startThread (juce::Thread::Priority::low);
+}
+
+void MeterAnalyser::remove (MeterStream& stream)
+{
+    stream.setActive (false);
+
+    const std::lock_guard<std::mutex> sl (lock);
+    streams.removeFirstMatchingValue (&stream);
+}
+
+void MeterAnalyser::run()
+{
+    // ~60 passes a second: enough to keep the FIFOs short and every UI frame fresh
+    while (! threadShouldExit())
+    {
+        {
+            const std::lock_guard<std::mutex> sl (lock);
+
+            for (auto* s : streams)
+                s->analyse();
+        }
+
+        wait (16);
+    }
+}
+
+} // namespace htmltovst
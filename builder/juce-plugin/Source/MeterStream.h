@@ -0,0 +1,137 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+//==============================================================================
+// Audio thread -> UI metering.
+//
+// processBlock pushes one MeterFrame per block (peak/RMS, gain reduction, drive)
+// and a mono stream decimated to ~48 kHz into two wait-free SPSC FIFOs
+// (juce::AbstractFifo over fixed arrays): no locks, no allocation, and a full
+// FIFO drops data rather than waiting. A background thread (MeterAnalyser)
+// drains the FIFOs, runs the FFT and publishes a Snapshot for the editor.
+//==============================================================================
+
+namespace htmltovst
+{
+
+struct MeterFrame
+{
+    float peak[2];
+    float rms[2];
+    float gainReductionDb;   // <= 0: output level vs. the chain's small-signal gain
+    float drive;             // 0..1
+    int numSamples;
+};
+
+class MeterStream
+{
+public:
+    static constexpr int kFrameCapacity  = 512;
+    static constexpr int kSampleCapacity = 1 << 15;
+    static constexpr int kFftOrder = 11;
+    static constexpr int kFftSize  = 1 << kFftOrder;
+    static constexpr int kHopSize  = kFftSize / 4;
+    static constexpr int kNumBands = 64;
+    static constexpr double kAnalysisRate = 48000.0;
+
+    MeterStream();
+
+    /** Sets the decimation for a new host rate. Safe while streaming. */
+    void prepare (double sampleRate) noexcept;
+
+    /** Streaming only runs while something is listening (an editor is open). */
+    void setActive (bool shouldBeActive) noexcept      { active.store (shouldBeActive); }
+    bool isActive() const noexcept                     { return active.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Audio thread. Measures the processed block; inRms is the input level before processing.
+        Instantiated for float and double buffers.
+    */
+    template <typename SampleType>
+    void pushBlock (const SampleType* const* channels, int numChannels, int numSamples,
+                    float inRms, float smallSignalGain, float drive) noexcept;
+
+    /** RMS over all channels, for the caller's pre-processing measurement. */
+    template <typename SampleType>
+    static float getRms (const SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Analyser thread. Drains both FIFOs; returns true if a new snapshot was published. */
+    bool analyse();
+
+    struct Snapshot
+    {
+        float peak[2] {};
+        float rms[2] {};
+        float gainReductionDb = 0.0f;
+        float drive = 0.0f;
+        std::array<float, kNumBands> bandsDb {};
+        std::uint32_t counter = 0;      // bumps on every publish
+        std::uint32_t overruns = 0;     // frames/samples dropped because a FIFO was full
+    };
+
+    /** Any non-audio thread. */
+    Snapshot getSnapshot() const;
+
+private:
+    void computeSpectrum();
+
+    std::atomic<bool> active { false };
+    std::atomic<int> decimation { 1 };
+    std::atomic<double> analysisRate { kAnalysisRate };
+    std::atomic<std::uint32_t> overruns { 0 };
+
+    // Audio thread only
+    float decimAccum = 0.0f;
+    int decimCount = 0;
+    std::array<float, 256> decimScratch {};
+
+    juce::AbstractFifo frameFifo { kFrameCapacity };
+    std::array<MeterFrame, kFrameCapacity> frames {};
+    juce::AbstractFifo sampleFifo { kSampleCapacity };
+    std::array<float, kSampleCapacity> samples {};
+
+    // Analyser thread only
+    juce::dsp::FFT fft { kFftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) kFftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::array<float, kFftSize> history {};
+    std::array<float, kFftSize * 2> fftData {};
+    int historyPos = 0;
+    int samplesSinceFft = 0;
+    Snapshot working;
+
+    mutable std::mutex snapshotLock;
+    Snapshot published;
+
+    JUCE_DECLARE_NON_COPYABLE (MeterStream)
+};
+
+//==============================================================================
+/** One background thread shared by every open editor, so cost grows with the
+    number of streams analysed, not with threads or timers.
+*/
+class MeterAnalyser final : private juce::Thread
+{
+public:
+    MeterAnalyser();
+    ~MeterAnalyser() override;
+
+    void add (MeterStream& stream);
+    void remove (MeterStream& stream);
+
+private:
+    void run() override;
+
+    std::mutex lock;
+    juce::Array<MeterStream*> streams;
+
+    JUCE_DECLARE_NON_COPYABLE (MeterAnalyser)
+};
+
+} // namespace htmltovst
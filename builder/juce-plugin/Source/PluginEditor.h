@@ -1,12 +1,13 @@
 #pragma once
 
 #include "PluginProcessor.h"
+#include "UiBridge.h"
+#include "WebViewPool.h"
 #include <juce_gui_extra/juce_gui_extra.h>
 
 class HtmlToVstPluginAudioProcessorEditor final
     : public juce::AudioProcessorEditor,
-      private juce::AudioProcessorValueTreeState::Listener,
-      private juce::Timer
+      private juce::AudioProcessorParameter::Listener
 {
 public:
     explicit HtmlToVstPluginAudioProcessorEditor (HtmlToVstPluginAudioProcessor& p);
@@ -16,33 +17,32 @@ public:
     void resized() override;
 
 private:
-    class Browser final : public juce::WebBrowserComponent
-    {
-    public:
-        explicit Browser (HtmlToVstPluginAudioProcessorEditor& ownerIn) : owner (ownerIn) {}
-        bool pageAboutToLoad (const juce::String& newURL) override { return owner.handleBrowserURL (newURL); }
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int, bool) override {}
+    void pushToPage();
 
-    private:
-        HtmlToVstPluginAudioProcessorEditor& owner;
-    };
+    HtmlToVstPluginAudioProcessor& audioProcessor;
 
-    bool handleBrowserURL (const juce::String& url);
+    juce::SharedResourcePointer<WebViewPool> webViewPool;
+    UiBridge bridge;
 
-    void sendAllParamsToJS();
-    void sendParamToJS (const juce::String& paramID, float value);
+    juce::SharedResourcePointer<htmltovst::MeterAnalyser> meterAnalyser;
+    std::uint32_t lastMeterCounter = 0;
 
-    void parameterChanged (const juce::String& parameterID, float newValue) override;
-    void timerCallback() override;
+    // CPU load goes out a few times a second, each message covering the blocks since the last
+    htmltovst::CpuTelemetry::Snapshot lastCpu;
+    double lastCpuMs = 0.0;
 
-    static juce::String getIndexHtml();
+    // Borrowed from the pool for the editor's lifetime, handed back on close
+    WebViewPool::Entry browserEntry;
+    bool shown = false;
 
-    HtmlToVstPluginAudioProcessor& audioProcessor;
-    std::unique_ptr<Browser> browser;
+    // Plain (denormalised) values, indexed like kHtmlToVstParams; only dirty ones are pushed
+    std::array<std::atomic<float>, kNumHtmlToVstParams> paramValues;
+    UiBridge::DirtyParams dirtyParams;
 
-    std::atomic<float> inGainValue  { 0.0f };
-    std::atomic<float> driveValue   { 0.0f };
-    std::atomic<float> outGainValue { 0.0f };
-    std::atomic<bool>  dirty        { true };
+    // Pushes once per display refresh; declared last so it's detached first
+    juce::VBlankAttachment vBlank;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HtmlToVstPluginAudioProcessorEditor)
 };
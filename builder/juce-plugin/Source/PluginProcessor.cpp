@@ -1,69 +1,344 @@
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+#include "RealtimeCheck.h"
+#include "StateCodec.h"
+
+#if ! HTMLTOVST_HEADLESS
+  #include "PluginEditor.h"
+  #include "WebViewPool.h"
+#endif
 
 #include <cmath>
+#include <type_traits>
+
+// Headless builds (benchmarks) don't go through juce_add_plugin, so there is no JucePluginDefines.h
+#ifndef JucePlugin_Name
+  #define JucePlugin_Name "HTMLtoVST"
+#endif
 
 static float dbToGainSafe (float db)
 {
     return juce::Decibels::decibelsToGain (db, -80.0f);
 }
 
+// Spec parameters the tape engine understands; -1 where the current spec doesn't define them.
+static constexpr bool kUseTapeEngine = kHtmlToVstEngine == "ampex_102";
+static constexpr int kTapeTypeParam  = findHtmlToVstParam ("tapeType");
+static constexpr int kFluxParam      = findHtmlToVstParam ("flux");
+static constexpr int kBiasParam      = findHtmlToVstParam ("bias");
+static constexpr int kRecordParam    = findHtmlToVstParam ("inDb");
+static constexpr int kReproParam     = findHtmlToVstParam ("outDb");
+static constexpr int kAutoCalParam   = findHtmlToVstParam ("autoCal");
+static constexpr int kSolverParam    = findHtmlToVstParam ("tapeSolver");
+static constexpr int kEqParam        = findHtmlToVstParam ("eq");
+static constexpr int kSpeedParam     = findHtmlToVstParam ("speed");
+static constexpr int kWowParam       = findHtmlToVstParam ("wow");
+static constexpr int kFlutterParam   = findHtmlToVstParam ("flutter");
+static constexpr int kWowInterpParam = findHtmlToVstParam ("wowInterp");
+static constexpr int kHeadblockParam = findHtmlToVstParam ("headblock");
+static constexpr int kTransformerParam = findHtmlToVstParam ("transformer");
+
+static_assert (HtmlToVstPluginAudioProcessor::kMaxChannels <= htmltovst::TapeHysteresis::kMaxChannels);
+static_assert (HtmlToVstPluginAudioProcessor::kMaxChannels <= htmltovst::TapeEq::kMaxChannels);
+static_assert (HtmlToVstPluginAudioProcessor::kMaxChannels <= htmltovst::WowFlutter::kMaxChannels);
+static_assert (HtmlToVstPluginAudioProcessor::kMaxChannels <= htmltovst::Convolver::kMaxChannels);
+
+// Quality profiles, per setting (options are ordered cheapest first): the most Eco allows
+// and the least Best accepts
+static constexpr int kEcoMaxOsFactor  = 1;     // 2x
+static constexpr int kBestMinOsFactor = 2;     // 4x
+static constexpr int kEcoMaxSolver    = (int) htmltovst::TapeHysteresis::Solver::rk2;
+static constexpr int kBestMinSolver   = (int) htmltovst::TapeHysteresis::Solver::newton8;
+static constexpr int kEcoMaxInterp    = (int) htmltovst::WowFlutter::Interpolation::linear;
+static constexpr int kBestMinInterp   = (int) htmltovst::WowFlutter::Interpolation::sinc;
+
+static int applyQuality (HtmlToVstPluginAudioProcessor::Quality quality, int value, int ecoMax, int bestMin) noexcept
+{
+    switch (quality)
+    {
+        case HtmlToVstPluginAudioProcessor::Quality::eco:       return juce::jmin (value, ecoMax);
+        case HtmlToVstPluginAudioProcessor::Quality::best:      return juce::jmax (value, bestMin);
+        case HtmlToVstPluginAudioProcessor::Quality::automatic:
+        case HtmlToVstPluginAudioProcessor::Quality::realtime:  break;
+    }
+
+    return value;
+}
+
+struct Gains
+{
+    float in, drive, out;
+};
+
+/** The fused chain's linear gains for a set of parameter values. */
+static Gains getGains (const htmltovst::StateCodec::Values& params) noexcept
+{
+    return { dbToGainSafe (params[HtmlToVstParam::inGain]),
+             1.0f + 12.0f * juce::jlimit (0.0f, 1.0f, params[HtmlToVstParam::drive]),   // 1x..13x
+             dbToGainSafe (params[HtmlToVstParam::outGain]) };
+}
+
+static float getValueOr (const htmltovst::StateCodec::Values& params, int index, float fallback) noexcept
+{
+    return index >= 0 ? params[(size_t) index] : fallback;
+}
+
+static double getChoiceValueOr (const htmltovst::StateCodec::Values& params, int index, double fallback) noexcept
+{
+    if (index < 0)
+        return fallback;
+
+    const auto& spec = kHtmlToVstParams[index];
+    return spec.optionValues[juce::jlimit (0, spec.numOptions - 1, (int) params[(size_t) index])];
+}
+
+// Numbers instances in creation order, so log lines can be told apart
+static std::atomic<int> numInstancesCreated { 0 };
+
+/** Length of an oversampler's impulse response (host-rate samples) down to the silence threshold,
+    measured by pushing a unit impulse through it. Leaves the oversampler reset.
+*/
+template <typename SampleType>
+static int measureOversamplerTail (juce::dsp::Oversampling<SampleType>& os, int numChannels, int blockSize, double sampleRate)
+{
+    juce::AudioBuffer<SampleType> impulse (numChannels, blockSize);
+    const auto maxSamples = (int) sampleRate;
+    int lastAudible = 0;
+
+    os.reset();
+
+    for (int pos = 0; pos < maxSamples; pos += blockSize)
+    {
+        impulse.clear();
+
+        if (pos == 0)
+            impulse.setSample (0, 0, (SampleType) 1);
+
+        juce::dsp::AudioBlock<SampleType> block (impulse);
+        os.processSamplesUp (block);
+        os.processSamplesDown (block);
+
+        const auto* y = impulse.getReadPointer (0);
+
+        for (int i = 0; i < blockSize; ++i)
+            if (std::abs (y[i]) > (SampleType) htmltovst::SilenceGate::kDefaultThreshold)
+                lastAudible = pos + i + 1;
+
+        // Done once a whole block after the response is quiet (latency may span several blocks)
+        if (lastAudible > 0 && lastAudible <= pos)
+            break;
+    }
+
+    os.reset();
+    return lastAudible;
+}
+
 // IMPORTANT: non-capturing function (JUCE WaveShaper may require function pointer)
-static float tanhShaper (float x)
+template <typename SampleType>
+static SampleType tanhShaper (SampleType x)
 {
     return std::tanh (x);
 }
 
+template <typename SampleType>
+static int resetOversampler (juce::dsp::Oversampling<SampleType>* os)
+{
+    if (os == nullptr)
+        return 0;
+
+    os->reset();
+    return juce::roundToInt (os->getLatencyInSamples());
+}
+
 HtmlToVstPluginAudioProcessor::HtmlToVstPluginAudioProcessor()
     : AudioProcessor (BusesProperties()
                         .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
                         .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-      apvts (*this, nullptr, "PARAMS", createParameterLayout())
+      apvts (*this, nullptr, "PARAMS", createParameterLayout (htmltovst::EngineSpec::getEmbedded())),
+      instanceNumber (++numInstancesCreated)
 {
     // Use a plain function pointer (works with older JUCE)
-    driveShaper.functionToUse = tanhShaper;
+    floatChain.driveShaper.functionToUse  = tanhShaper<float>;
+    doubleChain.driveShaper.functionToUse = tanhShaper<double>;
+
+    for (size_t i = 0; i < engines.size(); ++i)
+        engines[i].index = (int) i;
+
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+    {
+        paramValues[i]  = apvts.getRawParameterValue (kHtmlToVstParams[i].id);
+        paramObjects[i] = apvts.getParameter (kHtmlToVstParams[i].id);
+        jassert (paramValues[i] != nullptr && paramObjects[i] != nullptr);
+    }
+
+    if (const auto* engineSpec = htmltovst::EngineSpec::getEmbedded())
+    {
+        for (const auto& p : engineSpec->params)
+            if (findHtmlToVstParam (p.id) < 0)
+                runtimeParams.push_back ({ &p, apvts.getRawParameterValue (p.id), apvts.getParameter (p.id) });
+
+        juce::String error;
+
+        if (engineGraph.compile (*engineSpec, [this] (const juce::String& id) { return findParamSource (id); }, error))
+            dspPath.store (DspPath::graph);
+        else
+            juce::Logger::writeToLog ("HTMLtoVST: engine spec '" + engineSpec->name + "' not used: " + error);
+    }
+
+    if (const auto seconds = juce::SystemStats::getEnvironmentVariable ("HTMLTOVST_CPU_LOG", {}).getDoubleValue(); seconds > 0.0)
+        setCpuLogInterval (seconds);
+
+    if (const auto workers = juce::SystemStats::getEnvironmentVariable ("HTMLTOVST_DSP_WORKERS", {}).getIntValue(); workers > 0)
+        setNumDspWorkers (workers);
+
+    poller->add (*this);
 }
 
-juce::AudioProcessorValueTreeState::ParameterLayout
-HtmlToVstPluginAudioProcessor::createParameterLayout()
+HtmlToVstPluginAudioProcessor::~HtmlToVstPluginAudioProcessor()
 {
-    using APF = juce::AudioParameterFloat;
+    poller->remove (*this);
 
-    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
+    // Whatever ran since the last line, however short
+    if (cpuLogSeconds.load() > 0.0)
+        logCpuTelemetry();
+}
 
-    params.push_back (std::make_unique<APF> (
-        juce::ParameterID { "inGain", 1 },
-        "Input Gain",
-        juce::NormalisableRange<float> (-24.0f, 24.0f, 0.01f),
-        0.0f));
+juce::AudioProcessorValueTreeState::ParameterLayout
+HtmlToVstPluginAudioProcessor::createParameterLayout (const htmltovst::EngineSpec* engineSpec)
+{
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
 
-    params.push_back (std::make_unique<APF> (
-        juce::ParameterID { "drive", 1 },
-        "Drive",
-        juce::NormalisableRange<float> (0.0f, 1.0f, 0.0001f),
-        0.0f));
+    for (const auto& p : kHtmlToVstParams)
+        params.push_back (makeParameter (p));
 
-    params.push_back (std::make_unique<APF> (
-        juce::ParameterID { "outGain", 1 },
-        "Output Gain",
-        juce::NormalisableRange<float> (-24.0f, 24.0f, 0.01f),
-        0.0f));
+    // A spec parameter with a generated ID is the generated one (the UI binds to that)
+    if (engineSpec != nullptr)
+        for (const auto& p : engineSpec->params)
+            if (findHtmlToVstParam (p.id) < 0)
+                params.push_back (makeParameter (p));
 
     return { params.begin(), params.end() };
 }
 
+std::unique_ptr<juce::RangedAudioParameter> HtmlToVstPluginAudioProcessor::makeParameter (const HtmlToVstParamSpec& p)
+{
+    const juce::ParameterID id { p.id, 1 };
+
+    switch (p.type)
+    {
+        case HtmlToVstParamType::choice:
+        {
+            juce::StringArray choices;
+            for (int i = 0; i < p.numOptions; ++i)
+                choices.add (p.options[i]);
+
+            return std::make_unique<juce::AudioParameterChoice> (id, p.label, choices, (int) p.defaultValue);
+        }
+
+        case HtmlToVstParamType::toggle:
+            return std::make_unique<juce::AudioParameterBool> (id, p.label, p.defaultValue >= 0.5);
+
+        case HtmlToVstParamType::knob:
+            break;
+    }
+
+    return std::make_unique<juce::AudioParameterFloat> (
+        id,
+        p.label,
+        juce::NormalisableRange<float> ((float) p.minValue, (float) p.maxValue, (float) p.interval),
+        (float) p.defaultValue);
+}
+
+htmltovst::EngineGraph::ParamSource HtmlToVstPluginAudioProcessor::findParamSource (const juce::String& paramId) const
+{
+    if (const auto index = findHtmlToVstParam (paramId.toRawUTF8()); index >= 0)
+        return { paramValues[(size_t) index], &kHtmlToVstParams[index] };
+
+    for (const auto& p : runtimeParams)
+        if (paramId == p.spec->id)
+            return { p.value, p.spec };
+
+    return {};
+}
+
+bool HtmlToVstPluginAudioProcessor::isRunningGraph() const noexcept
+{
+    return dspPath.load() == DspPath::graph && engineGraph.isCompiled();
+}
+
 //==============================================================================
 const juce::String HtmlToVstPluginAudioProcessor::getName() const { return JucePlugin_Name; }
 bool HtmlToVstPluginAudioProcessor::acceptsMidi() const { return false; }
 bool HtmlToVstPluginAudioProcessor::producesMidi() const { return false; }
 bool HtmlToVstPluginAudioProcessor::isMidiEffect() const { return false; }
-double HtmlToVstPluginAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+double HtmlToVstPluginAudioProcessor::getTailLengthSeconds() const { return tailSeconds.load(); }
+bool HtmlToVstPluginAudioProcessor::supportsDoublePrecisionProcessing() const { return true; }
+
+int HtmlToVstPluginAudioProcessor::getNumPrograms() { return presets.getNumPresets(); }
+int HtmlToVstPluginAudioProcessor::getCurrentProgram() { return presets.getCurrent(); }
+const juce::String HtmlToVstPluginAudioProcessor::getProgramName (int index) { return presets.getName (index); }
+void HtmlToVstPluginAudioProcessor::changeProgramName (int index, const juce::String& newName) { presets.rename (index, newName); }
+
+void HtmlToVstPluginAudioProcessor::setCurrentProgram (int index)
+{
+    if (! juce::isPositiveAndBelow (index, presets.getNumPresets()))
+        return;
+
+    presets.setCurrent (index);
+    recallPreset (presets.getValues (index));
+}
+
+bool HtmlToVstPluginAudioProcessor::storeUserPreset (int index, const juce::String& name)
+{
+    if (! presets.store (index, captureValues(), name))
+        return false;
+
+    presets.setCurrent (index);
+    updateHostDisplay (juce::AudioProcessorListener::ChangeDetails().withProgramChanged (true));
+    return true;
+}
+
+void HtmlToVstPluginAudioProcessor::selectCompareSlot (int slot)
+{
+    if (const auto* values = presets.selectCompareSlot (slot, captureValues()))
+        recallPreset (*values);
+}
+
+void HtmlToVstPluginAudioProcessor::copyToOtherCompareSlot()
+{
+    presets.copyToOtherCompareSlot (captureValues());
+}
+
+void HtmlToVstPluginAudioProcessor::recallPreset (const Values& values)
+{
+    // Posted before any parameter changes, so the audio thread never runs a half-written
+    // set (see readBlockParams), and copied, so the bank may change while it's in flight
+    const auto sequence = ++lastPresetSequence;
+    presetHandoff.post (values, sequence);
 
-int HtmlToVstPluginAudioProcessor::getNumPrograms() { return 1; }
-int HtmlToVstPluginAudioProcessor::getCurrentProgram() { return 0; }
-void HtmlToVstPluginAudioProcessor::setCurrentProgram (int) {}
-const juce::String HtmlToVstPluginAudioProcessor::getProgramName (int) { return {}; }
-void HtmlToVstPluginAudioProcessor::changeProgramName (int, const juce::String&) {}
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+    {
+        if (! htmltovst::PresetBank::isPresetParameter ((int) i))
+            continue;
+
+        auto* p = paramObjects[i];
+        const auto normalised = p->convertTo0to1 (values[i]);
+
+        if (! juce::exactlyEqual (normalised, p->getValue()))
+            p->setValueNotifyingHost (normalised);
+    }
+
+    appliedPresetSequence.store (sequence);
+}
+
+HtmlToVstPluginAudioProcessor::Values HtmlToVstPluginAudioProcessor::captureValues() const noexcept
+{
+    Values values;
+
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+        values[i] = paramValues[i]->load();
+
+    return values;
+}
 
 //==============================================================================
 void HtmlToVstPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
@@ -73,18 +348,294 @@ void HtmlToVstPluginAudioProcessor::prepareToPlay (double sampleRate, int sample
     spec.maximumBlockSize = (juce::uint32) samplesPerBlock;
     spec.numChannels = (juce::uint32) juce::jmax (1, getTotalNumOutputChannels());
 
-    inGain.prepare (spec);
-    driveGain.prepare (spec);
-    driveShaper.prepare (spec);
-    outGain.prepare (spec);
+    maxBlockSize = juce::jmax (1, samplesPerBlock);
+
+    // Hosts pick the precision before preparing; the other chain keeps no oversamplers.
+    const auto useDouble = isUsingDoublePrecision();
+    prepareChain (floatChain, spec, ! useDouble);
+    prepareChain (doubleChain, spec, useDouble);
+
+    for (auto& e : engines)
+    {
+        e.inRamp.reset (sampleRate, 0.01);
+        e.driveRamp.reset (sampleRate, 0.01);
+        e.outRamp.reset (sampleRate, 0.01);
+    }
+
+    // A preset recalled before now simply applies
+    readBlockParams();
+    presetPending = false;
+    presetFadeLength = juce::jmax (1, juce::roundToInt (kPresetFadeSeconds * sampleRate));
+    presetFadeRemaining = 0;
+
+    auto& live = getLiveEngine();
+    live.params = blockParams;
+
+    meters.prepare (sampleRate);
+    cpuTelemetry.prepare (sampleRate);
+
+    if (engineGraph.isCompiled())
+        engineGraph.prepare (sampleRate, maxBlockSize, (int) spec.numChannels, useDouble, *sharedTables);
+
+    // Hosts set the offline flag before preparing a render, so it starts in its profile
+    activeQuality.store (resolveQuality());
+
+    if (kUseTapeEngine)
+    {
+        dspWorkers.start (requestedDspWorkers.load(), sampleRate, maxBlockSize);
+        splitGate.reset();
+
+        for (auto& e : engines)
+        {
+            e.tape.prepare (htmltovst::TapeHysteresis::getSharedCalibration (*sharedTables));
+            e.tapeEq.prepare (htmltovst::TapeEq::getSharedBank (*sharedTables, sampleRate), sampleRate);
+            e.convolver.prepare (htmltovst::Convolver::getSharedBank (*sharedTables, sampleRate), sampleRate, (int) spec.numChannels);
+            e.wowFlutter.prepare (htmltovst::WowFlutter::getSharedSincTable (*sharedTables), sampleRate);
+        }
+
+        auto& ref = referenceTape;
+        ref.tape.prepare (htmltovst::TapeHysteresis::getSharedCalibration (*sharedTables));
+        ref.tapeEq.prepare (htmltovst::TapeEq::getSharedBank (*sharedTables, sampleRate), sampleRate);
+        ref.convolver.prepare (htmltovst::Convolver::getSharedBank (*sharedTables, sampleRate), sampleRate, (int) spec.numChannels);
+        ref.wowFlutter.prepare (htmltovst::WowFlutter::getSharedSincTable (*sharedTables), sampleRate);
+
+        updateTapeSettings (live, live.params);
+        live.tape.reset();
+        live.wowFlutter.reset();
+
+        updateTapeSettings (ref, live.params);
+        ref.tape.reset();
+        ref.wowFlutter.reset();
+    }
+
+    silenceGate.reset();
+    microBlocks.reset();
+
+    for (auto& e : engines)
+    {
+        e.oversamplerSlot = -1;
+        e.oversamplerLatency = 0;
+    }
+
+    selectOversampler (false);
+    updateTailLength();
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::prepareChain (Chain<SampleType>& chain, const juce::dsp::ProcessSpec& spec, bool withOversamplers)
+{
+    chain.inGain.prepare (spec);
+    chain.driveGain.prepare (spec);
+    chain.driveShaper.prepare (spec);
+    chain.outGain.prepare (spec);
+
+    chain.inGain.setRampDurationSeconds (0.01);
+    chain.driveGain.setRampDurationSeconds (0.01);
+    chain.outGain.setRampDurationSeconds (0.01);
+
+    // Build every oversampler up front; processBlock only switches between them.
+    for (auto& engineOversamplers : chain.oversamplers)
+    {
+        for (int slot = 0; slot < kNumOversamplerSlots; ++slot)
+        {
+            auto& os = engineOversamplers[(size_t) slot];
+            os.reset();
+
+            if (withOversamplers)
+            {
+                os = makeOversampler<SampleType> (spec.numChannels, slot);
+                os->initProcessing ((size_t) maxBlockSize);
+            }
+        }
+    }
+
+    if (! withOversamplers)
+    {
+        chain.fadeInput.setSize (0, 0);
+        return;
+    }
+
+    chain.fadeInput.setSize ((int) spec.numChannels, maxBlockSize);
+
+    // Tails depend only on the filter design and the rate, so every instance shares one set
+    const auto key = juce::String ("oversamplerTails/") + juce::String (spec.sampleRate)
+                       + (std::is_same_v<SampleType, double> ? "/double" : "/float");
+
+    oversamplerTails = *sharedTables->get<OversamplerTails> (key, [&spec]
+    {
+        return measureOversamplerTails<SampleType> (spec.sampleRate);
+    });
+}
+
+template <typename SampleType>
+std::unique_ptr<juce::dsp::Oversampling<SampleType>> HtmlToVstPluginAudioProcessor::makeOversampler (size_t numChannels, int slot)
+{
+    const auto mode   = slot / (kNumOversamplingFactors - 1);
+    const auto stages = (size_t) (slot % (kNumOversamplingFactors - 1) + 1);
+    const auto type   = mode == 0 ? juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR
+                                  : juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple;
+
+    return std::make_unique<juce::dsp::Oversampling<SampleType>> (numChannels, stages, type, true, true);
+}
+
+template <typename SampleType>
+HtmlToVstPluginAudioProcessor::OversamplerTails HtmlToVstPluginAudioProcessor::measureOversamplerTails (double sampleRate)
+{
+    constexpr int blockSize = 512;
+    OversamplerTails tails {};
+
+    for (int slot = 0; slot < kNumOversamplerSlots; ++slot)
+    {
+        auto os = makeOversampler<SampleType> (1, slot);
+        os->initProcessing ((size_t) blockSize);
+        tails[(size_t) slot] = measureOversamplerTail (*os, 1, blockSize, sampleRate);
+    }
+
+    return tails;
+}
+
+template <typename SampleType>
+HtmlToVstPluginAudioProcessor::Chain<SampleType>& HtmlToVstPluginAudioProcessor::getChain() noexcept
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return doubleChain;
+    else
+        return floatChain;
+}
+
+template <typename SampleType>
+juce::dsp::Oversampling<SampleType>* HtmlToVstPluginAudioProcessor::getActiveOversampler (const Engine& engine) noexcept
+{
+    // Null (1x) also if this precision wasn't prepared, rather than touching unbuilt state
+    return engine.oversamplerSlot < 0 ? nullptr
+                                      : getChain<SampleType>().oversamplers[(size_t) engine.index][(size_t) engine.oversamplerSlot].get();
+}
+
+HtmlToVstPluginAudioProcessor::Quality HtmlToVstPluginAudioProcessor::resolveQuality() const noexcept
+{
+    const auto chosen = (Quality) juce::jlimit (0, 3, (int) getParamValue (HtmlToVstParam::quality));
+
+    if (chosen != Quality::automatic)
+        return chosen;
+
+    return isNonRealtime() ? Quality::best : Quality::realtime;
+}
+
+void HtmlToVstPluginAudioProcessor::selectOversampler (bool notifyHost)
+{
+    auto& live = getLiveEngine();
+
+    auto factorIndex = applyQuality (activeQuality.load(), (int) live.params[HtmlToVstParam::osFactor], kEcoMaxOsFactor, kBestMinOsFactor);
+    factorIndex = juce::jlimit (0, kNumOversamplingFactors - 1, factorIndex);
+    const auto modeIndex = juce::jlimit (0, kNumOversamplingModes - 1, (int) live.params[HtmlToVstParam::osMode]);
+
+    // The reference chain and the engine graph always run at the host rate.
+    if (dspPath.load() == DspPath::reference || isRunningGraph())
+        factorIndex = 0;
+
+    const int slot = factorIndex == 0 ? -1 : modeIndex * (kNumOversamplingFactors - 1) + factorIndex - 1;
+
+    if (slot != live.oversamplerSlot)
+    {
+        live.oversamplerSlot = slot;
+        live.oversamplerLatency = isUsingDoublePrecision() ? resetOversampler (getActiveOversampler<double> (live))
+                                                           : resetOversampler (getActiveOversampler<float> (live));
+    }
+
+    updateLatency (notifyHost);
+}
+
+void HtmlToVstPluginAudioProcessor::updateLatency (bool notifyHost)
+{
+    // The wow/flutter line's centre delay is there whatever its depth, on the tape engine only
+    const auto& live = getLiveEngine();
+    const auto& wowFlutter = dspPath.load() == DspPath::reference ? referenceTape.wowFlutter : live.wowFlutter;
+    const auto tapeDelay = kUseTapeEngine && ! isRunningGraph() ? wowFlutter.getLatencySamples() : 0;
+    const auto latency = live.oversamplerLatency + tapeDelay;
+
+    if (notifyHost && latency == pendingLatency.load())
+        return;
+
+    pendingLatency.store (latency);
+
+    // setLatencySamples notifies the host, which must not happen on the audio thread.
+    // Neither may triggerAsyncUpdate (it posts a message: a lock and an allocation), so
+    // the message thread polls a flag instead.
+    if (notifyHost)
+        latencyChanged.store (true);
+    else
+        setLatencySamples (latency);
+}
+
+void HtmlToVstPluginAudioProcessor::pollMessageThread()
+{
+    if (latencyChanged.exchange (false))
+        setLatencySamples (pendingLatency.load());
+
+    if (const auto seconds = cpuLogSeconds.load(); seconds > 0.0)
+    {
+        const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+
+        if (nowMs - lastCpuLogMs >= seconds * 1000.0)
+        {
+            lastCpuLogMs = nowMs;
+            logCpuTelemetry();
+        }
+    }
+}
+
+void HtmlToVstPluginAudioProcessor::logCpuTelemetry()
+{
+    const auto snapshot = cpuTelemetry.getSnapshot();
+    const auto s = htmltovst::CpuTelemetry::summarise (snapshot, lastLoggedCpu);
+    lastLoggedCpu = snapshot;
+
+    if (s.blocks == 0)
+        return;
+
+    juce::String line;
+    line << "HTMLtoVST CPU " << getInstanceName() << ": " << (juce::int64) s.blocks << " blocks, mean "
+         << juce::String (s.meanLoad * 100.0, 2) << "% (" << juce::String (s.meanUs, 1) << " us), p99 "
+         << juce::String (s.p99Load * 100.0, 2) << "%, max "
+         << juce::String (s.maxLoad * 100.0, 2) << "% of the block; measuring cost "
+         << juce::String (s.overhead * 100.0, 2) << "% of that";
+
+    juce::Logger::writeToLog (line);
+}
+
+juce::String HtmlToVstPluginAudioProcessor::getInstanceName() const
+{
+    const juce::ScopedLock sl (trackNameLock);
+    return "#" + juce::String (instanceNumber) + (trackName.isNotEmpty() ? " '" + trackName + "'" : juce::String());
+}
+
+void HtmlToVstPluginAudioProcessor::updateTrackProperties (const TrackProperties& properties)
+{
+    const juce::ScopedLock sl (trackNameLock);
+    trackName = properties.name.value_or (juce::String());
+}
 
-    inGain.setRampDurationSeconds (0.01);
-    driveGain.setRampDurationSeconds (0.01);
-    outGain.setRampDurationSeconds (0.01);
+void HtmlToVstPluginAudioProcessor::noteUiParameterChange() noexcept
+{
+    // Keep the oldest stamp until the audio thread has seen it
+    juce::int64 none = 0;
+    pendingUiChangeTicks.compare_exchange_strong (none, juce::Time::getHighResolutionTicks());
+}
+
+HtmlToVstPluginAudioProcessor::UiLatency HtmlToVstPluginAudioProcessor::getUiToDspLatency() const noexcept
+{
+    const auto msPerTick = 1000.0 / (double) juce::Time::getHighResolutionTicksPerSecond();
+
+    UiLatency l;
+    l.count  = uiChangeCount.load();
+    l.meanMs = l.count > 0 ? (double) uiLatencySumTicks.load() * msPerTick / (double) l.count : 0.0;
+    l.maxMs  = (double) uiLatencyMaxTicks.load() * msPerTick;
+    return l;
 }
 
 void HtmlToVstPluginAudioProcessor::releaseResources()
 {
+    dspWorkers.stop();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -93,7 +644,7 @@ bool HtmlToVstPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
     const auto mainOut = layouts.getMainOutputChannelSet();
     const auto mainIn  = layouts.getMainInputChannelSet();
 
-    if (mainOut != juce::AudioChannelSet::mono() && mainOut != juce::AudioChannelSet::stereo())
+    if (mainOut.isDisabled() || mainOut.size() > kMaxChannels)
         return false;
 
     return mainOut == mainIn;
@@ -101,54 +652,662 @@ bool HtmlToVstPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
 #endif
 
 void HtmlToVstPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    const htmltovst::RealtimeCheck::ScopedRealtime realtime;
+    const htmltovst::CpuTelemetry::ScopedBlock timing (cpuTelemetry, buffer.getNumSamples());
+    processBlockImpl (buffer, midi);
+}
+
+void HtmlToVstPluginAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midi)
+{
+    const htmltovst::RealtimeCheck::ScopedRealtime realtime;
+    const htmltovst::CpuTelemetry::ScopedBlock timing (cpuTelemetry, buffer.getNumSamples());
+    processBlockImpl (buffer, midi);
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::processBlockImpl (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midi)
 {
     juce::ScopedNoDenormals noDenormals;
     midi.clear();
 
+    if (const auto stamp = pendingUiChangeTicks.exchange (0); stamp != 0)
+    {
+        // Only this thread writes the stats, so plain load/store is enough.
+        const auto ticks = juce::Time::getHighResolutionTicks() - stamp;
+        uiLatencySumTicks.store (uiLatencySumTicks.load() + ticks);
+        uiLatencyMaxTicks.store (juce::jmax (uiLatencyMaxTicks.load(), ticks));
+        uiChangeCount.store (uiChangeCount.load() + 1);
+    }
+
     const auto totalNumInputChannels  = getTotalNumInputChannels();
     const auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     for (int ch = totalNumInputChannels; ch < totalNumOutputChannels; ++ch)
         buffer.clear (ch, 0, buffer.getNumSamples());
 
-    const float inDb   = apvts.getRawParameterValue ("inGain")->load();
-    const float drive  = apvts.getRawParameterValue ("drive")->load();
-    const float outDb  = apvts.getRawParameterValue ("outGain")->load();
+    const auto numSamples = buffer.getNumSamples();
+    const auto metering = meters.isActive();
+    const auto inRms = metering ? htmltovst::MeterStream::getRms (buffer.getArrayOfReadPointers(), buffer.getNumChannels(), numSamples)
+                                : 0.0f;
+
+    // The fused path resolves its settings where a micro-block starts, the others every block
+    if (dspPath.load() != DspPath::reference && ! isRunningGraph())
+    {
+        processScheduled (buffer);
+    }
+    else
+    {
+        microBlocks.reset();
+        resolveSettings (false);
+        presetFading.store (false);
+
+        const auto gains = getGains (getLiveEngine().params);
+
+        if (dspPath.load() == DspPath::reference)
+        {
+            processReference (buffer, gains.in, gains.drive, gains.out);
+        }
+        else
+        {
+            updateTailLength();
+            engineGraph.process (buffer);
+        }
+    }
+
+    if (metering)
+    {
+        const auto& live = getLiveEngine();
+        const auto gains = getGains (live.params);
+        const auto tapeGain = ! kUseTapeEngine ? 1.0f
+                            : dspPath.load() == DspPath::reference ? referenceTape.tape.getSmallSignalGain()
+                                                                   : live.tape.getSmallSignalGain();
+        const auto expectedGain = isRunningGraph() ? engineGraph.getSmallSignalGain() : gains.in * gains.drive * gains.out * tapeGain;
+        meters.pushBlock (buffer.getArrayOfReadPointers(), buffer.getNumChannels(), numSamples,
+                          inRms, expectedGain, live.params[HtmlToVstParam::drive]);
+    }
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::processScheduled (juce::AudioBuffer<SampleType>& buffer)
+{
+    const auto numSamples = buffer.getNumSamples();
+    bool fading = false;
+
+    if (! microBlocksEnabled.load())
+    {
+        microBlocks.reset();
+        resolveSettings (true);
+        fading = processPiece (buffer, 0, numSamples);
+    }
+    else
+    {
+        // Up to the first micro-block this block starts, the last one's settings carry on
+        const auto boundary = microBlocks.advance (numSamples);
+        const auto head = boundary < 0 ? numSamples : boundary;
+
+        if (head > 0)
+            fading = processPiece (buffer, 0, head);
+
+        // Past it the settings read there hold to the end: the host moves no parameter during
+        // a call, so the later micro-blocks would only read the same values again. A split tape
+        // stage needs the whole stretch to be worth waking the workers for.
+        if (boundary >= 0)
+        {
+            resolveSettings (true);
+
+            const auto pieceSize = dspWorkers.getNumWorkers() > 0 ? numSamples : htmltovst::MicroBlockScheduler::kBlockSize;
+
+            for (int pos = boundary; pos < numSamples; pos += pieceSize)
+                fading = processPiece (buffer, pos, juce::jmin (pieceSize, numSamples - pos)) || fading;
+        }
+    }
+
+    presetFading.store (fading);
+}
+
+template <typename SampleType>
+bool HtmlToVstPluginAudioProcessor::processPiece (juce::AudioBuffer<SampleType>& buffer, int start, int numSamples)
+{
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), kMaxChannels);
+    std::array<SampleType*, kMaxChannels> channels {};
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[(size_t) ch] = buffer.getWritePointer (ch, start);
+
+    juce::AudioBuffer<SampleType> piece (channels.data(), numChannels, numSamples);
+
+    if (presetFadeRemaining > 0)
+    {
+        processPresetFade (piece);
+        return true;
+    }
+
+    if (! skipSilentBlock (piece))
+        processFused (piece, getLiveEngine());
+
+    return false;
+}
+
+void HtmlToVstPluginAudioProcessor::resolveSettings (bool fused)
+{
+    readBlockParams();
+
+    // A host may flip the offline flag without preparing again; pick that up here too
+    activeQuality.store (resolveQuality());
+
+    // Settings move on once a crossfade has finished. A preset fades in on the fused path;
+    // elsewhere, and for any other change, the live engine simply follows the parameters.
+    if (! fused)
+        presetFadeRemaining = 0;
+
+    if (presetFadeRemaining == 0)
+    {
+        if (presetPending && fused && blockParams != getLiveEngine().params)
+            startPresetFade();
+        else
+            getLiveEngine().params = blockParams;
+
+        presetPending = false;
+    }
+
+    selectOversampler (true);
+
+    if (! fused)
+        return;
+
+    auto& live = getLiveEngine();
+    const auto gains = getGains (live.params);
+
+    live.inRamp.setTarget (gains.in);
+    live.driveRamp.setTarget (gains.drive);
+    live.outRamp.setTarget (gains.out);
+
+    if (kUseTapeEngine)
+        updateTapeSettings (live, live.params);
+
+    updateTailLength();
+}
+
+void HtmlToVstPluginAudioProcessor::readBlockParams() noexcept
+{
+    // The parameters first, then the handoff: a preset is posted before any of its values
+    // are written, so if this caught some of them, take() finds the preset.
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+        blockParams[i] = paramValues[i]->load();
+
+    if (const auto* posted = presetHandoff.take())
+    {
+        presetValues = posted->values;
+        presetSequence = posted->sequence;
+        presetPending = true;
+    }
+
+    if (presetSequence == 0)
+        return;
+
+    // Until the message thread has written every value, the preset stands in for them
+    if (appliedPresetSequence.load() < presetSequence)
+    {
+        for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+            if (htmltovst::PresetBank::isPresetParameter ((int) i))
+                blockParams[i] = presetValues[i];
+
+        return;
+    }
+
+    // Written: reading again now sees all of them, and anything the user changed since
+    presetSequence = 0;
+
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+        blockParams[i] = paramValues[i]->load();
+}
+
+void HtmlToVstPluginAudioProcessor::startPresetFade() noexcept
+{
+    liveEngine = 1 - liveEngine;
+
+    auto& e = getLiveEngine();
+    e.params = blockParams;
+
+    // The incoming engine starts from rest right on its settings, with no ramps or glides:
+    // the crossfade is the transition.
+    const auto gains = getGains (e.params);
+    e.inRamp.setCurrentAndTarget (gains.in);
+    e.driveRamp.setCurrentAndTarget (gains.drive);
+    e.outRamp.setCurrentAndTarget (gains.out);
+
+    if (kUseTapeEngine)
+    {
+        e.tapeEq.reset();
+        e.convolver.reset();
+        updateTapeSettings (e, e.params);
+        e.tape.reset();
+        e.wowFlutter.reset();
+    }
+
+    // selectOversampler() picks its slot and resets that oversampler
+    e.oversamplerSlot = -1;
+    e.oversamplerLatency = 0;
+
+    presetFadeRemaining = presetFadeLength;
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::processPresetFade (juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& fadeInput = getChain<SampleType>().fadeInput;
+    auto& incoming = getLiveEngine();
+    auto& outgoing = engines[(size_t) (1 - liveEngine)];
+
+    // Only the prepared precision has a copy buffer; anything else switches without a fade
+    if (fadeInput.getNumChannels() < buffer.getNumChannels())
+    {
+        presetFadeRemaining = 0;
+        processFused (buffer, incoming);
+        return;
+    }
+
+    const auto numSamples  = buffer.getNumSamples();
+    const auto numChannels = buffer.getNumChannels();
+    std::array<SampleType*, kMaxChannels> oldChannels {}, newChannels {};
+    int pos = 0;
+
+    // Both engines run in prepared-size chunks for as long as the fade lasts
+    while (pos < numSamples && presetFadeRemaining > 0)
+    {
+        const auto n = juce::jmin (maxBlockSize, numSamples - pos);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            newChannels[(size_t) ch] = buffer.getWritePointer (ch, pos);
+            oldChannels[(size_t) ch] = fadeInput.getWritePointer (ch);
+            std::copy (newChannels[(size_t) ch], newChannels[(size_t) ch] + n, oldChannels[(size_t) ch]);
+        }
+
+        juce::AudioBuffer<SampleType> oldPart (oldChannels.data(), numChannels, n);
+        juce::AudioBuffer<SampleType> newPart (newChannels.data(), numChannels, n);
+        processFused (oldPart, outgoing);
+        processFused (newPart, incoming);
+
+        // Equal power: settings far apart (decorrelated) hold their loudness through the
+        // fade, near-identical ones run up to 3 dB hot around its middle for a few ms.
+        const auto faded = presetFadeLength - presetFadeRemaining;
+        const auto numFading = juce::jmin (n, presetFadeRemaining);
+
+        for (int i = 0; i < numFading; ++i)
+        {
+            const auto angle = juce::MathConstants<float>::halfPi * (float) (faded + i + 1) / (float) presetFadeLength;
+            const auto oldGain = (SampleType) std::cos (angle);
+            const auto newGain = (SampleType) std::sin (angle);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                newChannels[(size_t) ch][i] = newGain * newChannels[(size_t) ch][i] + oldGain * oldChannels[(size_t) ch][i];
+        }
+
+        presetFadeRemaining -= numFading;
+        pos += n;
+    }
+
+    if (pos < numSamples)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            newChannels[(size_t) ch] = buffer.getWritePointer (ch, pos);
+
+        juce::AudioBuffer<SampleType> rest (newChannels.data(), numChannels, numSamples - pos);
+        processFused (rest, incoming);
+    }
+}
+
+void HtmlToVstPluginAudioProcessor::updateTailLength() noexcept
+{
+    const auto sampleRate = getSampleRate();
+
+    if (sampleRate <= 0.0)
+        return;
+
+    const auto& live = getLiveEngine();
+    auto seconds = live.oversamplerSlot < 0 ? 0.0 : oversamplerTails[(size_t) live.oversamplerSlot] / sampleRate;
+
+    if (isRunningGraph())
+        seconds = engineGraph.getTailSeconds (htmltovst::SilenceGate::kDefaultThreshold);
+    else if (kUseTapeEngine)
+        seconds += live.tape.getTailSeconds (htmltovst::SilenceGate::kDefaultThreshold)
+                 + live.tapeEq.getTailSeconds (htmltovst::SilenceGate::kDefaultThreshold)
+                 + live.convolver.getTailSeconds()
+                 + live.wowFlutter.getLatencySamples() / sampleRate;
+
+    tailSeconds.store (seconds);
+    silenceGate.setTailSamples ((int) std::ceil (seconds * sampleRate));
+}
+
+template <typename SampleType>
+bool HtmlToVstPluginAudioProcessor::skipSilentBlock (juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    if (! silenceBypass.load())
+    {
+        silenceGate.reset();
+        return false;
+    }
+
+    auto& live = getLiveEngine();
+
+    // The chain never has more gain than its small-signal gain (tanh and the tape both
+    // compress), so this input threshold keeps the output below the gate's floor.
+    auto gain = juce::jmax (live.inRamp.getCurrent(),    live.inRamp.getTarget())
+              * juce::jmax (live.driveRamp.getCurrent(), live.driveRamp.getTarget())
+              * juce::jmax (live.outRamp.getCurrent(),   live.outRamp.getTarget());
+
+    if (kUseTapeEngine)
+        gain *= live.tape.getSmallSignalGain();
+
+    const auto threshold = htmltovst::SilenceGate::kDefaultThreshold / juce::jmax (gain, 1.0e-6f);
+    const auto numSamples = buffer.getNumSamples();
+
+    if (! silenceGate.update (buffer.getArrayOfReadPointers(), buffer.getNumChannels(), numSamples, threshold))
+        return false;
+
+    // Everything the chain could emit has already been rendered. Keep the smoothers moving
+    // exactly as processing would, so the first audible block starts from the right gains.
+    buffer.clear();
+    live.inRamp.skip (numSamples);
+    live.driveRamp.skip (numSamples);
+    live.outRamp.skip (numSamples);
+    return true;
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::processFused (juce::AudioBuffer<SampleType>& buffer, Engine& engine)
+{
+    const auto numSamples = buffer.getNumSamples();
+    auto* const activeOversampler = getActiveOversampler<SampleType> (engine);
+    auto& inRamp    = engine.inRamp;
+    auto& driveRamp = engine.driveRamp;
+    auto& outRamp   = engine.outRamp;
+
+    if (kUseTapeEngine)
+    {
+        processTape (buffer, engine);
+        return;
+    }
+
+    if (activeOversampler == nullptr)
+    {
+        htmltovst::DriveKernel::process (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples,
+                                         inRamp.getSegment(), driveRamp.getSegment(), outRamp.getSegment());
+
+        inRamp.skip (numSamples);
+        driveRamp.skip (numSamples);
+        outRamp.skip (numSamples);
+        return;
+    }
+
+    // Run the whole fused kernel at the oversampled rate, with the gain ramps stretched
+    // to match. Hosts may exceed the prepared block size, so go in prepared-size chunks.
+    const auto factor = (int) activeOversampler->getOversamplingFactor();
+    juce::dsp::AudioBlock<SampleType> block (buffer);
+    std::array<SampleType*, kMaxChannels> upChannels {};
+
+    for (int pos = 0; pos < numSamples; pos += maxBlockSize)
+    {
+        const auto n = juce::jmin (maxBlockSize, numSamples - pos);
+        auto sub = block.getSubBlock ((size_t) pos, (size_t) n);
+        auto up  = activeOversampler->processSamplesUp (sub);
+
+        const auto pre  = inRamp.getSegment().stretched (factor);
+        const auto drv  = driveRamp.getSegment().stretched (factor);
+        const auto post = outRamp.getSegment().stretched (factor);
+
+        // All channels in one call, so the ramps are evaluated once for the whole layout
+        const auto numUp = juce::jmin ((int) up.getNumChannels(), kMaxChannels);
+
+        for (int ch = 0; ch < numUp; ++ch)
+            upChannels[(size_t) ch] = up.getChannelPointer ((size_t) ch);
+
+        htmltovst::DriveKernel::process (upChannels.data(), numUp, (int) up.getNumSamples(), pre, drv, post);
+
+        activeOversampler->processSamplesDown (sub);
+
+        inRamp.skip (n);
+        driveRamp.skip (n);
+        outRamp.skip (n);
+    }
+}
+
+template <typename Stages>
+void HtmlToVstPluginAudioProcessor::updateTapeSettings (Stages& stages, const Values& p) noexcept
+{
+    const auto quality = activeQuality.load();
+
+    htmltovst::TapeHysteresis::Settings s;
+    s.tapeType  = (int) getValueOr (p, kTapeTypeParam, (float) s.tapeType);
+    s.fluxivity = (float) getChoiceValueOr (p, kFluxParam, s.fluxivity);
+    s.bias      = getValueOr (p, kBiasParam, s.bias);
+    s.recordDb  = getValueOr (p, kRecordParam, s.recordDb);
+    s.reproDb   = getValueOr (p, kReproParam, s.reproDb);
+    s.autoCal   = getValueOr (p, kAutoCalParam, s.autoCal ? 1.0f : 0.0f) >= 0.5f;
+    s.solver    = (htmltovst::TapeHysteresis::Solver) applyQuality (quality, (int) getValueOr (p, kSolverParam, 0.0f),
+                                                                    kEcoMaxSolver, kBestMinSolver);
+    stages.tape.setSettings (s);
+
+    stages.tapeEq.select ((htmltovst::TapeEq::Standard) (int) getValueOr (p, kEqParam, 0.0f),
+                          htmltovst::TapeEq::getSpeedIndex (getChoiceValueOr (p, kSpeedParam, 15.0)));
+
+    stages.convolver.select (htmltovst::Convolver::getIrIndex ((htmltovst::Convolver::Headblock) (int) getValueOr (p, kHeadblockParam, 0.0f),
+                                                               getValueOr (p, kTransformerParam, 1.0f) >= 0.5f));
+
+    htmltovst::WowFlutter::Settings w;
+    w.wow           = getValueOr (p, kWowParam, w.wow);
+    w.flutter       = getValueOr (p, kFlutterParam, w.flutter);
+    w.speedIps      = getChoiceValueOr (p, kSpeedParam, w.speedIps);
+
+    const auto interpolation = applyQuality (quality, (int) getValueOr (p, kWowInterpParam, (float) (int) w.interpolation),
+                                             kEcoMaxInterp, kBestMinInterp);
+    w.interpolation = (htmltovst::WowFlutter::Interpolation) juce::jlimit (0, 3, interpolation);
+    stages.wowFlutter.setSettings (w);
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::processTape (juce::AudioBuffer<SampleType>& buffer, Engine& engine)
+{
+    using htmltovst::TapeHysteresis;
+
+    auto* const activeOversampler = getActiveOversampler<SampleType> (engine);
+    auto& tapeEq = engine.tapeEq;
+    const auto numSamples  = buffer.getNumSamples();
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), TapeHysteresis::kMaxChannels);
+    auto* const* channels  = buffer.getArrayOfWritePointers();
 
-    inGain.setGainLinear  (dbToGainSafe (inDb));
-    outGain.setGainLinear (dbToGainSafe (outDb));
+    // The gains are linear, so they stay at the host rate; only the hysteresis is oversampled.
+    htmltovst::DriveKernel::applyGain (channels, numChannels, numSamples, engine.inRamp.getSegment(), engine.driveRamp.getSegment());
+    engine.inRamp.skip (numSamples);
+    engine.driveRamp.skip (numSamples);
+
+    tapeEq.processRecord (channels, numChannels, numSamples);
+
+    if (activeOversampler == nullptr)
+    {
+        processHysteresis (engine, channels, numChannels, numSamples, getSampleRate());
+    }
+    else
+    {
+        const auto osRate = getSampleRate() * (double) activeOversampler->getOversamplingFactor();
+        juce::dsp::AudioBlock<SampleType> block (buffer);
+        std::array<SampleType*, TapeHysteresis::kMaxChannels> upChannels {};
+
+        for (int pos = 0; pos < numSamples; pos += maxBlockSize)
+        {
+            const auto n = juce::jmin (maxBlockSize, numSamples - pos);
+            auto sub = block.getSubBlock ((size_t) pos, (size_t) n);
+            auto up  = activeOversampler->processSamplesUp (sub);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                upChannels[(size_t) ch] = up.getChannelPointer ((size_t) ch);
+
+            processHysteresis (engine, upChannels.data(), numChannels, (int) up.getNumSamples(), osRate);
+            activeOversampler->processSamplesDown (sub);
+        }
+    }
+
+    tapeEq.processPlayback (channels, numChannels, numSamples);
+    engine.convolver.process (channels, numChannels, numSamples);
+    engine.wowFlutter.process (channels, numChannels, numSamples);
+
+    htmltovst::DriveKernel::applyGain (channels, numChannels, numSamples,
+                                       engine.outRamp.getSegment(), htmltovst::RampSegment::constant (1.0f));
+    engine.outRamp.skip (numSamples);
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::processHysteresis (Engine& engine, SampleType* const* channels, int numChannels, int numSamples, double rate) noexcept
+{
+    using htmltovst::TapeHysteresis;
+
+    auto& tape = engine.tape;
+    const auto numGroups = TapeHysteresis::getNumGroups (numChannels);
+
+    if (numGroups < 2 || dspWorkers.getNumWorkers() == 0)
+    {
+        tape.process (channels, numChannels, numSamples, rate);
+        dspSplitting.store (false);
+        return;
+    }
+
+    // Anything that changes the work per group is a new workload for the gate
+    const auto workload = (std::uint32_t) numGroups
+                        | (std::uint32_t) (engine.oversamplerSlot + 1) << 8
+                        | (std::uint32_t) tape.getSolver() << 16;
+
+    const auto forced = dspSplitForced.load();
+    const auto split = forced || splitGate.shouldSplit (workload);
+    const auto start = htmltovst::CpuTelemetry::now();
+
+    // Groups are independent, so either way gives the same samples
+    auto processGroup = [&] (int g) { tape.processChannelGroup (g, channels, numChannels, numSamples); };
+
+    tape.beginBlock (rate);
+
+    if (split)
+        dspWorkers.run (numGroups, processGroup);
+    else
+        for (int g = 0; g < numGroups; ++g)
+            processGroup (g);
+
+    tape.endBlock();
+
+    if (! forced)
+        splitGate.record (split, htmltovst::CpuTelemetry::now() - start, numSamples);
+
+    dspSplitting.store (split);
+}
+
+template <typename SampleType>
+void HtmlToVstPluginAudioProcessor::processReference (juce::AudioBuffer<SampleType>& buffer, float inLin, float k, float outLin)
+{
+    using htmltovst::TapeHysteresis;
+
+    auto& chain = getChain<SampleType>();
+
+    chain.inGain.setGainLinear  ((SampleType) inLin);
+    chain.outGain.setGainLinear ((SampleType) outLin);
 
     // Drive scaling happens via a gain stage BEFORE the waveshaper (no capturing lambda!)
-    const float k = 1.0f + 12.0f * juce::jlimit (0.0f, 1.0f, drive); // 1x..13x
-    driveGain.setGainLinear (k);
+    chain.driveGain.setGainLinear ((SampleType) k);
+
+    juce::dsp::AudioBlock<SampleType> block (buffer);
+    auto ctx = juce::dsp::ProcessContextReplacing<SampleType> (block);
+
+    chain.inGain.process (ctx);
+    chain.driveGain.process (ctx);
 
-    juce::dsp::AudioBlock<float> block (buffer);
-    auto ctx = juce::dsp::ProcessContextReplacing<float> (block);
+    if (kUseTapeEngine)
+    {
+        auto& ref = referenceTape;
+        const auto numSamples  = buffer.getNumSamples();
+        const auto numChannels = juce::jmin (buffer.getNumChannels(), TapeHysteresis::kMaxChannels);
+        auto* const* channels  = buffer.getArrayOfWritePointers();
 
-    inGain.process (ctx);
-    driveGain.process (ctx);
-    driveShaper.process (ctx);
-    outGain.process (ctx);
+        updateTapeSettings (ref, getLiveEngine().params);
+
+        ref.tapeEq.processRecord (channels, numChannels, numSamples);
+        ref.tape.process (channels, numChannels, numSamples, getSampleRate());
+        ref.tapeEq.processPlayback (channels, numChannels, numSamples);
+        ref.convolver.process (channels, numChannels, numSamples);
+        ref.wowFlutter.process (channels, numChannels, numSamples);
+    }
+    else
+    {
+        chain.driveShaper.process (ctx);
+    }
+
+    chain.outGain.process (ctx);
 }
 
 //==============================================================================
+#if HTMLTOVST_HEADLESS
+bool HtmlToVstPluginAudioProcessor::hasEditor() const { return false; }
+juce::AudioProcessorEditor* HtmlToVstPluginAudioProcessor::createEditor() { return nullptr; }
+#else
 bool HtmlToVstPluginAudioProcessor::hasEditor() const { return true; }
 
 juce::AudioProcessorEditor* HtmlToVstPluginAudioProcessor::createEditor()
 {
     return new HtmlToVstPluginAudioProcessorEditor (*this);
 }
+#endif
 
 //==============================================================================
 void HtmlToVstPluginAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    if (auto xml = state.createXml())
-        copyXmlToBinary (*xml, destData);
+    const auto values = captureValues();
+    std::vector<htmltovst::StateCodec::ExtraValue> extras;
+
+    for (const auto& p : runtimeParams)
+        extras.push_back ({ p.spec, p.value->load() });
+
+    htmltovst::StateCodec::write (values, destData, extras.data(), (int) extras.size());
+
+    // The preset bank follows the parameters, where builds without one stop reading
+    juce::MemoryOutputStream out (destData, true);
+    presets.write (out);
 }
 
 void HtmlToVstPluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    if (htmltovst::StateCodec::isBinary (data, sizeInBytes))
+    {
+        // Parameters the blob doesn't mention (added since it was saved) reset to default
+        auto values = htmltovst::StateCodec::getDefaults();
+        std::vector<htmltovst::StateCodec::ExtraValue> extras;
+
+        for (const auto& p : runtimeParams)
+            extras.push_back ({ p.spec, (float) p.spec->defaultValue });
+
+        if (! htmltovst::StateCodec::read (data, sizeInBytes, values, extras.data(), (int) extras.size()))
+            return;
+
+        // Sessions saved before the preset bank end here and keep the bank as it is
+        const auto size = htmltovst::StateCodec::getEncodedSize (data, sizeInBytes);
+        presets.read (static_cast<const char*> (data) + size, sizeInBytes - size);
+
+        auto apply = [] (juce::RangedAudioParameter* p, float value)
+        {
+            const auto normalised = p->convertTo0to1 (value);
+
+            if (! juce::exactlyEqual (normalised, p->getValue()))
+                p->setValueNotifyingHost (normalised);
+        };
+
+        for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+            apply (paramObjects[i], values[i]);
+
+        for (size_t i = 0; i < extras.size(); ++i)
+            apply (runtimeParams[i].object, extras[i].value);
+
+        return;
+    }
+
+    // Sessions saved before the binary format: APVTS state as XML
     if (auto xmlState = getXmlFromBinary (data, sizeInBytes))
         if (xmlState->hasTagName (apvts.state.getType()))
             apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
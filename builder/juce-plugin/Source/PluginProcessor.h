@@ -3,11 +3,31 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 
-class HtmlToVstPluginAudioProcessor final : public juce::AudioProcessor
+#include "CpuTelemetry.h"
+#include "DriveKernel.h"
+#include "EngineGraph.h"
+#include "GeneratedParams.h"
+#include "Convolver.h"
+#include "InstancePoller.h"
+#include "MeterStream.h"
+#include "MicroBlocks.h"
+#include "PresetBank.h"
+#include "ReferenceHysteresis.h"
+#include "SharedTables.h"
+#include "SilenceGate.h"
+#include "TapeEq.h"
+#include "TapeHysteresis.h"
+#include "WorkerPool.h"
+#include "WowFlutter.h"
+
+class WebViewPool;
+
+class HtmlToVstPluginAudioProcessor final : public juce::AudioProcessor,
+                                            private htmltovst::InstancePoller::Client
 {
 public:
     HtmlToVstPluginAudioProcessor();
-    ~HtmlToVstPluginAudioProcessor() override = default;
+    ~HtmlToVstPluginAudioProcessor() override;
 
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
@@ -17,7 +37,13 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
+    // Both precisions run the same templated chain in place, with no block-level copy. The
+    // gains and the tanh kernel compute in the buffer's precision; the tape stages (hysteresis,
+    // EQ, convolver, wow/flutter) compute in float, narrowing double samples as they load them;
+    // only the reference path's hysteresis runs in double.
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -32,6 +58,8 @@ public:
     double getTailLengthSeconds() const override;
 
     //==============================================================================
+    // Programs are the preset bank's (see PresetBank.h): the factory presets, then the
+    // user slots. Message thread.
     int getNumPrograms() override;
     int getCurrentProgram() override;
     void setCurrentProgram (int index) override;
@@ -45,12 +73,321 @@ public:
     //==============================================================================
     juce::AudioProcessorValueTreeState apvts;
 
-    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    /** The generated parameters, plus any that engineSpec defines beyond them. */
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout (const htmltovst::EngineSpec* engineSpec = nullptr);
+
+    /** Table-indexed parameter access (see GeneratedParams.h); O(1), no string lookups. */
+    float getParamValue (int index) const noexcept                  { return paramValues[(size_t) index]->load(); }
+    juce::RangedAudioParameter* getParameterByIndex (int index) const noexcept { return paramObjects[(size_t) index]; }
+
+    //==============================================================================
+    // The fused kernel is the production path; the original juce::dsp chain is kept
+    // as a reference so the two can be A/B'd and null-tested. On the tape engine the
+    // reference runs the same stages one after another at the host rate, with a scalar
+    // double-precision hysteresis solver in place of the SIMD one. A build with an embedded
+    // engine spec (HTMLTOVST_ENGINE_SPEC) runs that spec's graph instead, at the host
+    // rate and without the silence gate.
+    enum class DspPath
+    {
+        fused,
+        reference,
+        graph
+    };
+
+    void setDspPath (DspPath newPath) noexcept  { dspPath.store (newPath); }
+    DspPath getDspPath() const noexcept         { return dspPath.load(); }
+
+    /** True if an embedded engine spec compiled, i.e. DspPath::graph has something to run. */
+    bool hasEngineGraph() const noexcept        { return engineGraph.isCompiled(); }
+
+    //==============================================================================
+    // Any discrete or surround layout up to this many channels (input == output).
+    // Channels share one set of smoothed parameters and run in SIMD lanes.
+    static constexpr int kMaxChannels = 16;
+
+    //==============================================================================
+    // Oversampling around the drive stage: 1x/2x/4x/8x, polyphase IIR or linear-phase FIR
+    static constexpr int kNumOversamplingFactors = 4;   // 1x, 2x, 4x, 8x
+    static constexpr int kNumOversamplingModes   = 2;   // IIR, FIR
+
+    //==============================================================================
+    // Quality profile, from the "quality" parameter (in its option order). Eco caps the
+    // oversampling at 2x, the tape solver at RK2 and wow/flutter at linear interpolation;
+    // Realtime runs the settings as they are; Best raises them to at least 4x, NR x8 and
+    // sinc. Auto is Realtime while playing and Best while the host renders offline.
+    // Every oversampler is built in prepareToPlay, so a profile change never allocates.
+    enum class Quality
+    {
+        automatic,
+        eco,
+        realtime,
+        best
+    };
+
+    /** The profile the last block ran with (never automatic). */
+    Quality getActiveQuality() const noexcept                       { return activeQuality.load(); }
+
+    //==============================================================================
+    // Optional worker threads for the tape stage (see WorkerPool.h): the hysteresis runs
+    // its groups of four channels in parallel, so only layouts of more than four gain.
+    // numWorkers threads besides the host's, 0 = off (the default; HTMLTOVST_DSP_WORKERS=<n>
+    // in the environment sets it for every instance), from the next prepareToPlay. Blocks
+    // are only split while a SplitGate measures it paying; forcing skips the gate.
+    void setNumDspWorkers (int numWorkers) noexcept     { requestedDspWorkers.store (juce::jlimit (0, htmltovst::WorkerPool::kMaxWorkers, numWorkers)); }
+    void setDspSplitForced (bool shouldForce) noexcept  { dspSplitForced.store (shouldForce); }
+
+    /** True if the last block's tape stage ran split. */
+    bool isSplittingDsp() const noexcept                { return dspSplitting.load(); }
+
+    //==============================================================================
+    // A recalled preset reaches the audio thread whole, at the start of its next block.
+    // On the fused path the outgoing settings keep running on a second engine while the
+    // new ones start on the other, and the two are crossfaded (equal power) over
+    // kPresetFadeSeconds; a recall during a fade waits for it to end. Message thread.
+    static constexpr double kPresetFadeSeconds = 0.02;
+
+    const htmltovst::PresetBank& getPresetBank() const noexcept    { return presets; }
+
+    /** Saves the current settings into a user slot (by program index), and makes it current. */
+    bool storeUserPreset (int index, const juce::String& name = {});
+
+    /** A/B compare: stores the current settings in the selected slot, then recalls slot (0 or 1). */
+    void selectCompareSlot (int slot);
+    int getCompareSlot() const noexcept                             { return presets.getCompareSlot(); }
+
+    /** Copies the current settings into the slot not selected. */
+    void copyToOtherCompareSlot();
+
+    /** True if the last block crossfaded between presets. */
+    bool isPresetFading() const noexcept                            { return presetFading.load(); }
+
+    //==============================================================================
+    // The fused path runs in fixed micro-blocks (see MicroBlocks.h) and resolves its
+    // settings where one starts, not at every host block. On by default; off runs each
+    // host block whole with the settings read at its start.
+    void setMicroBlocksEnabled (bool shouldBeEnabled) noexcept      { microBlocksEnabled.store (shouldBeEnabled); }
+    bool isMicroBlocksEnabled() const noexcept                      { return microBlocksEnabled.load(); }
+
+    //==============================================================================
+    // Blocks of silent input are skipped (output cleared) once the engine's tail has
+    // been rendered. On by default; the fused path only.
+    void setSilenceBypassEnabled (bool shouldBeEnabled) noexcept  { silenceBypass.store (shouldBeEnabled); }
+    bool isSilenceBypassEnabled() const noexcept                  { return silenceBypass.load(); }
+
+    /** Host blocks skipped, or micro-blocks while those are on. */
+    std::uint64_t getNumSkippedBlocks() const noexcept            { return silenceGate.getNumSkippedBlocks(); }
+
+    //==============================================================================
+    // UI -> audio thread latency: the editor stamps a parameter change on the message
+    // thread, the next processBlock measures how long it took to be picked up.
+    void noteUiParameterChange() noexcept;
+
+    struct UiLatency
+    {
+        std::uint64_t count = 0;
+        double meanMs = 0.0;
+        double maxMs  = 0.0;
+    };
+
+    UiLatency getUiToDspLatency() const noexcept;
+
+    /** Levels, gain reduction and a decimated sample stream for the editor's meters. */
+    htmltovst::MeterStream& getMeterStream() noexcept               { return meters; }
+
+    //==============================================================================
+    // CPU load of every processBlock (see CpuTelemetry.h), for the editor and an optional
+    // periodic log line per instance: every `seconds` (0 = off; HTMLTOVST_CPU_LOG=<seconds>
+    // in the environment sets it for every instance), and once more when the instance goes.
+    const htmltovst::CpuTelemetry& getCpuTelemetry() const noexcept { return cpuTelemetry; }
+
+    void setCpuLogInterval (double seconds) noexcept                { cpuLogSeconds.store (juce::jmax (0.0, seconds)); }
+
+    /** "#<n>", plus the host's track name where it reports one. Message thread. */
+    juce::String getInstanceName() const;
+
+    void updateTrackProperties (const TrackProperties& properties) override;
 
 private:
-    // DSP chain: inGain -> driveGain -> tanh -> outGain
-    juce::dsp::Gain<float> inGain, driveGain, outGain;
-    juce::dsp::WaveShaper<float> driveShaper;
+    static constexpr int kNumOversamplerSlots = kNumOversamplingModes * (kNumOversamplingFactors - 1);
+
+    static constexpr int kNumEngines = 2;
+
+    // Per slot: impulse-response length in host-rate samples
+    using OversamplerTails = std::array<int, kNumOversamplerSlots>;
+
+    using Values = htmltovst::StateCodec::Values;
+
+    // Everything the fused path keeps between blocks, and the parameters it runs with.
+    // One is live; the other plays out the old settings during a preset crossfade.
+    struct Engine
+    {
+        Values params {};
+
+        htmltovst::GainRamp inRamp, driveRamp, outRamp;
+
+        // "ampex_102" engine: hysteresis replaces the tanh shaper, between record and
+        // playback EQ, then the head and transformer IRs, then wow and flutter
+        htmltovst::TapeHysteresis tape;
+        htmltovst::TapeEq tapeEq;
+        htmltovst::Convolver convolver;
+        htmltovst::WowFlutter wowFlutter;
+
+        int index = 0;                  // its oversamplers in each Chain
+        int oversamplerSlot = -1;       // -1 means 1x
+        int oversamplerLatency = 0;
+    };
+
+    // Everything that depends on the sample type. There is one of these per precision;
+    // the processing code below is written once against it.
+    template <typename SampleType>
+    struct Chain
+    {
+        // One oversampler per engine and (mode, factor > 1x). Only the chain matching the
+        // processing precision has them, all built in prepareToPlay, so switching never allocates.
+        std::array<std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, kNumOversamplerSlots>, kNumEngines> oversamplers;
+
+        // The outgoing engine's copy of the input during a preset crossfade, prepared size
+        juce::AudioBuffer<SampleType> fadeInput;
+
+        // Reference chain: inGain -> driveGain -> tanh -> outGain
+        juce::dsp::Gain<SampleType> inGain, driveGain, outGain;
+        juce::dsp::WaveShaper<SampleType> driveShaper;
+    };
+
+    template <typename SampleType> Chain<SampleType>& getChain() noexcept;
+    template <typename SampleType> juce::dsp::Oversampling<SampleType>* getActiveOversampler (const Engine& engine) noexcept;
+    template <typename SampleType> void prepareChain (Chain<SampleType>& chain, const juce::dsp::ProcessSpec& spec, bool withOversamplers);
+    template <typename SampleType> static std::unique_ptr<juce::dsp::Oversampling<SampleType>> makeOversampler (size_t numChannels, int slot);
+    template <typename SampleType> static OversamplerTails measureOversamplerTails (double sampleRate);
+
+    template <typename SampleType> void processBlockImpl (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midi);
+    template <typename SampleType> void processScheduled (juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> bool processPiece (juce::AudioBuffer<SampleType>& buffer, int start, int numSamples);
+    template <typename SampleType> void processFused (juce::AudioBuffer<SampleType>& buffer, Engine& engine);
+    template <typename SampleType> void processPresetFade (juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> void processReference (juce::AudioBuffer<SampleType>& buffer, float inLin, float k, float outLin);
+    template <typename SampleType> void processTape (juce::AudioBuffer<SampleType>& buffer, Engine& engine);
+    template <typename SampleType> void processHysteresis (Engine& engine, SampleType* const* channels, int numChannels, int numSamples, double rate) noexcept;
+    template <typename Stages> void updateTapeSettings (Stages& stages, const Values& p) noexcept;
+
+    Engine& getLiveEngine() noexcept                                { return engines[(size_t) liveEngine]; }
+    void readBlockParams() noexcept;
+    void resolveSettings (bool fused);
+    void startPresetFade() noexcept;
+    void recallPreset (const Values& values);
+    Values captureValues() const noexcept;
+
+    static std::unique_ptr<juce::RangedAudioParameter> makeParameter (const HtmlToVstParamSpec& p);
+    htmltovst::EngineGraph::ParamSource findParamSource (const juce::String& paramId) const;
+    bool isRunningGraph() const noexcept;
+
+    template <typename SampleType> bool skipSilentBlock (juce::AudioBuffer<SampleType>& buffer) noexcept;
+    void updateTailLength() noexcept;
+
+    Quality resolveQuality() const noexcept;
+    void selectOversampler (bool notifyHost);
+    void updateLatency (bool notifyHost);
+    void pollMessageThread() override;
+    void logCpuTelemetry();
+
+    std::atomic<DspPath> dspPath { DspPath::fused };
+    std::atomic<Quality> activeQuality { Quality::realtime };
+
+    // Cached once in the constructor, in kHtmlToVstParams order
+    std::array<std::atomic<float>*, kNumHtmlToVstParams> paramValues {};
+    std::array<juce::RangedAudioParameter*, kNumHtmlToVstParams> paramObjects {};
+
+    // Parameters an embedded engine spec adds beyond GeneratedParams.h, in spec order
+    struct RuntimeParam
+    {
+        const HtmlToVstParamSpec* spec = nullptr;
+        std::atomic<float>* value = nullptr;
+        juce::RangedAudioParameter* object = nullptr;
+    };
+
+    std::vector<RuntimeParam> runtimeParams;
+
+    Chain<float> floatChain;
+    Chain<double> doubleChain;
+
+    // Copied from the shared table for the current rate
+    OversamplerTails oversamplerTails {};
+    int maxBlockSize = 0;
+    std::atomic<int> pendingLatency { 0 };
+    std::atomic<bool> latencyChanged { false };
+
+    // Fused path: single pass, smoothed in/drive/out gains + fast tanh (or the tape)
+    std::array<Engine, kNumEngines> engines;
+    int liveEngine = 0;
+
+    // Reference path on the tape engine: the same stages, run unfused (see DspPath)
+    struct ReferenceTape
+    {
+        htmltovst::ReferenceHysteresis tape;
+        htmltovst::TapeEq tapeEq;
+        htmltovst::Convolver convolver;
+        htmltovst::WowFlutter wowFlutter;
+    };
+
+    ReferenceTape referenceTape;
+
+    // The parameters this block runs with: the host's, or a preset still being written to them
+    Values blockParams {};
+
+    htmltovst::PresetBank presets;
+    htmltovst::PresetHandoff presetHandoff;
+    std::uint32_t lastPresetSequence = 0;                   // message thread
+    std::atomic<std::uint32_t> appliedPresetSequence { 0 };
+
+    // Audio thread: the preset taken from the handoff, until the parameters all hold it
+    Values presetValues {};
+    std::uint32_t presetSequence = 0;
+    bool presetPending = false;
+    int presetFadeLength = 1, presetFadeRemaining = 0;
+    std::atomic<bool> presetFading { false };
+
+    htmltovst::MicroBlockScheduler microBlocks;
+    std::atomic<bool> microBlocksEnabled { true };
+
+    htmltovst::WorkerPool dspWorkers;
+    htmltovst::SplitGate splitGate;
+    std::atomic<int> requestedDspWorkers { 0 };
+    std::atomic<bool> dspSplitForced { false }, dspSplitting { false };
+
+    // Schedule compiled from the embedded engine spec; empty without one
+    htmltovst::EngineGraph engineGraph;
+
+    htmltovst::MeterStream meters;
+
+    htmltovst::CpuTelemetry cpuTelemetry;
+    htmltovst::CpuTelemetry::Snapshot lastLoggedCpu;
+    std::atomic<double> cpuLogSeconds { 0.0 };
+    double lastCpuLogMs = 0.0;
+    const int instanceNumber;
+
+    juce::CriticalSection trackNameLock;
+    juce::String trackName;
+
+    htmltovst::SilenceGate silenceGate;
+    std::atomic<bool> silenceBypass { true };
+    std::atomic<double> tailSeconds { 0.0 };
+
+    // Oldest unobserved UI change (high-res ticks, 0 = none) and pickup statistics
+    std::atomic<juce::int64> pendingUiChangeTicks { 0 };
+    std::atomic<std::uint64_t> uiChangeCount { 0 };
+    std::atomic<juce::int64> uiLatencySumTicks { 0 }, uiLatencyMaxTicks { 0 };
+
+    // Calibration and filter measurements, built once per process rather than per instance
+    juce::SharedResourcePointer<htmltovst::SharedTables> sharedTables;
+
+    // Picks up latency changes and CPU log lines on the message thread, for every instance at once
+    juce::SharedResourcePointer<htmltovst::InstancePoller> poller;
+
+   #if ! HTMLTOVST_HEADLESS
+    // Keeps the editors' webview pool, and the spare a closed editor handed back, alive
+    // with the plug-in. Never pre-warmed from here: only opening an editor fills it.
+    juce::SharedResourcePointer<WebViewPool> webViewPool;
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HtmlToVstPluginAudioProcessor)
 };
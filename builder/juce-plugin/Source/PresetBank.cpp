@@ -0,0 +1,241 @@
+#include "PresetBank.h"
+
+namespace htmltovst
+{
+
+static constexpr int kMagic = 0x50565448;       // "HTVP" read as little-endian
+static constexpr int kFormatVersion = 1;
+
+//==============================================================================
+// Values as the parameters hold them: choices by option index. IDs the current spec
+// doesn't define are skipped, everything not listed stays at its default.
+struct FactorySetting
+{
+    const char* id = nullptr;
+    float value = 0.0f;
+};
+
+struct FactoryPreset
+{
+    const char* name;
+    std::array<FactorySetting, 8> settings;
+};
+
+static const FactoryPreset kFactoryPresets[] =
+{
+    { "Init", {} },
+    { "456 @ 15 NAB",       {{ { "tapeType", 1 }, { "speed", 1 }, { "eq", 0 }, { "flux", 1 } }} },
+    { "456 Hot @ 15",       {{ { "tapeType", 1 }, { "speed", 1 }, { "eq", 0 }, { "flux", 2 }, { "inDb", 6.0f } }} },
+    { "GP9 @ 30 IEC",       {{ { "tapeType", 3 }, { "speed", 2 }, { "eq", 1 }, { "flux", 2 } }} },
+    { "SM911 @ 15 IEC",     {{ { "tapeType", 5 }, { "speed", 1 }, { "eq", 1 }, { "flux", 2 }, { "bias", 1.0f } }} },
+    { "499 Mastering",      {{ { "tapeType", 2 }, { "speed", 2 }, { "eq", 1 }, { "osFactor", 2 }, { "osMode", 1 },
+                               { "tapeSolver", 3 }, { "wowInterp", 3 } }} },
+    { "Worn 406 @ 7.5",     {{ { "tapeType", 0 }, { "speed", 0 }, { "flux", 0 }, { "bias", -2.0f }, { "inDb", 4.0f },
+                               { "wow", 0.35f }, { "flutter", 0.25f } }} },
+    { "Seasick",            {{ { "tapeType", 1 }, { "speed", 0 }, { "wow", 0.8f }, { "flutter", 0.5f }, { "wowInterp", 3 } }} },
+};
+
+//==============================================================================
+PresetBank::PresetBank()
+{
+    const auto defaults = StateCodec::getDefaults();
+
+    numFactory = (int) std::size (kFactoryPresets);
+    presets.resize ((size_t) (numFactory + kNumUserPresets), { {}, defaults });
+
+    for (int i = 0; i < numFactory; ++i)
+    {
+        auto& preset = presets[(size_t) i];
+        preset.name = kFactoryPresets[i].name;
+
+        for (const auto& s : kFactoryPresets[i].settings)
+            if (const auto index = s.id != nullptr ? findHtmlToVstParam (s.id) : -1; index >= 0)
+                preset.values[(size_t) index] = s.value;
+    }
+
+    for (int i = 0; i < kNumUserPresets; ++i)
+        presets[(size_t) (numFactory + i)].name = "User " + juce::String (i + 1);
+
+    compare.fill (defaults);
+}
+
+const PresetBank::Values& PresetBank::getValues (int index) const noexcept
+{
+    return presets[(size_t) juce::jlimit (0, getNumPresets() - 1, index)].values;
+}
+
+juce::String PresetBank::getName (int index) const
+{
+    return juce::isPositiveAndBelow (index, getNumPresets()) ? presets[(size_t) index].name : juce::String();
+}
+
+bool PresetBank::store (int index, const Values& values, const juce::String& name)
+{
+    if (! isUserPreset (index))
+        return false;
+
+    auto& preset = presets[(size_t) index];
+    preset.values = values;
+
+    if (name.isNotEmpty())
+        preset.name = name;
+
+    return true;
+}
+
+bool PresetBank::rename (int index, const juce::String& name)
+{
+    if (! isUserPreset (index) || name.isEmpty())
+        return false;
+
+    presets[(size_t) index].name = name;
+    return true;
+}
+
+bool PresetBank::isPresetParameter (int paramIndex) noexcept
+{
+    return paramIndex != HtmlToVstParam::quality;
+}
+
+//==============================================================================
+const PresetBank::Values* PresetBank::selectCompareSlot (int slot, const Values& live) noexcept
+{
+    slot = juce::jlimit (0, 1, slot);
+
+    if (slot == compareSlot)
+        return nullptr;
+
+    compare[(size_t) compareSlot] = live;
+    compareUsed[(size_t) compareSlot] = true;
+    compareSlot = slot;
+
+    if (! compareUsed[(size_t) slot])
+    {
+        compare[(size_t) slot] = live;
+        compareUsed[(size_t) slot] = true;
+        return nullptr;
+    }
+
+    return &compare[(size_t) slot];
+}
+
+void PresetBank::copyToOtherCompareSlot (const Values& live) noexcept
+{
+    compare[(size_t) (1 - compareSlot)] = live;
+    compareUsed[(size_t) (1 - compareSlot)] = true;
+}
+
+//==============================================================================
+static void writeValues (juce::OutputStream& out, const StateCodec::Values& values)
+{
+    juce::MemoryBlock blob;
+    StateCodec::write (values, blob);
+    out.writeInt ((int) blob.getSize());
+    out.write (blob.getData(), blob.getSize());
+}
+
+static bool readValues (juce::MemoryInputStream& in, StateCodec::Values& values)
+{
+    const auto size = in.readInt();
+
+    if (size <= 0 || size > in.getNumBytesRemaining())
+        return false;
+
+    const auto* data = static_cast<const char*> (in.getData()) + in.getPosition();
+    in.skipNextBytes (size);
+
+    // Parameters the snapshot doesn't mention keep their defaults
+    values = StateCodec::getDefaults();
+    return StateCodec::read (data, size, values);
+}
+
+void PresetBank::write (juce::OutputStream& out) const
+{
+    out.writeInt (kMagic);
+    out.writeShort ((short) kFormatVersion);
+    out.writeShort ((short) kNumUserPresets);
+
+    for (int i = 0; i < kNumUserPresets; ++i)
+    {
+        const auto& preset = presets[(size_t) (numFactory + i)];
+        out.writeString (preset.name);
+        writeValues (out, preset.values);
+    }
+
+    out.writeShort ((short) current);
+    out.writeByte ((char) compareSlot);
+
+    for (size_t slot = 0; slot < 2; ++slot)
+    {
+        out.writeBool (compareUsed[slot]);
+        writeValues (out, compare[slot]);
+    }
+}
+
+bool PresetBank::read (const void* data, int sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < 8)
+        return false;
+
+    juce::MemoryInputStream in (data, (size_t) sizeInBytes, false);
+
+    if (in.readInt() != kMagic || in.readShort() < 1)
+        return false;
+
+    // Everything is read aside first, so a truncated blob changes nothing
+    const auto numSaved = (int) (unsigned short) in.readShort();
+    std::vector<Preset> user ((size_t) numSaved);
+
+    for (auto& preset : user)
+    {
+        preset.name = in.readString();
+
+        if (! readValues (in, preset.values))
+            return false;
+    }
+
+    const auto savedCurrent = (int) in.readShort();
+    const auto savedSlot = (int) in.readByte();
+    std::array<Values, 2> savedCompare;
+    std::array<bool, 2> savedUsed {};
+
+    for (size_t slot = 0; slot < 2; ++slot)
+    {
+        savedUsed[slot] = in.readBool();
+
+        if (! readValues (in, savedCompare[slot]))
+            return false;
+    }
+
+    // A bank with more user slots than this build loses the extra ones
+    for (int i = 0; i < juce::jmin (numSaved, kNumUserPresets); ++i)
+        presets[(size_t) (numFactory + i)] = user[(size_t) i];
+
+    setCurrent (savedCurrent);
+    compareSlot = juce::jlimit (0, 1, savedSlot);
+    compare = savedCompare;
+    compareUsed = savedUsed;
+    return true;
+}
+
+//==============================================================================
+void PresetHandoff::post (const StateCodec::Values& values, std::uint32_t sequence) noexcept
+{
+    auto& buffer = buffers[(size_t) writing];
+    buffer.values = values;
+    buffer.sequence = sequence;
+
+    // Publishes the buffer and takes back whichever one was in the middle
+    writing = middle.exchange (writing | kFresh) & ~kFresh;
+}
+
+const PresetHandoff::Snapshot* PresetHandoff::take() noexcept
+{
+    if ((middle.load() & kFresh) == 0)
+        return nullptr;
+
+    reading = middle.exchange (reading) & ~kFresh;
+    return &buffers[(size_t) reading];
+}
+
+} // namespace htmltovst
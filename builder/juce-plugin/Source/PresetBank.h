@@ -0,0 +1,122 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include "StateCodec.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+//==============================================================================
+// Programs: a factory bank compiled in, kNumUserPresets user slots and an A/B compare
+// pair, every one a parameter snapshot allocated with the bank. Recalling one neither
+// builds XML nor allocates: the processor posts the snapshot to the audio thread through
+// a PresetHandoff and crossfades into it there.
+//
+// The user slots, the compare pair and the current preset are saved with the plug-in
+// state, after the parameter blob. Each snapshot is a StateCodec blob of its own, so a
+// bank saved by one spec loads into the next the way sessions do.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class PresetBank
+{
+public:
+    using Values = StateCodec::Values;
+
+    static constexpr int kNumUserPresets = 16;
+
+    /** The factory presets and kNumUserPresets slots at the defaults. */
+    PresetBank();
+
+    /** Factory presets first, then the user slots. Never changes. */
+    int getNumPresets() const noexcept                  { return (int) presets.size(); }
+    int getNumFactoryPresets() const noexcept           { return numFactory; }
+    bool isUserPreset (int index) const noexcept        { return index >= numFactory && index < getNumPresets(); }
+
+    const Values& getValues (int index) const noexcept;
+    juce::String getName (int index) const;
+
+    /** User slots only; false, with nothing changed, for any other index. */
+    bool store (int index, const Values& values, const juce::String& name);
+    bool rename (int index, const juce::String& name);
+
+    /** The preset last recalled. */
+    int getCurrent() const noexcept                     { return current; }
+    void setCurrent (int index) noexcept                { current = juce::jlimit (0, getNumPresets() - 1, index); }
+
+    /** Whether presets recall this parameter. Quality isn't one: it is how the machine runs
+        rather than how it sounds, so a show's CPU budget survives a preset change.
+    */
+    static bool isPresetParameter (int paramIndex) noexcept;
+
+    //==============================================================================
+    // A/B compare. One slot holds the live settings; selecting the other stores them
+    // there first. A slot that was never used starts as a copy of the live settings.
+    int getCompareSlot() const noexcept                 { return compareSlot; }
+
+    /** The snapshot to recall for slot, or nullptr if nothing changes. */
+    const Values* selectCompareSlot (int slot, const Values& live) noexcept;
+
+    /** Copies the live settings into the slot not selected. */
+    void copyToOtherCompareSlot (const Values& live) noexcept;
+
+    //==============================================================================
+    /** Appends the user slots, the compare pair and the current preset. */
+    void write (juce::OutputStream& out) const;
+
+    /** Restores what write() saved; false, with nothing changed, if data isn't that. */
+    bool read (const void* data, int sizeInBytes);
+
+private:
+    struct Preset
+    {
+        juce::String name;
+        Values values {};
+    };
+
+    std::vector<Preset> presets;        // sized once in the constructor
+    int numFactory = 0;
+    int current = 0;
+
+    std::array<Values, 2> compare {};
+    std::array<bool, 2> compareUsed {};
+    int compareSlot = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetBank)
+};
+
+//==============================================================================
+/** Hands whole snapshots from one writer thread to the audio thread without a lock:
+    three buffers, one being written, one held by the reader and one between them that
+    the two swap through a single atomic. The reader always gets the latest complete
+    post; older ones it never took are simply replaced.
+*/
+class PresetHandoff
+{
+public:
+    struct Snapshot
+    {
+        StateCodec::Values values {};
+        std::uint32_t sequence = 0;
+    };
+
+    /** Writer thread. */
+    void post (const StateCodec::Values& values, std::uint32_t sequence) noexcept;
+
+    /** Audio thread: the latest post if not taken yet, else nullptr. Valid until the next call. */
+    const Snapshot* take() noexcept;
+
+private:
+    static constexpr int kFresh = 4;    // set on the middle index by a post, cleared by take()
+
+    std::array<Snapshot, 3> buffers;
+    std::atomic<int> middle { 1 };
+    int writing = 0, reading = 2;
+};
+
+} // namespace htmltovst
@@ -0,0 +1,294 @@
+#include "RealtimeCheck.h"
+
+#if ! HTMLTOVST_RT_CHECK
+
+namespace htmltovst
+{
+namespace RealtimeCheck
+{
+    int getNumViolations() noexcept                 { return 0; }
+    void setAbortOnViolation (bool) noexcept        {}
+}
+} // namespace htmltovst
+
+#else
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined (__linux__) || defined (__APPLE__)
+  #include <execinfo.h>
+  #include <unistd.h>
+#endif
+
+#if defined (__linux__)
+  #include <dlfcn.h>
+  #include <fcntl.h>
+  #include <pthread.h>
+  #include <semaphore.h>
+  #include <sys/mman.h>
+  #include <sys/socket.h>
+  #include <time.h>
+#endif
+
+namespace htmltovst
+{
+namespace RealtimeCheck
+{
+
+// Constant-initialised, so safe to read from inside malloc before any static init has run
+static thread_local int realtimeDepth = 0;
+static thread_local bool reporting = false;
+
+static std::atomic<int> numViolations { 0 };
+static std::atomic<bool> abortOnViolation { false };
+
+ScopedRealtime::ScopedRealtime() noexcept   { ++realtimeDepth; }
+ScopedRealtime::~ScopedRealtime()           { --realtimeDepth; }
+
+int getNumViolations() noexcept                         { return numViolations.load(); }
+void setAbortOnViolation (bool shouldAbort) noexcept    { abortOnViolation.store (shouldAbort); }
+
+/** Called first thing by every interposer. The report itself may call interposed
+    functions (write, backtrace), so the thread is marked while it runs.
+*/
+static void check (const char* call) noexcept
+{
+    if (realtimeDepth == 0 || reporting)
+        return;
+
+    reporting = true;
+    numViolations.fetch_add (1);
+
+    // Nothing here allocates: a fixed buffer, unbuffered stderr and backtrace_symbols_fd
+    char line[128];
+    const auto length = std::snprintf (line, sizeof (line), "RT violation: %s() on a real-time thread\n", call);
+    std::fwrite (line, 1, (size_t) length, stderr);
+
+   #if defined (__linux__) || defined (__APPLE__)
+    void* frames[48];
+    const auto numFrames = backtrace (frames, 48);
+    backtrace_symbols_fd (frames + 1, numFrames - 1, STDERR_FILENO);
+   #endif
+
+    if (abortOnViolation.load())
+        std::abort();
+
+    reporting = false;
+}
+
+#if defined (__linux__) || defined (__APPLE__)
+// backtrace() loads its unwinder (and allocates) on first use: do that now, not mid-report
+[[maybe_unused]] static const bool backtraceReady = []
+{
+    void* frame = nullptr;
+    backtrace (&frame, 1);
+
+    if (const auto* mode = std::getenv ("HTMLTOVST_RT_CHECK"); mode != nullptr && std::strcmp (mode, "abort") == 0)
+        abortOnViolation.store (true);
+
+    return true;
+}();
+#endif
+
+} // namespace RealtimeCheck
+} // namespace htmltovst
+
+using htmltovst::RealtimeCheck::check;
+
+//==============================================================================
+#if defined (__linux__)
+
+// glibc's own entry points, so the allocator interposers never need dlsym (which allocates)
+extern "C" void* __libc_malloc (size_t);
+extern "C" void* __libc_calloc (size_t, size_t);
+extern "C" void* __libc_realloc (void*, size_t);
+extern "C" void* __libc_memalign (size_t, size_t);
+extern "C" void  __libc_free (void*);
+
+extern "C" void* malloc (size_t size)
+{
+    check ("malloc");
+    return __libc_malloc (size);
+}
+
+extern "C" void* calloc (size_t count, size_t size)
+{
+    check ("calloc");
+    return __libc_calloc (count, size);
+}
+
+extern "C" void* realloc (void* ptr, size_t size)
+{
+    check ("realloc");
+    return __libc_realloc (ptr, size);
+}
+
+extern "C" void free (void* ptr)
+{
+    if (ptr != nullptr)
+        check ("free");
+
+    __libc_free (ptr);
+}
+
+extern "C" int posix_memalign (void** result, size_t alignment, size_t size)
+{
+    check ("posix_memalign");
+    *result = __libc_memalign (alignment, size);
+    return *result != nullptr ? 0 : ENOMEM;
+}
+
+extern "C" void* aligned_alloc (size_t alignment, size_t size)
+{
+    check ("aligned_alloc");
+    return __libc_memalign (alignment, size);
+}
+
+extern "C" void* memalign (size_t alignment, size_t size)
+{
+    check ("memalign");
+    return __libc_memalign (alignment, size);
+}
+
+//==============================================================================
+// Everything else forwards to the next definition, looked up once before main()
+namespace
+{
+
+// Converts to whichever function pointer it initialises
+struct NextSymbol
+{
+    const char* name;
+
+    template <typename Fn>
+    operator Fn*() const noexcept   { return reinterpret_cast<Fn*> (dlsym (RTLD_NEXT, name)); }
+};
+
+struct NextFunctions
+{
+    decltype (&pthread_mutex_lock)       mutexLock       = NextSymbol { "pthread_mutex_lock" };
+    decltype (&pthread_rwlock_rdlock)    rwlockRead      = NextSymbol { "pthread_rwlock_rdlock" };
+    decltype (&pthread_rwlock_wrlock)    rwlockWrite     = NextSymbol { "pthread_rwlock_wrlock" };
+    decltype (&pthread_cond_wait)        condWait        = NextSymbol { "pthread_cond_wait" };
+    decltype (&pthread_cond_timedwait)   condTimedWait   = NextSymbol { "pthread_cond_timedwait" };
+    decltype (&pthread_join)             join            = NextSymbol { "pthread_join" };
+    decltype (&sem_wait)                 semWait         = NextSymbol { "sem_wait" };
+    decltype (&sem_timedwait)            semTimedWait    = NextSymbol { "sem_timedwait" };
+    decltype (&nanosleep)                nanoSleep       = NextSymbol { "nanosleep" };
+    decltype (&usleep)                   uSleep          = NextSymbol { "usleep" };
+    decltype (&sched_yield)              yield           = NextSymbol { "sched_yield" };
+    decltype (&read)                     readFd          = NextSymbol { "read" };
+    decltype (&write)                    writeFd         = NextSymbol { "write" };
+    decltype (&close)                    closeFd         = NextSymbol { "close" };
+    decltype (&send)                     sendFd          = NextSymbol { "send" };
+    decltype (&recv)                     recvFd          = NextSymbol { "recv" };
+    decltype (&mmap)                     mapMemory       = NextSymbol { "mmap" };
+    decltype (&munmap)                   unmapMemory     = NextSymbol { "munmap" };
+    int (*openFile) (const char*, int, ...)              = NextSymbol { "open" };
+};
+
+const NextFunctions& next() noexcept
+{
+    static const NextFunctions functions;
+    return functions;
+}
+
+// Resolved during static init, never for the first time on a checked thread
+[[maybe_unused]] const bool nextFunctionsReady = (next(), true);
+
+} // namespace
+
+extern "C" int pthread_mutex_lock (pthread_mutex_t* m)                                  { check ("pthread_mutex_lock");     return next().mutexLock (m); }
+extern "C" int pthread_rwlock_rdlock (pthread_rwlock_t* l)                              { check ("pthread_rwlock_rdlock");  return next().rwlockRead (l); }
+extern "C" int pthread_rwlock_wrlock (pthread_rwlock_t* l)                              { check ("pthread_rwlock_wrlock");  return next().rwlockWrite (l); }
+extern "C" int pthread_cond_wait (pthread_cond_t* c, pthread_mutex_t* m)                { check ("pthread_cond_wait");      return next().condWait (c, m); }
+extern "C" int pthread_cond_timedwait (pthread_cond_t* c, pthread_mutex_t* m, const timespec* t) { check ("pthread_cond_timedwait"); return next().condTimedWait (c, m, t); }
+extern "C" int pthread_join (pthread_t t, void** r)                                     { check ("pthread_join");           return next().join (t, r); }
+extern "C" int sem_wait (sem_t* s)                                                      { check ("sem_wait");               return next().semWait (s); }
+extern "C" int sem_timedwait (sem_t* s, const timespec* t)                              { check ("sem_timedwait");          return next().semTimedWait (s, t); }
+extern "C" int nanosleep (const timespec* t, timespec* r)                               { check ("nanosleep");              return next().nanoSleep (t, r); }
+extern "C" int usleep (useconds_t us)                                                   { check ("usleep");                 return next().uSleep (us); }
+extern "C" int sched_yield()                                                            { check ("sched_yield");            return next().yield(); }
+extern "C" ssize_t read (int fd, void* b, size_t n)                                     { check ("read");                   return next().readFd (fd, b, n); }
+extern "C" ssize_t write (int fd, const void* b, size_t n)                              { check ("write");                  return next().writeFd (fd, b, n); }
+extern "C" int close (int fd)                                                           { check ("close");                  return next().closeFd (fd); }
+extern "C" ssize_t send (int fd, const void* b, size_t n, int flags)                    { check ("send");                   return next().sendFd (fd, b, n, flags); }
+extern "C" ssize_t recv (int fd, void* b, size_t n, int flags)                          { check ("recv");                   return next().recvFd (fd, b, n, flags); }
+extern "C" int munmap (void* p, size_t n)                                               { check ("munmap");                 return next().unmapMemory (p, n); }
+
+extern "C" void* mmap (void* p, size_t n, int prot, int flags, int fd, off_t offset)
+{
+    check ("mmap");
+    return next().mapMemory (p, n, prot, flags, fd, offset);
+}
+
+extern "C" int open (const char* path, int flags, ...)
+{
+    check ("open");
+
+    // The mode argument is only there when a file may be created
+    mode_t mode = 0;
+
+    if ((flags & (O_CREAT | O_TMPFILE)) != 0)
+    {
+        va_list args;
+        va_start (args, flags);
+        mode = (mode_t) va_arg (args, int);
+        va_end (args);
+    }
+
+    return next().openFile (path, flags, mode);
+}
+
+#else
+
+//==============================================================================
+// No libc interposition here: check the C++ allocation paths instead
+void* operator new (std::size_t size)
+{
+    check ("operator new");
+
+    if (auto* p = std::malloc (size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    check ("operator new[]");
+
+    if (auto* p = std::malloc (size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr)
+        check ("operator delete");
+
+    std::free (p);
+}
+
+void operator delete[] (void* p) noexcept
+{
+    if (p != nullptr)
+        check ("operator delete[]");
+
+    std::free (p);
+}
+
+void operator delete (void* p, std::size_t) noexcept      { operator delete (p); }
+void operator delete[] (void* p, std::size_t) noexcept    { operator delete[] (p); }
+
+#endif
+
+#endif // HTMLTOVST_RT_CHECK
@@ -0,0 +1,51 @@
+#pragma once
+
+//==============================================================================
+// Real-time safety checker for the audio thread.
+//
+// Builds with HTMLTOVST_RT_CHECK=1 (the HtmlToVstRtCheck headless target) link in
+// interposers for the calls an audio callback must never make: the malloc family
+// (and with it operator new / delete), mutex, rwlock, condition variable and
+// semaphore waits, sleeps, and file / socket I/O and mmap. A call made while the
+// thread is inside a ScopedRealtime is reported on stderr with a stack trace, or
+// aborts if setAbortOnViolation (true) (or HTMLTOVST_RT_CHECK=abort in the environment).
+//
+// The libc interposers need glibc (Linux); elsewhere only operator new / delete are
+// checked. In every other build ScopedRealtime is an empty object and nothing is linked.
+//==============================================================================
+
+namespace htmltovst
+{
+namespace RealtimeCheck
+{
+    /** True if this build intercepts anything. */
+    constexpr bool isEnabled() noexcept
+    {
+       #if HTMLTOVST_RT_CHECK
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+    /** Marks the calling thread as real-time until destroyed; scopes nest. */
+    class ScopedRealtime
+    {
+    public:
+       #if HTMLTOVST_RT_CHECK
+        ScopedRealtime() noexcept;
+        ~ScopedRealtime();
+       #else
+        ScopedRealtime() noexcept {}
+       #endif
+
+        ScopedRealtime (const ScopedRealtime&) = delete;
+        ScopedRealtime& operator= (const ScopedRealtime&) = delete;
+    };
+
+    /** Violations reported so far, on any thread; always 0 when disabled. */
+    int getNumViolations() noexcept;
+
+    void setAbortOnViolation (bool shouldAbort) noexcept;
+}
+} // namespace htmltovst
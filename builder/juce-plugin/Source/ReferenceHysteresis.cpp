@@ -0,0 +1,212 @@
+#include "ReferenceHysteresis.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <cmath>
+
+namespace htmltovst
+{
+
+//==============================================================================
+namespace
+{
+
+struct Langevin
+{
+    double L, dL, d2L;
+};
+
+/** L(q) = coth(q) - 1/q and its first two derivatives; a Taylor series near 0, where
+    the closed forms cancel (truncation error < 1e-13 below |q| = 0.1).
+*/
+static Langevin langevin (double q) noexcept
+{
+    if (std::abs (q) < 0.1)
+    {
+        const auto q2 = q * q;
+        return { q * (1.0 / 3.0 - q2 * (1.0 / 45.0 - q2 * (2.0 / 945.0 - q2 / 4725.0))),
+                 1.0 / 3.0 - q2 * (1.0 / 15.0 - q2 * (2.0 / 189.0 - q2 / 675.0)),
+                 q * (q2 * (8.0 / 189.0 - q2 * 6.0 / 675.0) - 2.0 / 15.0) };
+    }
+
+    const auto coth  = 1.0 / std::tanh (q);
+    const auto inv   = 1.0 / q;
+    const auto csch2 = coth * coth - 1.0;
+    return { coth - inv, inv * inv - csch2, 2.0 * (coth * csch2 - inv * inv * inv) };
+}
+
+/** Jiles-Atherton dm/dt, as in TapeHysteresis; optionally d(dm/dt)/dm for Newton. */
+static double dmdt (const TapeHysteresis::Coeffs& k, double m, double h, double hd, double* dfdm = nullptr) noexcept
+{
+    const auto kappa = (double) k.kappa, c = (double) k.c, alpha = (double) k.alpha;
+
+    m = juce::jlimit (-1.0, 1.0, m);
+
+    const auto lan = langevin (h + alpha * m);
+    const auto x   = lan.L - m;
+
+    const auto delta  = hd >= 0.0 ? 1.0 : -1.0;
+    const auto deltaM = delta * x > 0.0 ? 1.0 : 0.0;
+
+    const auto d1 = (1.0 - c) * delta * kappa - alpha * x;
+    const auto t1 = (1.0 - c) * deltaM * x / d1 * hd;
+    const auto t2 = c * lan.dL * hd;
+    const auto d  = 1.0 - c * alpha * lan.dL;
+    const auto f  = (t1 + t2) / d;
+
+    if (dfdm != nullptr)
+    {
+        const auto dx  = alpha * lan.dL - 1.0;
+        const auto dt1 = (1.0 - c) * deltaM * hd * dx * ((1.0 - c) * delta * kappa) / (d1 * d1);
+        const auto dt2 = c * hd * lan.d2L * alpha;
+        const auto dd  = -c * alpha * alpha * lan.d2L;
+        *dfdm = ((dt1 + dt2) * d - (t1 + t2) * dd) / (d * d);
+    }
+
+    return f;
+}
+
+} // namespace
+
+//==============================================================================
+void ReferenceHysteresis::prepare (std::shared_ptr<const TapeHysteresis::CalibrationTable> table)
+{
+    calibration = std::move (table);
+    hasTarget = false;
+    reset();
+}
+
+void ReferenceHysteresis::reset() noexcept
+{
+    for (auto& s : state)
+        s = ChannelState();
+
+    if (hasTarget)
+        current = target;
+}
+
+void ReferenceHysteresis::setSettings (const Settings& newSettings) noexcept
+{
+    derivativeStale = derivativeStale || newSettings.solver != settings.solver;
+    settings = newSettings;
+    settings.tapeType = juce::jlimit (0, TapeHysteresis::kNumTapeTypes - 1, settings.tapeType);
+
+    target = TapeHysteresis::getCoeffs (settings, calibration.get());
+
+    if (! hasTarget)
+    {
+        current = target;
+        hasTarget = true;
+    }
+}
+
+float ReferenceHysteresis::getSmallSignalGain() const noexcept
+{
+    const auto slope = TapeHysteresis::getCalibrationSlope (calibration.get(), settings.tapeType, settings.bias);
+    return juce::jmax (current.hGain * current.outGain, target.hGain * target.outGain) * slope;
+}
+
+//==============================================================================
+template <TapeHysteresis::Solver solver, typename SampleType>
+void ReferenceHysteresis::processChannel (SampleType* samples, int numSamples, double T, double highPassCoeff, ChannelState& s) const noexcept
+{
+    constexpr auto diffAlpha = (double) TapeHysteresis::kDiffAlpha;
+
+    const auto hGainStep   = ((double) target.hGain   - (double) current.hGain)   / (double) juce::jmax (1, numSamples);
+    const auto outGainStep = ((double) target.outGain - (double) current.outGain) / (double) juce::jmax (1, numSamples);
+
+    if constexpr (solver == Solver::newton4 || solver == Solver::newton8)
+        if (derivativeStale)
+            s.f = dmdt (target, s.m, s.h, s.hd);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto hGain   = (double) current.hGain   + hGainStep   * (double) (i + 1);
+        const auto outGain = (double) current.outGain + outGainStep * (double) (i + 1);
+
+        const auto h  = (double) samples[i] * hGain;
+        const auto hd = (1.0 + diffAlpha) / T * (h - s.h) - diffAlpha * s.hd;
+        auto m = s.m;
+
+        if constexpr (solver == Solver::rk2)
+        {
+            const auto k1 = T * dmdt (target, m, s.h, s.hd);
+            const auto k2 = T * dmdt (target, m + 0.5 * k1, 0.5 * (h + s.h), 0.5 * (hd + s.hd));
+            m += k2;
+        }
+        else if constexpr (solver == Solver::rk4)
+        {
+            const auto hm  = 0.5 * (h + s.h);
+            const auto hdm = 0.5 * (hd + s.hd);
+            const auto k1 = T * dmdt (target, m, s.h, s.hd);
+            const auto k2 = T * dmdt (target, m + 0.5 * k1, hm, hdm);
+            const auto k3 = T * dmdt (target, m + 0.5 * k2, hm, hdm);
+            const auto k4 = T * dmdt (target, m + k3, h, hd);
+            m += (k1 + 2.0 * (k2 + k3) + k4) / 6.0;
+        }
+        else
+        {
+            constexpr int iterations = solver == Solver::newton4 ? 4 : 8;
+            const auto m0 = m;
+            m = m0 + T * s.f;
+
+            for (int it = 0; it < iterations; ++it)
+            {
+                double dfdm = 0.0;
+                const auto fv = dmdt (target, m, h, hd, &dfdm);
+                m -= (m - m0 - 0.5 * T * (fv + s.f)) / (1.0 - 0.5 * T * dfdm);
+            }
+
+            s.f = dmdt (target, m, h, hd);
+        }
+
+        m = juce::jlimit (-1.0, 1.0, m);
+
+        s.m = m;
+        s.h = h;
+        s.hd = hd;
+
+        const auto y = m - s.dcIn + highPassCoeff * s.dcOut;
+        s.dcIn  = m;
+        s.dcOut = y;
+
+        samples[i] = (SampleType) (y * outGain);
+    }
+
+    // A blow-up (e.g. a NaN from the host) must not latch: start the channel from rest.
+    if (! (std::isfinite (s.m) && std::isfinite (s.hd) && std::isfinite (s.f) && std::isfinite (s.dcOut)))
+    {
+        s = ChannelState();
+        juce::FloatVectorOperations::clear (samples, numSamples);
+    }
+}
+
+template <typename SampleType>
+void ReferenceHysteresis::process (SampleType* const* channels, int numChannels, int numSamples, double sampleRate) noexcept
+{
+    jassert (numChannels <= TapeHysteresis::kMaxChannels);
+
+    const auto T = 1.0 / sampleRate;
+    const auto highPassCoeff = std::exp (-juce::MathConstants<double>::twoPi * TapeHysteresis::kReproHighPassHz / sampleRate);
+
+    for (int ch = 0; ch < juce::jmin (numChannels, TapeHysteresis::kMaxChannels); ++ch)
+    {
+        auto& s = state[(size_t) ch];
+
+        switch (settings.solver)
+        {
+            case Solver::rk2:     processChannel<Solver::rk2>     (channels[ch], numSamples, T, highPassCoeff, s); break;
+            case Solver::rk4:     processChannel<Solver::rk4>     (channels[ch], numSamples, T, highPassCoeff, s); break;
+            case Solver::newton4: processChannel<Solver::newton4> (channels[ch], numSamples, T, highPassCoeff, s); break;
+            case Solver::newton8: processChannel<Solver::newton8> (channels[ch], numSamples, T, highPassCoeff, s); break;
+        }
+    }
+
+    current = target;
+    derivativeStale = false;
+}
+
+template void ReferenceHysteresis::process (float* const*, int, int, double) noexcept;
+template void ReferenceHysteresis::process (double* const*, int, int, double) noexcept;
+
+} // namespace htmltovst
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "TapeHysteresis.h"
+
+//==============================================================================
+// The tape engine's hysteresis written the plain way, for DspPath::reference: one
+// channel at a time, in double precision, with std::tanh for the Langevin function.
+//
+// Same model, settings, solvers and calibration as TapeHysteresis, so the fused
+// path can be null-tested against it; only the arithmetic differs.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class ReferenceHysteresis
+{
+public:
+    using Settings = TapeHysteresis::Settings;
+    using Solver   = TapeHysteresis::Solver;
+
+    /** Takes the same calibration table as TapeHysteresis::prepare(). */
+    void prepare (std::shared_ptr<const TapeHysteresis::CalibrationTable> table);
+    void reset() noexcept;
+
+    /** Block-rate update; gains glide to the new values over the next block. */
+    void setSettings (const Settings& newSettings) noexcept;
+
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples, double sampleRate) noexcept;
+
+    /** Low-level gain from input to output with the current settings. */
+    float getSmallSignalGain() const noexcept;
+
+private:
+    struct ChannelState
+    {
+        double m = 0.0, h = 0.0, hd = 0.0, f = 0.0;
+        double dcIn = 0.0, dcOut = 0.0;
+    };
+
+    template <Solver solver, typename SampleType>
+    void processChannel (SampleType* samples, int numSamples, double T, double highPassCoeff, ChannelState& s) const noexcept;
+
+    Settings settings;
+    TapeHysteresis::Coeffs current, target;
+    bool hasTarget = false;
+    bool derivativeStale = false;     // as in TapeHysteresis
+
+    std::array<ChannelState, TapeHysteresis::kMaxChannels> state;
+    std::shared_ptr<const TapeHysteresis::CalibrationTable> calibration;
+};
+
+} // namespace htmltovst
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+//==============================================================================
+// Process-wide cache of tables that depend only on constants and the sample rate
+// (model calibration, filter measurements), so that hundreds of instances build
+// each one once instead of once apiece.
+//
+// Shared through juce::SharedResourcePointer: created by the first instance, freed
+// with the last. Each table is built by whichever instance asks first, then
+// published as a shared_ptr<const T> and never modified, so holders read it without
+// locking. The map lock is only held to find a key's entry; the build itself runs
+// under that entry's own once-flag, so a slow table doesn't hold up other keys.
+// get() may build; call it from prepareToPlay, never the audio thread.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class SharedTables
+{
+public:
+    /** The table stored under key, calling build() to make it if nobody has yet.
+        Concurrent callers for the same key wait for the first build and share it;
+        if build() throws, the next caller tries again.
+    */
+    template <typename Table, typename BuildFn>
+    std::shared_ptr<const Table> get (const juce::String& key, BuildFn&& build)
+    {
+        const auto entry = getEntry (key);
+
+        std::call_once (entry->built, [&] { entry->table = std::make_shared<const Table> (build()); });
+
+        return std::static_pointer_cast<const Table> (entry->table);
+    }
+
+    /** Number of keys asked for so far, built or being built. */
+    int size() const
+    {
+        const std::lock_guard<std::mutex> sl (lock);
+        return (int) tables.size();
+    }
+
+private:
+    struct Entry
+    {
+        std::once_flag built;
+        std::shared_ptr<const void> table;
+    };
+
+    std::shared_ptr<Entry> getEntry (const juce::String& key)
+    {
+        const std::lock_guard<std::mutex> sl (lock);
+
+        auto& entry = tables[key];
+
+        if (entry == nullptr)
+            entry = std::make_shared<Entry>();
+
+        return entry;
+    }
+
+    mutable std::mutex lock;
+    std::map<juce::String, std::shared_ptr<Entry>> tables;
+};
+
+} // namespace htmltovst
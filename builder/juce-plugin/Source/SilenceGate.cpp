@@ -0,0 +1,103 @@
+#include "SilenceGate.h"
+#include "SimdLanes.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <limits>
+
+namespace htmltovst
+{
+
+//==============================================================================
+// Checked in 64-sample chunks so a loud block bails out after the first chunk,
+// which keeps the detector's cost on active tracks negligible.
+static constexpr int kChunkSize = 64;
+
+static bool isChannelSilent (const float* x, int numSamples, float threshold) noexcept
+{
+    const auto t = Float4::broadcast (threshold);
+    int i = 0;
+
+    while (i + Float4::size <= numSamples)
+    {
+        const auto end = juce::jmin (i + kChunkSize, numSamples - numSamples % Float4::size);
+        auto peak = Float4::broadcast (0.0f);
+
+        for (; i < end; i += Float4::size)
+            peak = Float4::max (peak, Float4::abs (Float4::load (x + i)));
+
+        if (Float4::any (Float4::lessThan (t, peak)))
+            return false;
+    }
+
+    for (; i < numSamples; ++i)
+        if (std::abs (x[i]) > threshold)
+            return false;
+
+    return true;
+}
+
+// Float4 is float-only; doubles go through JUCE's vectorised min/max, chunk by chunk.
+static bool isChannelSilent (const double* x, int numSamples, float threshold) noexcept
+{
+    for (int i = 0; i < numSamples; i += kChunkSize)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax (x + i, juce::jmin (kChunkSize, numSamples - i));
+
+        if (juce::jmax (-range.getStart(), range.getEnd()) > (double) threshold)
+            return false;
+    }
+
+    return true;
+}
+
+template <typename SampleType>
+static bool isSilentImpl (const SampleType* const* channels, int numChannels, int numSamples, float threshold) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        if (! isChannelSilent (channels[ch], numSamples, threshold))
+            return false;
+
+    return true;
+}
+
+bool isSilent (const float* const* channels, int numChannels, int numSamples, float threshold) noexcept
+{
+    return isSilentImpl (channels, numChannels, numSamples, threshold);
+}
+
+bool isSilent (const double* const* channels, int numChannels, int numSamples, float threshold) noexcept
+{
+    return isSilentImpl (channels, numChannels, numSamples, threshold);
+}
+
+//==============================================================================
+bool SilenceGate::update (const float* const* channels, int numChannels, int numSamples, float threshold) noexcept
+{
+    return advance (isSilent (channels, numChannels, numSamples, threshold), numSamples);
+}
+
+bool SilenceGate::update (const double* const* channels, int numChannels, int numSamples, float threshold) noexcept
+{
+    return advance (isSilent (channels, numChannels, numSamples, threshold), numSamples);
+}
+
+bool SilenceGate::advance (bool blockIsSilent, int numSamples) noexcept
+{
+    if (! blockIsSilent)
+    {
+        silentSamples = 0;
+        return false;
+    }
+
+    // Skip only if the tail of the last audible sample had already run out before this block.
+    const auto skip = silentSamples >= tailSamples;
+    silentSamples = juce::jmin (silentSamples + numSamples, std::numeric_limits<int>::max() / 2);
+
+    if (skip)
+        skippedBlocks.fetch_add (1, std::memory_order_relaxed);
+
+    return skip;
+}
+
+} // namespace htmltovst
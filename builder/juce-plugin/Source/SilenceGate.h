@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+//==============================================================================
+// Block-level silence detection for automatic processing bypass.
+//
+// A block is skipped only once the input has stayed below the threshold for
+// longer than the engine's tail, so everything the DSP could still emit has
+// already been rendered. The gate only decides; the caller keeps its smoothers
+// advancing while skipped so processing resumes from the right state.
+//==============================================================================
+
+namespace htmltovst
+{
+
+/** True if every sample of every channel satisfies |x| <= threshold (SIMD, early-out). */
+bool isSilent (const float* const* channels, int numChannels, int numSamples, float threshold) noexcept;
+bool isSilent (const double* const* channels, int numChannels, int numSamples, float threshold) noexcept;
+
+class SilenceGate
+{
+public:
+    /** About -110 dBFS, referred to the output. */
+    static constexpr float kDefaultThreshold = 3.0e-6f;
+
+    /** How long, in samples, the engine keeps producing output after its input stops. */
+    void setTailSamples (int newTailSamples) noexcept   { tailSamples = newTailSamples; }
+    int getTailSamples() const noexcept                 { return tailSamples; }
+
+    /** Forget any silence seen so far; the next block is processed. */
+    void reset() noexcept                               { silentSamples = 0; }
+
+    /** Feeds one input block. Returns true if it may be skipped. */
+    bool update (const float* const* channels, int numChannels, int numSamples, float threshold) noexcept;
+    bool update (const double* const* channels, int numChannels, int numSamples, float threshold) noexcept;
+
+    /** Total skipped blocks since construction (readable from any thread). */
+    std::uint64_t getNumSkippedBlocks() const noexcept  { return skippedBlocks.load (std::memory_order_relaxed); }
+
+private:
+    bool advance (bool blockIsSilent, int numSamples) noexcept;
+
+    int tailSamples = 0;
+    int silentSamples = 0;
+    std::atomic<std::uint64_t> skippedBlocks { 0 };
+};
+
+} // namespace htmltovst
@@ -0,0 +1,294 @@
+#pragma once
+
+//==============================================================================
+// Minimal 4-lane float vector used by the channel-parallel DSP (one channel per
+// lane; transpose() interleaves four channels' samples into lanes and back, and
+// processLanes() wraps that around a per-sample step). SSE2 on x86-64, NEON on arm64,
+// plain arrays elsewhere. Header-only so everything inlines into the per-sample loops.
+//==============================================================================
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined (__x86_64__) || defined (_M_X64)
+  #include <immintrin.h>
+  #define HTMLTOVST_X86_SIMD 1
+#else
+  #define HTMLTOVST_X86_SIMD 0
+#endif
+
+#if defined (__aarch64__) || defined (_M_ARM64)
+  #include <arm_neon.h>
+  #define HTMLTOVST_NEON_SIMD 1
+#else
+  #define HTMLTOVST_NEON_SIMD 0
+#endif
+
+namespace htmltovst
+{
+
+struct Float4
+{
+    static constexpr int size = 4;
+
+   #if HTMLTOVST_X86_SIMD
+    __m128 v;
+
+    static Float4 broadcast (float x) noexcept                  { return { _mm_set1_ps (x) }; }
+    static Float4 load (const float* p) noexcept                { return { _mm_loadu_ps (p) }; }
+    void store (float* p) const noexcept                        { _mm_storeu_ps (p, v); }
+
+    friend Float4 operator+ (Float4 a, Float4 b) noexcept       { return { _mm_add_ps (a.v, b.v) }; }
+    friend Float4 operator- (Float4 a, Float4 b) noexcept       { return { _mm_sub_ps (a.v, b.v) }; }
+    friend Float4 operator* (Float4 a, Float4 b) noexcept       { return { _mm_mul_ps (a.v, b.v) }; }
+    friend Float4 operator/ (Float4 a, Float4 b) noexcept       { return { _mm_div_ps (a.v, b.v) }; }
+
+    static Float4 min (Float4 a, Float4 b) noexcept             { return { _mm_min_ps (a.v, b.v) }; }
+    static Float4 max (Float4 a, Float4 b) noexcept             { return { _mm_max_ps (a.v, b.v) }; }
+    static Float4 abs (Float4 a) noexcept                       { return { _mm_andnot_ps (_mm_set1_ps (-0.0f), a.v) }; }
+
+    /** Lane masks are all-ones / all-zeros bit patterns. */
+    static Float4 lessThan (Float4 a, Float4 b) noexcept        { return { _mm_cmplt_ps (a.v, b.v) }; }
+    static Float4 select (Float4 mask, Float4 a, Float4 b) noexcept
+    {
+        return { _mm_or_ps (_mm_and_ps (mask.v, a.v), _mm_andnot_ps (mask.v, b.v)) };
+    }
+
+    static bool any (Float4 mask) noexcept                      { return _mm_movemask_ps (mask.v) != 0; }
+
+    /** 4x4 transpose: four channels x four samples <-> four samples x four channels. */
+    static void transpose (Float4& a, Float4& b, Float4& c, Float4& d) noexcept
+    {
+        _MM_TRANSPOSE4_PS (a.v, b.v, c.v, d.v);
+    }
+
+    /** Round to nearest integer (as float). */
+    static Float4 round (Float4 a) noexcept                     { return { _mm_cvtepi32_ps (_mm_cvtps_epi32 (a.v)) }; }
+
+    /** 2^n for integral-valued n in [-126, 127]. */
+    static Float4 exp2i (Float4 n) noexcept
+    {
+        const auto e = _mm_add_epi32 (_mm_cvtps_epi32 (n.v), _mm_set1_epi32 (127));
+        return { _mm_castsi128_ps (_mm_slli_epi32 (e, 23)) };
+    }
+
+   #elif HTMLTOVST_NEON_SIMD
+    float32x4_t v;
+
+    static Float4 broadcast (float x) noexcept                  { return { vdupq_n_f32 (x) }; }
+    static Float4 load (const float* p) noexcept                { return { vld1q_f32 (p) }; }
+    void store (float* p) const noexcept                        { vst1q_f32 (p, v); }
+
+    friend Float4 operator+ (Float4 a, Float4 b) noexcept       { return { vaddq_f32 (a.v, b.v) }; }
+    friend Float4 operator- (Float4 a, Float4 b) noexcept       { return { vsubq_f32 (a.v, b.v) }; }
+    friend Float4 operator* (Float4 a, Float4 b) noexcept       { return { vmulq_f32 (a.v, b.v) }; }
+    friend Float4 operator/ (Float4 a, Float4 b) noexcept       { return { vdivq_f32 (a.v, b.v) }; }
+
+    static Float4 min (Float4 a, Float4 b) noexcept             { return { vminq_f32 (a.v, b.v) }; }
+    static Float4 max (Float4 a, Float4 b) noexcept             { return { vmaxq_f32 (a.v, b.v) }; }
+    static Float4 abs (Float4 a) noexcept                       { return { vabsq_f32 (a.v) }; }
+
+    static Float4 lessThan (Float4 a, Float4 b) noexcept        { return { vreinterpretq_f32_u32 (vcltq_f32 (a.v, b.v)) }; }
+    static Float4 select (Float4 mask, Float4 a, Float4 b) noexcept
+    {
+        return { vbslq_f32 (vreinterpretq_u32_f32 (mask.v), a.v, b.v) };
+    }
+
+    static bool any (Float4 mask) noexcept                      { return vmaxvq_u32 (vreinterpretq_u32_f32 (mask.v)) != 0; }
+
+    static void transpose (Float4& a, Float4& b, Float4& c, Float4& d) noexcept
+    {
+        const auto ab = vtrnq_f32 (a.v, b.v);   // { a0 b0 a2 b2 }, { a1 b1 a3 b3 }
+        const auto cd = vtrnq_f32 (c.v, d.v);
+        a.v = vcombine_f32 (vget_low_f32  (ab.val[0]), vget_low_f32  (cd.val[0]));
+        b.v = vcombine_f32 (vget_low_f32  (ab.val[1]), vget_low_f32  (cd.val[1]));
+        c.v = vcombine_f32 (vget_high_f32 (ab.val[0]), vget_high_f32 (cd.val[0]));
+        d.v = vcombine_f32 (vget_high_f32 (ab.val[1]), vget_high_f32 (cd.val[1]));
+    }
+
+    static Float4 round (Float4 a) noexcept                     { return { vrndnq_f32 (a.v) }; }
+
+    static Float4 exp2i (Float4 n) noexcept
+    {
+        const auto e = vaddq_s32 (vcvtnq_s32_f32 (n.v), vdupq_n_s32 (127));
+        return { vreinterpretq_f32_s32 (vshlq_n_s32 (e, 23)) };
+    }
+
+   #else
+    float v[4];
+
+    static Float4 broadcast (float x) noexcept                  { return { { x, x, x, x } }; }
+    static Float4 load (const float* p) noexcept                { return { { p[0], p[1], p[2], p[3] } }; }
+    void store (float* p) const noexcept                        { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+
+    template <typename Op>
+    static Float4 map (Float4 a, Float4 b, Op op) noexcept
+    {
+        Float4 r;
+        for (int i = 0; i < 4; ++i)
+            r.v[i] = op (a.v[i], b.v[i]);
+        return r;
+    }
+
+    friend Float4 operator+ (Float4 a, Float4 b) noexcept       { return map (a, b, [] (float x, float y) { return x + y; }); }
+    friend Float4 operator- (Float4 a, Float4 b) noexcept       { return map (a, b, [] (float x, float y) { return x - y; }); }
+    friend Float4 operator* (Float4 a, Float4 b) noexcept       { return map (a, b, [] (float x, float y) { return x * y; }); }
+    friend Float4 operator/ (Float4 a, Float4 b) noexcept       { return map (a, b, [] (float x, float y) { return x / y; }); }
+
+    static Float4 min (Float4 a, Float4 b) noexcept             { return map (a, b, [] (float x, float y) { return y < x ? y : x; }); }
+    static Float4 max (Float4 a, Float4 b) noexcept             { return map (a, b, [] (float x, float y) { return x < y ? y : x; }); }
+    static Float4 abs (Float4 a) noexcept                       { return map (a, a, [] (float x, float) { return std::abs (x); }); }
+
+    static float maskBits (bool b) noexcept
+    {
+        const std::uint32_t bits = b ? 0xffffffffu : 0u;
+        float f;
+        std::memcpy (&f, &bits, sizeof (f));
+        return f;
+    }
+
+    static bool isSet (float mask) noexcept
+    {
+        std::uint32_t bits;
+        std::memcpy (&bits, &mask, sizeof (bits));
+        return bits != 0;
+    }
+
+    static Float4 lessThan (Float4 a, Float4 b) noexcept        { return map (a, b, [] (float x, float y) { return maskBits (x < y); }); }
+    static Float4 select (Float4 mask, Float4 a, Float4 b) noexcept
+    {
+        Float4 r;
+        for (int i = 0; i < 4; ++i)
+            r.v[i] = isSet (mask.v[i]) ? a.v[i] : b.v[i];
+        return r;
+    }
+
+    static bool any (Float4 mask) noexcept
+    {
+        return isSet (mask.v[0]) || isSet (mask.v[1]) || isSet (mask.v[2]) || isSet (mask.v[3]);
+    }
+
+    static void transpose (Float4& a, Float4& b, Float4& c, Float4& d) noexcept
+    {
+        Float4* rows[4] = { &a, &b, &c, &d };
+
+        for (int r = 0; r < 4; ++r)
+            for (int k = r + 1; k < 4; ++k)
+                std::swap (rows[r]->v[k], rows[k]->v[r]);
+    }
+
+    static Float4 round (Float4 a) noexcept                     { return map (a, a, [] (float x, float) { return std::nearbyint (x); }); }
+    static Float4 exp2i (Float4 n) noexcept                     { return map (n, n, [] (float x, float) { return std::ldexp (1.0f, (int) x); }); }
+   #endif
+
+    //==============================================================================
+    // Shared helpers built on the primitives above
+
+    static Float4 clamp (Float4 x, float lo, float hi) noexcept  { return min (max (x, broadcast (lo)), broadcast (hi)); }
+
+    /** False if any lane is NaN or infinite. */
+    static bool isFinite (Float4 x) noexcept
+    {
+        float lanes[size];
+        x.store (lanes);
+
+        for (auto f : lanes)
+            if (! std::isfinite (f))
+                return false;
+
+        return true;
+    }
+
+    /** +1 where x >= 0, -1 elsewhere. */
+    static Float4 sign (Float4 x) noexcept
+    {
+        return select (lessThan (x, broadcast (0.0f)), broadcast (-1.0f), broadcast (1.0f));
+    }
+
+    /** e^x, ~2 ulp over [-87, 87] (Cody-Waite reduction + degree-6 polynomial). */
+    static Float4 exp (Float4 x) noexcept
+    {
+        x = clamp (x, -87.0f, 87.0f);
+
+        const auto n = round (x * broadcast (1.44269504088896341f));
+        const auto r = x - n * broadcast (0.693359375f) + n * broadcast (2.12194440e-4f);
+
+        auto p = broadcast (1.9875691500e-4f);
+        p = p * r + broadcast (1.3981999507e-3f);
+        p = p * r + broadcast (8.3334519073e-3f);
+        p = p * r + broadcast (4.1665795894e-2f);
+        p = p * r + broadcast (1.6666665459e-1f);
+        p = p * r + broadcast (5.0000001201e-1f);
+        p = p * r * r + r + broadcast (1.0f);
+
+        return p * exp2i (n);
+    }
+};
+
+//==============================================================================
+// Four consecutive samples of one channel. The lanes are float: double buffers are
+// narrowed on load and widened on store.
+inline Float4 loadLane (const float* p) noexcept    { return Float4::load (p); }
+inline void storeLane (Float4 v, float* p) noexcept { v.store (p); }
+
+inline Float4 loadLane (const double* p) noexcept
+{
+    const float f[Float4::size] = { (float) p[0], (float) p[1], (float) p[2], (float) p[3] };
+    return Float4::load (f);
+}
+
+inline void storeLane (Float4 v, double* p) noexcept
+{
+    float f[Float4::size];
+    v.store (f);
+
+    for (int i = 0; i < Float4::size; ++i)
+        p[i] = (double) f[i];
+}
+
+/** Runs up to four channels through step (x, i) in place, where x holds sample i of
+    every channel (one per lane, zeros past numLanes) and step returns the outputs.
+    Four samples at a time are loaded from each channel and transposed, so that each
+    register holds one sample of every channel, then transposed back on the way out.
+*/
+template <typename SampleType, typename StepFn>
+inline void processLanes (SampleType* const* channels, int numLanes, int numSamples, StepFn&& step) noexcept
+{
+    int i = 0;
+
+    for (; i + Float4::size <= numSamples; i += Float4::size)
+    {
+        Float4 rows[Float4::size];
+
+        for (int l = 0; l < Float4::size; ++l)
+            rows[l] = l < numLanes ? loadLane (channels[l] + i) : Float4::broadcast (0.0f);
+
+        Float4::transpose (rows[0], rows[1], rows[2], rows[3]);
+
+        for (int j = 0; j < Float4::size; ++j)
+            rows[j] = step (rows[j], i + j);
+
+        Float4::transpose (rows[0], rows[1], rows[2], rows[3]);
+
+        for (int l = 0; l < numLanes; ++l)
+            storeLane (rows[l], channels[l] + i);
+    }
+
+    // The last few samples one at a time
+    float lanes[Float4::size] = {};
+
+    for (; i < numSamples; ++i)
+    {
+        for (int l = 0; l < numLanes; ++l)
+            lanes[l] = (float) channels[l][i];
+
+        step (Float4::load (lanes), i).store (lanes);
+
+        for (int l = 0; l < numLanes; ++l)
+            channels[l][i] = (SampleType) lanes[l];
+    }
+}
+
+} // namespace htmltovst
@@ -0,0 +1,299 @@
+#include "StateCodec.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace htmltovst
+{
+namespace StateCodec
+{
+
+static constexpr std::uint32_t kMagic = 0x53565448;    // "HTVS" read as little-endian
+static constexpr int kHeaderSize = 16;
+static constexpr int kEntrySize = 12;
+static constexpr int kEntrySizeV1 = 8;      // before entries carried a label hash
+
+//==============================================================================
+// FNV-1a over the ID. A clash between two IDs fails the static_assert below.
+static constexpr std::uint32_t hashId (const char* id) noexcept
+{
+    std::uint32_t h = 2166136261u;
+
+    for (; *id != 0; ++id)
+        h = (h ^ (std::uint8_t) *id) * 16777619u;
+
+    return h;
+}
+
+// Every ID in order: equal hashes mean a blob's entries line up with kHtmlToVstParams
+static constexpr std::uint32_t hashSpec() noexcept
+{
+    std::uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+        h = (h ^ hashId (kHtmlToVstParams[i].id)) * 16777619u;
+
+    return h;
+}
+
+static constexpr size_t getTableSize() noexcept
+{
+    size_t n = 1;
+
+    while (n < 2 * kNumHtmlToVstParams)
+        n <<= 1;
+
+    return n;
+}
+
+struct IdTable
+{
+    static constexpr size_t size = getTableSize();
+
+    std::array<std::uint32_t, size> hashes {};
+    std::array<int, size> indices {};
+    bool unique = true;
+
+    constexpr int find (std::uint32_t hash) const noexcept
+    {
+        for (auto slot = hash & (size - 1);; slot = (slot + 1) & (size - 1))
+        {
+            if (indices[slot] < 0 || hashes[slot] == hash)
+                return indices[slot];
+        }
+    }
+};
+
+// Open addressing with linear probing, at most half full
+static constexpr IdTable makeIdTable() noexcept
+{
+    IdTable t {};
+
+    for (size_t slot = 0; slot < IdTable::size; ++slot)
+        t.indices[slot] = -1;
+
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+    {
+        const auto hash = hashId (kHtmlToVstParams[i].id);
+        auto slot = hash & (IdTable::size - 1);
+
+        for (; t.indices[slot] >= 0; slot = (slot + 1) & (IdTable::size - 1))
+            t.unique = t.unique && t.hashes[slot] != hash;
+
+        t.hashes[slot] = hash;
+        t.indices[slot] = (int) i;
+    }
+
+    return t;
+}
+
+static constexpr std::uint32_t kSpecHash = hashSpec();
+static constexpr IdTable kIdTable = makeIdTable();
+
+static_assert (kIdTable.unique, "Two parameter IDs share a hash; rename one");
+static_assert (kNumHtmlToVstParams <= 0xffff, "numEntries is 16 bits");
+
+//==============================================================================
+// Choices travel as the option's value, so a numeric choice (1x, 2x, 4x...) survives its
+// option list changing; other parameters are stored as-is.
+static float toStored (const HtmlToVstParamSpec& p, float value) noexcept
+{
+    if (p.type != HtmlToVstParamType::choice || p.optionValues == nullptr)
+        return value;
+
+    return (float) p.optionValues[juce::jlimit (0, p.numOptions - 1, juce::roundToInt (value))];
+}
+
+static float fromStored (const HtmlToVstParamSpec& p, float stored) noexcept
+{
+    if (p.type != HtmlToVstParamType::choice || p.optionValues == nullptr)
+        return juce::jlimit ((float) p.minValue, (float) p.maxValue, stored);
+
+    // Nearest option, so a value dropped from the list falls on its neighbour
+    int best = 0;
+
+    for (int i = 1; i < p.numOptions; ++i)
+        if (std::abs (p.optionValues[i] - stored) < std::abs (p.optionValues[best] - stored))
+            best = i;
+
+    return (float) best;
+}
+
+// A choice whose option values are just its indices has nothing in the value to go by
+// once options are inserted or reordered, so it is matched on its label instead.
+static bool isLabelChoice (const HtmlToVstParamSpec& p) noexcept
+{
+    if (p.type != HtmlToVstParamType::choice || p.options == nullptr)
+        return false;
+
+    for (int i = 0; p.optionValues != nullptr && i < p.numOptions; ++i)
+        if (! juce::exactlyEqual (p.optionValues[i], (double) i))
+            return false;
+
+    return true;
+}
+
+static std::uint32_t getLabelHash (const HtmlToVstParamSpec& p, float value) noexcept
+{
+    if (p.type != HtmlToVstParamType::choice || p.options == nullptr || p.numOptions <= 0)
+        return 0;
+
+    return hashId (p.options[juce::jlimit (0, p.numOptions - 1, juce::roundToInt (value))]);
+}
+
+static int findLabel (const HtmlToVstParamSpec& p, std::uint32_t labelHash) noexcept
+{
+    for (int i = 0; i < p.numOptions; ++i)
+        if (hashId (p.options[i]) == labelHash)
+            return i;
+
+    return -1;
+}
+
+static std::uint32_t toBits (float f) noexcept
+{
+    std::uint32_t u;
+    std::memcpy (&u, &f, sizeof (u));
+    return u;
+}
+
+static float fromBits (std::uint32_t u) noexcept
+{
+    float f;
+    std::memcpy (&f, &u, sizeof (f));
+    return f;
+}
+
+//==============================================================================
+Values getDefaults() noexcept
+{
+    Values values {};
+
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+        values[i] = (float) kHtmlToVstParams[i].defaultValue;
+
+    return values;
+}
+
+void write (const Values& values, juce::MemoryBlock& dest, const ExtraValue* extras, int numExtras)
+{
+    jassert (numExtras >= 0 && (int) kNumHtmlToVstParams + numExtras <= 0xffff);
+    const auto numEntries = (int) kNumHtmlToVstParams + numExtras;
+
+    dest.setSize ((size_t) (kHeaderSize + kEntrySize * numEntries), false);
+    auto* out = static_cast<char*> (dest.getData());
+
+    auto put = [&out] (auto v)
+    {
+        v = juce::ByteOrder::swapIfBigEndian (v);
+        std::memcpy (out, &v, sizeof (v));
+        out += sizeof (v);
+    };
+
+    put (kMagic);
+    put (kFormatVersion);
+    put ((std::uint16_t) numEntries);
+    put (kSpecHash);
+    put ((std::uint16_t) kEntrySize);
+    put ((std::uint16_t) 0);
+
+    for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+    {
+        put (hashId (kHtmlToVstParams[i].id));
+        put (toBits (toStored (kHtmlToVstParams[i], values[i])));
+        put (getLabelHash (kHtmlToVstParams[i], values[i]));
+    }
+
+    for (int i = 0; i < numExtras; ++i)
+    {
+        put (hashId (extras[i].spec->id));
+        put (toBits (toStored (*extras[i].spec, extras[i].value)));
+        put (getLabelHash (*extras[i].spec, extras[i].value));
+    }
+}
+
+bool isBinary (const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= kHeaderSize
+        && juce::ByteOrder::littleEndianInt (data) == kMagic;
+}
+
+int getEncodedSize (const void* data, int sizeInBytes) noexcept
+{
+    if (! isBinary (data, sizeInBytes))
+        return 0;
+
+    const auto* in = static_cast<const char*> (data);
+    const auto numEntries = (int) juce::ByteOrder::littleEndianShort (in + 6);
+    const auto entrySize  = (int) juce::ByteOrder::littleEndianShort (in + 12);
+    const auto size = kHeaderSize + numEntries * entrySize;
+
+    return size <= sizeInBytes ? size : 0;
+}
+
+bool read (const void* data, int sizeInBytes, Values& values, ExtraValue* extras, int numExtras) noexcept
+{
+    if (! isBinary (data, sizeInBytes))
+        return false;
+
+    const auto* in = static_cast<const char*> (data);
+    const auto version    = juce::ByteOrder::littleEndianShort (in + 4);
+    const auto numEntries = (int) juce::ByteOrder::littleEndianShort (in + 6);
+    const auto specHash   = juce::ByteOrder::littleEndianInt (in + 8);
+    const auto entrySize  = (int) juce::ByteOrder::littleEndianShort (in + 12);
+
+    // Later versions may only append fields to an entry, never move these two
+    if (version == 0 || entrySize < kEntrySizeV1 || sizeInBytes < kHeaderSize + numEntries * entrySize)
+        return false;
+
+    const auto hasLabels = entrySize >= kEntrySize;
+
+    auto restore = [hasLabels] (const HtmlToVstParamSpec& p, const char* fields, float stored, float& value)
+    {
+        if (hasLabels && isLabelChoice (p))
+        {
+            // An option this build no longer has keeps its current value rather than a guess
+            if (const auto option = findLabel (p, juce::ByteOrder::littleEndianInt (fields + 8)); option >= 0)
+                value = (float) option;
+
+            return;
+        }
+
+        value = fromStored (p, stored);
+    };
+
+    // Same spec: entry i is parameter i, no lookup needed (extras, if any, follow)
+    const auto inOrder = specHash == kSpecHash && numEntries >= (int) kNumHtmlToVstParams;
+    const auto* entry = in + kHeaderSize;
+
+    for (int e = 0; e < numEntries; ++e, entry += entrySize)
+    {
+        const auto hash = juce::ByteOrder::littleEndianInt (entry);
+        const auto index = inOrder && e < (int) kNumHtmlToVstParams ? e : kIdTable.find (hash);
+        const auto stored = fromBits (juce::ByteOrder::littleEndianInt (entry + 4));
+
+        if (! std::isfinite (stored))
+            continue;
+
+        if (index >= 0)
+        {
+            restore (kHtmlToVstParams[index], entry, stored, values[(size_t) index]);
+            continue;
+        }
+
+        // Runtime parameters are few, so a scan is fine; no match means this build no longer has it
+        for (int i = 0; i < numExtras; ++i)
+        {
+            if (hashId (extras[i].spec->id) == hash)
+            {
+                restore (*extras[i].spec, entry, stored, extras[i].value);
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace StateCodec
+} // namespace htmltovst
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include "GeneratedParams.h"
+
+#include <array>
+#include <cstdint>
+
+//==============================================================================
+// Compact binary plug-in state, replacing the APVTS -> XML -> binary round trip.
+//
+//   "HTVS"  u16 formatVersion  u16 numEntries  u32 specHash  u16 entrySize  u16 reserved
+//   numEntries x { u32 idHash, f32 value, u32 labelHash [, fields added by later versions] }
+//
+// Little-endian throughout. Entries are matched to parameters by a hash of the
+// parameter ID (a constexpr open-addressing table), so a blob saved by an older
+// spec loads into a newer one: removed parameters are skipped, added ones keep their
+// defaults. Values are plain (denormalised). Choices store the option's value rather
+// than its index, plus a hash of the option's label (0 for anything else): numeric
+// choices are matched on the value and label-only ones (values 0..N-1) on the label,
+// so reordered or inserted options still land on the right choice. Version 1 blobs
+// have no label hash and restore label-only choices by index (builds that old skip
+// the hash). When specHash matches the running spec, entries are applied by position
+// without any lookup. Parameters an engine spec defines at run time follow the
+// generated ones as ordinary entries.
+//==============================================================================
+
+namespace htmltovst
+{
+namespace StateCodec
+{
+    constexpr std::uint16_t kFormatVersion = 2;
+
+    /** Plain values, indexed like kHtmlToVstParams (choices by option index). */
+    using Values = std::array<float, kNumHtmlToVstParams>;
+
+    /** Every parameter's default. */
+    Values getDefaults() noexcept;
+
+    /** A parameter defined at run time (by an engine spec), not in GeneratedParams.h. */
+    struct ExtraValue
+    {
+        const HtmlToVstParamSpec* spec = nullptr;
+        float value = 0.0f;     // plain, choices by option index
+    };
+
+    /** Replaces dest's contents with the encoded values, then the extras'. */
+    void write (const Values& values, juce::MemoryBlock& dest, const ExtraValue* extras = nullptr, int numExtras = 0);
+
+    /** True if the data carries the binary header; anything else is a legacy (XML) blob. */
+    bool isBinary (const void* data, int sizeInBytes) noexcept;
+
+    /** Bytes the binary blob at data occupies (anything after it is someone else's), or 0. */
+    int getEncodedSize (const void* data, int sizeInBytes) noexcept;
+
+    /** Overwrites the values (and extras) the blob has an entry for and leaves the rest alone.
+        Returns false, with everything untouched, if the blob is truncated or malformed.
+    */
+    bool read (const void* data, int sizeInBytes, Values& values, ExtraValue* extras = nullptr, int numExtras = 0) noexcept;
+}
+} // namespace htmltovst
@@ -0,0 +1,291 @@
+#include "TapeEq.h"
+#include "SharedTables.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace htmltovst
+{
+
+//==============================================================================
+// Time constants in microseconds, [standard][speed]; 0 means the curve has none
+static constexpr double kLowUs[TapeEq::kNumStandards][TapeEq::kNumSpeeds]  = { { 3180.0, 3180.0, 0.0 },
+                                                                              {    0.0,    0.0, 0.0 } };
+static constexpr double kHighUs[TapeEq::kNumStandards][TapeEq::kNumSpeeds] = { {   50.0,   50.0, 17.5 },
+                                                                              {   70.0,   35.0, 17.5 } };
+static constexpr double kSpeedsIps[TapeEq::kNumSpeeds] = { 7.5, 15.0, 30.0 };
+
+/** gain * (1 + s tz) / (1 + s tp) through the bilinear transform, prewarped so the corner
+    at 1 / tw lands where the standard puts it (clamped below Nyquist for low rates).
+*/
+static TapeEq::Section makeShelf (double tz, double tp, double tw, double gain, double sampleRate)
+{
+    const auto wc = juce::jmin (1.0 / tw, juce::MathConstants<double>::twoPi * 0.45 * sampleRate);
+    const auto k  = wc / std::tan (wc / (2.0 * sampleRate));
+    const auto a0 = 1.0 + tp * k;
+
+    TapeEq::Section s;
+    s.b0 = (float) (gain * (1.0 + tz * k) / a0);
+    s.b1 = (float) (gain * (1.0 - tz * k) / a0);
+    s.a1 = (float) ((1.0 - tp * k) / a0);
+    return s;
+}
+
+TapeEq::Bank TapeEq::makeBank (double sampleRate)
+{
+    const auto g = (double) juce::Decibels::decibelsToGain (kMaxShelfDb);
+    Bank bank {};
+
+    for (int st = 0; st < kNumStandards; ++st)
+    {
+        for (int sp = 0; sp < kNumSpeeds; ++sp)
+        {
+            auto& curve = bank[(size_t) getCurveIndex ((Standard) st, sp)];
+
+            // Playback boosts the lows below the LF corner (record cuts them to match) ...
+            if (const auto t1 = kLowUs[st][sp] * 1.0e-6; t1 > 0.0)
+            {
+                curve.playback[0] = makeShelf (t1, t1 * g, t1, g, sampleRate);
+                curve.record[0]   = makeShelf (t1 * g, t1, t1, 1.0 / g, sampleRate);
+                curve.lowPoleHz   = (float) (1.0 / (juce::MathConstants<double>::twoPi * t1 * g));
+            }
+
+            // ... and cuts the highs above the HF corner, which record boosts
+            const auto t2 = kHighUs[st][sp] * 1.0e-6;
+            curve.record[1]   = makeShelf (t2, t2 / g, t2, 1.0, sampleRate);
+            curve.playback[1] = makeShelf (t2 / g, t2, t2, 1.0, sampleRate);
+        }
+    }
+
+    return bank;
+}
+
+std::shared_ptr<const TapeEq::Bank> TapeEq::getSharedBank (SharedTables& tables, double sampleRate)
+{
+    return tables.get<Bank> ("tapeEq/" + juce::String (sampleRate), [sampleRate] { return makeBank (sampleRate); });
+}
+
+int TapeEq::getCurveIndex (Standard standard, int speedIndex) noexcept
+{
+    return juce::jlimit (0, kNumStandards - 1, (int) standard) * kNumSpeeds
+         + juce::jlimit (0, kNumSpeeds - 1, speedIndex);
+}
+
+int TapeEq::getSpeedIndex (double ips) noexcept
+{
+    int best = 0;
+
+    for (int i = 1; i < kNumSpeeds; ++i)
+        if (std::abs (kSpeedsIps[i] - ips) < std::abs (kSpeedsIps[best] - ips))
+            best = i;
+
+    return best;
+}
+
+//==============================================================================
+void TapeEq::prepare (std::shared_ptr<const Bank> newBank, double sampleRate)
+{
+    bank = std::move (newBank);
+    fadeLength = juce::jmax (1, juce::roundToInt (kCrossfadeSeconds * sampleRate));
+    selectedCurve = -1;
+    reset();
+}
+
+void TapeEq::reset() noexcept
+{
+    for (auto* stage : { &record, &playback })
+    {
+        for (auto& slot : stage->state)
+            slot.fill (LaneState());
+
+        stage->fadeRemaining = 0;
+    }
+
+    atRest = true;
+}
+
+void TapeEq::select (Standard standard, int speedIndex) noexcept
+{
+    const auto curve = getCurveIndex (standard, speedIndex);
+
+    if (curve == selectedCurve)
+        return;
+
+    // First choice after prepare or reset: nothing is playing yet, so there is nothing to fade from
+    if (selectedCurve < 0 || atRest)
+    {
+        slotCurve[(size_t) activeSlot] = curve;
+        selectedCurve = curve;
+        return;
+    }
+
+    if (record.fadeRemaining > 0 || playback.fadeRemaining > 0)
+        return;
+
+    // The incoming filters start from the outgoing ones' state rather than from rest
+    const auto next = 1 - activeSlot;
+    slotCurve[(size_t) next] = curve;
+
+    for (auto* stage : { &record, &playback })
+    {
+        stage->state[(size_t) next] = stage->state[(size_t) activeSlot];
+        stage->fadeRemaining = fadeLength;
+    }
+
+    activeSlot = next;
+    selectedCurve = curve;
+}
+
+double TapeEq::getTailSeconds (float threshold) const noexcept
+{
+    if (bank == nullptr || selectedCurve < 0)
+        return 0.0;
+
+    // Stored energy in the LF shelf is at most its gain, then decays at the pole
+    const auto poleHz = (double) (*bank)[(size_t) selectedCurve].lowPoleHz;
+    const auto peak = (double) juce::Decibels::decibelsToGain (kMaxShelfDb);
+
+    if (poleHz <= 0.0 || peak <= (double) threshold)
+        return 0.0;
+
+    return std::log (peak / (double) threshold) / (juce::MathConstants<double>::twoPi * poleHz);
+}
+
+const std::array<TapeEq::Section, TapeEq::kNumSections>& TapeEq::getSections (int slot, bool isPlayback) const noexcept
+{
+    const auto& curve = (*bank)[(size_t) slotCurve[(size_t) slot]];
+    return isPlayback ? curve.playback : curve.record;
+}
+
+//==============================================================================
+namespace
+{
+
+struct VecSection
+{
+    Float4 b0, b1, b2, a1, a2;
+};
+
+using VecSections = std::array<VecSection, TapeEq::kNumSections>;
+
+VecSections broadcast (const std::array<TapeEq::Section, TapeEq::kNumSections>& sections) noexcept
+{
+    VecSections v;
+
+    for (size_t k = 0; k < v.size(); ++k)
+    {
+        const auto& s = sections[k];
+        v[k] = { Float4::broadcast (s.b0), Float4::broadcast (s.b1), Float4::broadcast (s.b2),
+                 Float4::broadcast (s.a1), Float4::broadcast (s.a2) };
+    }
+
+    return v;
+}
+
+// Transposed direct form II, one channel per lane
+inline Float4 runCascade (const VecSections& c, std::array<Float4, TapeEq::kNumSections>& z1,
+                          std::array<Float4, TapeEq::kNumSections>& z2, Float4 x) noexcept
+{
+    for (size_t k = 0; k < c.size(); ++k)
+    {
+        const auto y = c[k].b0 * x + z1[k];
+        z1[k] = c[k].b1 * x - c[k].a1 * y + z2[k];
+        z2[k] = c[k].b2 * x - c[k].a2 * y;
+        x = y;
+    }
+
+    return x;
+}
+
+} // namespace
+
+template <typename SampleType>
+void TapeEq::processStage (Stage& stage, bool isPlayback, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert (numChannels <= kMaxChannels);
+    numChannels = juce::jmin (numChannels, kMaxChannels);
+
+    if (bank == nullptr || numSamples <= 0)
+        return;
+
+    const auto to = broadcast (getSections (activeSlot, isPlayback));
+    const auto fading = stage.fadeRemaining > 0;
+    const auto inc = 1.0f / (float) fadeLength;
+    const auto start = 1.0f - (float) stage.fadeRemaining * inc;
+
+    for (int g = 0; g * Float4::size < numChannels; ++g)
+    {
+        auto* const* groupChannels = channels + g * Float4::size;
+        const auto numLanes = juce::jmin (Float4::size, numChannels - g * Float4::size);
+        auto& sTo   = stage.state[(size_t) activeSlot][(size_t) g];
+        auto& sFrom = stage.state[(size_t) (1 - activeSlot)][(size_t) g];
+
+        // Work on local copies: stores to the buffer may alias the state, which would
+        // otherwise be reloaded from memory every sample.
+        auto to1 = sTo.z1, to2 = sTo.z2;
+
+        if (! fading)
+        {
+            processLanes (groupChannels, numLanes, numSamples, [&] (Float4 x, int) noexcept
+            {
+                return runCascade (to, to1, to2, x);
+            });
+        }
+        else
+        {
+            // Both curves run for the length of the fade; the output slides from one to the other
+            const auto from = broadcast (getSections (1 - activeSlot, isPlayback));
+            auto from1 = sFrom.z1, from2 = sFrom.z2;
+
+            processLanes (groupChannels, numLanes, numSamples, [&] (Float4 x, int i) noexcept
+            {
+                const auto a = runCascade (from, from1, from2, x);
+                const auto b = runCascade (to, to1, to2, x);
+                return a + Float4::broadcast (juce::jmin (1.0f, start + inc * (float) (i + 1))) * (b - a);
+            });
+
+            sFrom.z1 = from1;
+            sFrom.z2 = from2;
+        }
+
+        sTo.z1 = to1;
+        sTo.z2 = to2;
+
+        // A NaN from the host must not latch in the recursion
+        auto isFinite = [] (const LaneState& s) noexcept
+        {
+            return Float4::isFinite (s.z1[0]) && Float4::isFinite (s.z1[kNumSections - 1]);
+        };
+
+        if (! (isFinite (sTo) && (! fading || isFinite (sFrom))))
+        {
+            for (auto& slot : stage.state)
+                slot[(size_t) g] = LaneState();
+
+            for (int l = 0; l < numLanes; ++l)
+                juce::FloatVectorOperations::clear (groupChannels[l], numSamples);
+        }
+    }
+
+    if (fading)
+        stage.fadeRemaining = juce::jmax (0, stage.fadeRemaining - numSamples);
+}
+
+template <typename SampleType>
+void TapeEq::processRecord (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    atRest = false;
+    processStage (record, false, channels, numChannels, numSamples);
+}
+
+template <typename SampleType>
+void TapeEq::processPlayback (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    processStage (playback, true, channels, numChannels, numSamples);
+}
+
+template void TapeEq::processRecord (float* const*, int, int) noexcept;
+template void TapeEq::processRecord (double* const*, int, int) noexcept;
+template void TapeEq::processPlayback (float* const*, int, int) noexcept;
+template void TapeEq::processPlayback (double* const*, int, int) noexcept;
+
+} // namespace htmltovst
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "SimdLanes.h"
+
+#include <array>
+#include <memory>
+
+//==============================================================================
+// NAB / IEC record and playback equalisation for the "ampex_102" engine.
+//
+// Record pre-emphasis runs before the hysteresis and playback de-emphasis after it;
+// playback is the exact inverse of record, so at small signals the pair is flat and
+// only the tape's compression of the emphasised highs (and, for NAB, cut lows) is heard.
+//
+// Each curve is a cascade of biquads (a low shelf for the NAB 3180 us constant and a
+// high shelf for the speed's HF constant), run four channels per SIMD lane. Every
+// (standard, speed) curve for a sample rate is designed at once in makeBank(); a change
+// of curve crossfades between two filter sets over kCrossfadeSeconds, so switching
+// neither clicks nor allocates.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class SharedTables;
+
+class TapeEq
+{
+public:
+    enum class Standard
+    {
+        nab = 0,    // 3180 us + 50 us at 7.5 and 15 ips, AES 17.5 us at 30 ips
+        iec = 1     // 70 / 35 / 17.5 us, no LF constant
+    };
+
+    static constexpr int kNumStandards = 2;
+    static constexpr int kNumSpeeds    = 3;     // 7.5, 15, 30 ips
+    static constexpr int kNumSections  = 2;     // low shelf, high shelf
+    static constexpr int kMaxChannels  = 16;
+
+    // The ideal curves have unbounded gain; both shelves stop at this much
+    static constexpr float kMaxShelfDb = 20.0f;
+    static constexpr double kCrossfadeSeconds = 0.03;
+
+    struct Section
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    struct Curve
+    {
+        std::array<Section, kNumSections> record, playback;
+        float lowPoleHz = 0.0f;     // slowest playback pole, for the tail; 0 if none
+    };
+
+    /** Every (standard, speed) curve at one sample rate, indexed by getCurveIndex(). */
+    using Bank = std::array<Curve, kNumStandards * kNumSpeeds>;
+
+    /** Designs the bank. Depends only on the rate: build once per rate (see SharedTables). */
+    static Bank makeBank (double sampleRate);
+
+    /** makeBank()'s result from the process-wide cache, built on first use at each rate. */
+    static std::shared_ptr<const Bank> getSharedBank (SharedTables& tables, double sampleRate);
+
+    static int getCurveIndex (Standard standard, int speedIndex) noexcept;
+
+    /** Nearest of 7.5 / 15 / 30 ips. */
+    static int getSpeedIndex (double ips) noexcept;
+
+    /** Takes the bank for the processing rate; the first select() after this, or after
+        reset(), doesn't fade.
+    */
+    void prepare (std::shared_ptr<const Bank> newBank, double sampleRate);
+    void reset() noexcept;
+
+    /** Block-rate. A new curve fades in over kCrossfadeSeconds; changes that arrive during
+        a fade wait for it to finish (call this every block).
+    */
+    void select (Standard standard, int speedIndex) noexcept;
+
+    /** Buffers may be float or double; the filters run in float. Pass-through until prepared. */
+    template <typename SampleType>
+    void processRecord (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    template <typename SampleType>
+    void processPlayback (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Time for the playback LF boost to decay below threshold once the input stops. */
+    double getTailSeconds (float threshold) const noexcept;
+
+private:
+    static constexpr int kMaxGroups = (kMaxChannels + Float4::size - 1) / Float4::size;
+
+    struct LaneState
+    {
+        std::array<Float4, kNumSections> z1, z2;
+
+        LaneState() noexcept
+        {
+            z1.fill (Float4::broadcast (0.0f));
+            z2.fill (Float4::broadcast (0.0f));
+        }
+    };
+
+    // One of record / playback: a filter state per (slot, group) and its own fade counter,
+    // so the two stages fade in step however the tape between them is oversampled.
+    struct Stage
+    {
+        std::array<std::array<LaneState, kMaxGroups>, 2> state;
+        int fadeRemaining = 0;
+    };
+
+    template <typename SampleType>
+    void processStage (Stage& stage, bool playback, SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    const std::array<Section, kNumSections>& getSections (int slot, bool playback) const noexcept;
+
+    std::shared_ptr<const Bank> bank;
+    std::array<int, 2> slotCurve {};   // curve loaded in each filter slot
+    int activeSlot = 0;                // the slot being faded to (or playing)
+    int selectedCurve = -1;
+    int fadeLength = 1;
+    bool atRest = true;                // reset and not processed since
+
+    Stage record, playback;
+};
+
+} // namespace htmltovst
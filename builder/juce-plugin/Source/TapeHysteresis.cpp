@@ -0,0 +1,414 @@
+#include "TapeHysteresis.h"
+#include "SharedTables.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace htmltovst
+{
+
+//==============================================================================
+// Voiced so that, at nominal level, each formulation stays within ~1 dB of flat up to
+// its operating level and then compresses progressively. Hotter formulations (GP9,
+// 499) get more headroom (lower drive) and a narrower loop; older ones (406) less.
+static const TapeFormulation formulations[TapeHysteresis::kNumTapeTypes] =
+{
+    { "406",   1.60f, 0.24f, 0.72f, 0.010f },
+    { "456",   1.30f, 0.20f, 0.78f, 0.008f },
+    { "499",   1.10f, 0.18f, 0.80f, 0.007f },
+    { "GP9",   0.90f, 0.16f, 0.82f, 0.006f },
+    { "SM900", 1.00f, 0.18f, 0.80f, 0.007f },
+    { "SM911", 1.25f, 0.21f, 0.76f, 0.008f },
+};
+
+const TapeFormulation& TapeHysteresis::getFormulation (int tapeType) noexcept
+{
+    return formulations[juce::jlimit (0, kNumTapeTypes - 1, tapeType)];
+}
+
+//==============================================================================
+namespace
+{
+
+struct ModelCoeffs
+{
+    ModelCoeffs (float newKappa, float newC, float newAlpha) noexcept
+        : k (Float4::broadcast (newKappa)),
+          c (Float4::broadcast (newC)),
+          alpha (Float4::broadcast (newAlpha)),
+          oneMinusC (Float4::broadcast (1.0f - newC))
+    {
+    }
+
+    Float4 k, c, alpha, oneMinusC;
+};
+
+struct Langevin
+{
+    Float4 L, dL, d2L;
+};
+
+/** L(q) = coth(q) - 1/q and its first two derivatives.
+
+    Below |q| = 0.5 the closed forms cancel catastrophically in float, so a Taylor
+    series is used there instead (truncation error < 1e-7).
+*/
+static inline Langevin langevin (Float4 q) noexcept
+{
+    const auto one = Float4::broadcast (1.0f);
+    const auto sgn = Float4::sign (q);
+    const auto ax  = Float4::abs (q);
+    const auto big = Float4::max (ax, Float4::broadcast (0.5f));
+
+    const auto e    = Float4::exp (Float4::broadcast (-2.0f) * big);
+    const auto coth = (one + e) / (one - e);
+    const auto inv  = one / big;
+    const auto csch2 = coth * coth - one;
+
+    const Langevin closed { sgn * (coth - inv),
+                            inv * inv - csch2,
+                            sgn * Float4::broadcast (2.0f) * (coth * csch2 - inv * inv * inv) };
+
+    const auto q2 = q * q;
+    const Langevin series { q * (Float4::broadcast (1.0f / 3.0f) - q2 * (Float4::broadcast (1.0f / 45.0f) - q2 * (Float4::broadcast (2.0f / 945.0f) - q2 * Float4::broadcast (1.0f / 4725.0f)))),
+                            Float4::broadcast (1.0f / 3.0f) - q2 * (Float4::broadcast (1.0f / 15.0f) - q2 * (Float4::broadcast (2.0f / 189.0f) - q2 * Float4::broadcast (1.0f / 675.0f))),
+                            q * (q2 * (Float4::broadcast (8.0f / 189.0f) - q2 * Float4::broadcast (6.0f / 675.0f)) - Float4::broadcast (2.0f / 15.0f)) };
+
+    const auto useSeries = Float4::lessThan (ax, Float4::broadcast (0.5f));
+    return { Float4::select (useSeries, series.L,   closed.L),
+             Float4::select (useSeries, series.dL,  closed.dL),
+             Float4::select (useSeries, series.d2L, closed.d2L) };
+}
+
+/** Jiles-Atherton dm/dt for field h(t) with derivative hd; optionally d(dm/dt)/dm for Newton. */
+template <bool withDerivative>
+static inline Float4 dmdt (const ModelCoeffs& k, Float4 m, Float4 h, Float4 hd, Float4* dfdm = nullptr) noexcept
+{
+    const auto zero = Float4::broadcast (0.0f);
+    const auto one  = Float4::broadcast (1.0f);
+
+    // |m| <= 1 physically; explicit stages can overshoot on huge steps, so bound them here.
+    m = Float4::clamp (m, -1.0f, 1.0f);
+
+    const auto lan = langevin (h + k.alpha * m);
+    const auto x   = lan.L - m;
+
+    const auto delta  = Float4::sign (hd);
+    const auto deltaM = Float4::select (Float4::lessThan (zero, delta * x), one, zero);
+
+    const auto d1 = k.oneMinusC * delta * k.k - k.alpha * x;
+    const auto t1 = k.oneMinusC * deltaM * x / d1 * hd;
+    const auto t2 = k.c * lan.dL * hd;
+    const auto d  = one - k.c * k.alpha * lan.dL;
+    const auto f  = (t1 + t2) / d;
+
+    if constexpr (withDerivative)
+    {
+        const auto dx   = k.alpha * lan.dL - one;
+        const auto dt1  = k.oneMinusC * deltaM * hd * dx * (k.oneMinusC * delta * k.k) / (d1 * d1);
+        const auto dt2  = k.c * hd * lan.d2L * k.alpha;
+        const auto dd   = Float4::broadcast (0.0f) - k.c * k.alpha * k.alpha * lan.d2L;
+        *dfdm = ((dt1 + dt2) * d - (t1 + t2) * dd) / (d * d);
+    }
+
+    return f;
+}
+
+} // namespace
+
+//==============================================================================
+TapeHysteresis::Coeffs TapeHysteresis::makeCoeffs (const TapeFormulation& tape, float bias) noexcept
+{
+    // Under-bias widens the loop and lowers the reversible part (grittier); over-bias the reverse.
+    Coeffs c;
+    c.kappa = tape.kappa * (1.0f - 0.06f * bias);
+    c.c     = juce::jlimit (0.3f, 0.92f, tape.c * (1.0f + 0.03f * bias));
+
+    // dm/dt has a pole where (1 - c) * kappa == alpha * |L - m|, and |L - m| <= 2,
+    // so keep the coupling well inside that bound.
+    c.alpha = juce::jmin (tape.alpha, 0.25f * (1.0f - c.c) * c.kappa);
+    return c;
+}
+
+TapeHysteresis::CalibrationTable TapeHysteresis::measureCalibration()
+{
+    // Measure the gain of every (tape, bias) point at operating level on the model itself,
+    // like a calibration tone: 1 kHz at h = 0.15 for 20 ms at 48 kHz, RMS over the second half.
+    constexpr double fs = 48000.0;
+    constexpr int numSamples = 960;
+    constexpr float amp = 0.15f;
+
+    CalibrationTable table {};
+    TapeHysteresis model;
+    std::vector<float> buffer ((size_t) numSamples);
+
+    for (int t = 0; t < kNumTapeTypes; ++t)
+    {
+        for (int b = 0; b < kNumBiasSteps; ++b)
+        {
+            const auto coeffs = makeCoeffs (formulations[t], (float) (b - kNumBiasSteps / 2));
+
+            for (int i = 0; i < numSamples; ++i)
+                buffer[(size_t) i] = amp * (float) std::sin (juce::MathConstants<double>::twoPi * 1000.0 * i / fs);
+
+            model.current = model.target = coeffs;
+            model.hasTarget = true;
+            model.setHighPassRate (fs);
+            LaneState s;
+            float* ch = buffer.data();
+            model.processGroup<Solver::rk4> (&ch, 1, numSamples, (float) (1.0 / fs), s);
+
+            double inSq = 0.0, outSq = 0.0;
+            for (int i = numSamples / 2; i < numSamples; ++i)
+            {
+                const double in = amp * std::sin (juce::MathConstants<double>::twoPi * 1000.0 * i / fs);
+                inSq  += in * in;
+                outSq += (double) buffer[(size_t) i] * buffer[(size_t) i];
+            }
+
+            table[(size_t) (t * kNumBiasSteps + b)] = inSq > 0.0 ? (float) std::sqrt (outSq / inSq) : 1.0f;
+        }
+    }
+
+    return table;
+}
+
+std::shared_ptr<const TapeHysteresis::CalibrationTable> TapeHysteresis::getSharedCalibration (SharedTables& tables)
+{
+    return tables.get<CalibrationTable> ("tapeCalibration", measureCalibration);
+}
+
+void TapeHysteresis::prepare (std::shared_ptr<const CalibrationTable> table)
+{
+    calibration = std::move (table);
+    hasTarget = false;
+    reset();
+}
+
+float TapeHysteresis::getCalibrationSlope (const CalibrationTable* table, int tapeType, float bias) noexcept
+{
+    if (table == nullptr)
+        return 1.0f;
+
+    const auto pos  = juce::jlimit (0.0f, (float) (kNumBiasSteps - 1), bias + (float) (kNumBiasSteps / 2));
+    const auto i0   = juce::jmin ((int) pos, kNumBiasSteps - 2);
+    const auto frac = pos - (float) i0;
+    const auto* row = table->data() + tapeType * kNumBiasSteps;
+    return juce::jmax (1.0e-3f, row[i0] + frac * (row[i0 + 1] - row[i0]));
+}
+
+void TapeHysteresis::setHighPassRate (double sampleRate) noexcept
+{
+    if (juce::exactlyEqual (sampleRate, highPassRate))
+        return;
+
+    highPassRate = sampleRate;
+    highPassCoeff = (float) std::exp (-juce::MathConstants<double>::twoPi * kReproHighPassHz / sampleRate);
+}
+
+float TapeHysteresis::getSmallSignalGain() const noexcept
+{
+    const auto slope = getCalibrationSlope (calibration.get(), settings.tapeType, settings.bias);
+    return juce::jmax (current.hGain * current.outGain, target.hGain * target.outGain) * slope;
+}
+
+double TapeHysteresis::getTailSeconds (float threshold) const noexcept
+{
+    // |m| <= 1, so the worst step into the high-pass is outGain; it then decays as exp (-2 pi fc t).
+    const auto peak = (double) juce::jmax (current.outGain, target.outGain);
+
+    if (peak <= (double) threshold)
+        return 0.0;
+
+    return std::log (peak / (double) threshold) / (juce::MathConstants<double>::twoPi * kReproHighPassHz);
+}
+
+void TapeHysteresis::reset() noexcept
+{
+    for (auto& s : state)
+        s = LaneState();
+
+    if (hasTarget)
+        current = target;
+}
+
+TapeHysteresis::Coeffs TapeHysteresis::getCoeffs (const Settings& values, const CalibrationTable* table) noexcept
+{
+    const auto tapeType = juce::jlimit (0, kNumTapeTypes - 1, values.tapeType);
+    const auto& tape = formulations[tapeType];
+    auto coeffs = makeCoeffs (tape, values.bias);
+
+    coeffs.hGain = tape.drive * (values.fluxivity / kReferenceFluxivity)
+                     * juce::Decibels::decibelsToGain (values.recordDb);
+
+    // Auto-cal trims the repro level so the calibration level comes back at unity whatever the
+    // record level, bias and fluxivity; otherwise the machine is only calibrated at nominal.
+    const auto trim = values.autoCal ? 1.0f / (coeffs.hGain * getCalibrationSlope (table, tapeType, values.bias))
+                                     : 1.0f / (tape.drive * getCalibrationSlope (table, tapeType, 0.0f));
+
+    coeffs.outGain = trim * juce::Decibels::decibelsToGain (values.reproDb);
+    return coeffs;
+}
+
+void TapeHysteresis::setSettings (const Settings& newSettings) noexcept
+{
+    derivativeStale = derivativeStale || newSettings.solver != settings.solver;
+    settings = newSettings;
+    settings.tapeType = juce::jlimit (0, kNumTapeTypes - 1, settings.tapeType);
+
+    target = getCoeffs (settings, calibration.get());
+
+    if (! hasTarget)
+    {
+        current = target;
+        hasTarget = true;
+    }
+}
+
+//==============================================================================
+template <TapeHysteresis::Solver solver, typename SampleType>
+void TapeHysteresis::processGroup (SampleType* const* channels, int numLanes, int numSamples, float T, LaneState& s) noexcept
+{
+    const ModelCoeffs k (target.kappa, target.c, target.alpha);
+
+    const auto invT   = Float4::broadcast (1.0f / T);
+    const auto halfT  = Float4::broadcast (0.5f * T);
+    const auto tVec   = Float4::broadcast (T);
+    const auto half   = Float4::broadcast (0.5f);
+    const auto diffA  = Float4::broadcast ((1.0f + kDiffAlpha));
+    const auto diffB  = Float4::broadcast (kDiffAlpha);
+    const auto hpR    = Float4::broadcast (highPassCoeff);
+
+    // Gains glide linearly across the block
+    const auto inc = 1.0f / (float) juce::jmax (1, numSamples);
+    const auto hGainStep   = (target.hGain   - current.hGain)   * inc;
+    const auto outGainStep = (target.outGain - current.outGain) * inc;
+
+    if constexpr (solver == Solver::newton4 || solver == Solver::newton8)
+        if (derivativeStale)
+            s.f = dmdt<false> (k, s.m, s.h, s.hd);
+
+    // Sample i of every lane through the model; x holds one sample per channel
+    auto step = [&] (Float4 x, int i) noexcept
+    {
+        const auto hGain   = current.hGain   + hGainStep   * (float) (i + 1);
+        const auto outGain = current.outGain + outGainStep * (float) (i + 1);
+
+        const auto h  = x * Float4::broadcast (hGain);
+        const auto hd = diffA * invT * (h - s.h) - diffB * s.hd;
+        auto m = s.m;
+
+        if constexpr (solver == Solver::rk2)
+        {
+            const auto hm  = half * (h + s.h);
+            const auto hdm = half * (hd + s.hd);
+            const auto k1 = tVec * dmdt<false> (k, m, s.h, s.hd);
+            const auto k2 = tVec * dmdt<false> (k, m + half * k1, hm, hdm);
+            m = m + k2;
+        }
+        else if constexpr (solver == Solver::rk4)
+        {
+            const auto hm  = half * (h + s.h);
+            const auto hdm = half * (hd + s.hd);
+            const auto k1 = tVec * dmdt<false> (k, m, s.h, s.hd);
+            const auto k2 = tVec * dmdt<false> (k, m + half * k1, hm, hdm);
+            const auto k3 = tVec * dmdt<false> (k, m + half * k2, hm, hdm);
+            const auto k4 = tVec * dmdt<false> (k, m + k3, h, hd);
+            m = m + (k1 + Float4::broadcast (2.0f) * (k2 + k3) + k4) * Float4::broadcast (1.0f / 6.0f);
+        }
+        else
+        {
+            // Implicit trapezoidal rule solved with Newton-Raphson from an explicit Euler guess
+            constexpr int iterations = solver == Solver::newton4 ? 4 : 8;
+            const auto m0 = m;
+            m = m0 + tVec * s.f;
+
+            for (int it = 0; it < iterations; ++it)
+            {
+                Float4 dfdm;
+                const auto fv = dmdt<true> (k, m, h, hd, &dfdm);
+                const auto g  = m - m0 - halfT * (fv + s.f);
+                const auto gd = Float4::broadcast (1.0f) - halfT * dfdm;
+                m = m - g / gd;
+            }
+
+            s.f = dmdt<false> (k, m, h, hd);
+        }
+
+        m = Float4::clamp (m, -1.0f, 1.0f);
+
+        s.m = m;
+        s.h = h;
+        s.hd = hd;
+
+        const auto y = m - s.dcIn + hpR * s.dcOut;
+        s.dcIn  = m;
+        s.dcOut = y;
+
+        return y * Float4::broadcast (outGain);
+    };
+
+    processLanes (channels, numLanes, numSamples, step);
+
+    // A blow-up (e.g. a NaN from the host) must not latch: start the lanes from rest.
+    if (! (Float4::isFinite (s.m) && Float4::isFinite (s.hd) && Float4::isFinite (s.f) && Float4::isFinite (s.dcOut)))
+    {
+        s = LaneState();
+
+        for (int l = 0; l < numLanes; ++l)
+            juce::FloatVectorOperations::clear (channels[l], numSamples);
+    }
+}
+
+void TapeHysteresis::beginBlock (double sampleRate) noexcept
+{
+    blockT = (float) (1.0 / sampleRate);
+    setHighPassRate (sampleRate);
+}
+
+template <typename SampleType>
+void TapeHysteresis::processChannelGroup (int group, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    const auto first = group * Float4::size;
+    numChannels = juce::jmin (numChannels, kMaxChannels);
+
+    if (first >= numChannels)
+        return;
+
+    const auto numLanes = juce::jmin (Float4::size, numChannels - first);
+    auto* lanes = channels + first;
+    auto& s = state[(size_t) group];
+
+    switch (settings.solver)
+    {
+        case Solver::rk2:     processGroup<Solver::rk2>     (lanes, numLanes, numSamples, blockT, s); break;
+        case Solver::rk4:     processGroup<Solver::rk4>     (lanes, numLanes, numSamples, blockT, s); break;
+        case Solver::newton4: processGroup<Solver::newton4> (lanes, numLanes, numSamples, blockT, s); break;
+        case Solver::newton8: processGroup<Solver::newton8> (lanes, numLanes, numSamples, blockT, s); break;
+    }
+}
+
+void TapeHysteresis::endBlock() noexcept
+{
+    current = target;
+    derivativeStale = false;
+}
+
+template <typename SampleType>
+void TapeHysteresis::process (SampleType* const* channels, int numChannels, int numSamples, double sampleRate) noexcept
+{
+    jassert (numChannels <= kMaxChannels);
+
+    beginBlock (sampleRate);
+
+    for (int g = 0; g < getNumGroups (numChannels); ++g)
+        processChannelGroup (g, channels, numChannels, numSamples);
+
+    endBlock();
+}
+
+template void TapeHysteresis::process (float* const*, int, int, double) noexcept;
+template void TapeHysteresis::process (double* const*, int, int, double) noexcept;
+template void TapeHysteresis::processChannelGroup (int, float* const*, int, int) noexcept;
+template void TapeHysteresis::processChannelGroup (int, double* const*, int, int) noexcept;
+
+} // namespace htmltovst
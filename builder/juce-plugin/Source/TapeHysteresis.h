@@ -0,0 +1,168 @@
+#pragma once
+
+#include "SimdLanes.h"
+
+#include <array>
+#include <memory>
+
+//==============================================================================
+// Jiles-Atherton magnetic hysteresis for the "ampex_102" engine.
+//
+// The model runs in normalised units (m = M / Ms, h = H / a), so every state stays
+// O(1) and single precision is enough. Channels are processed four at a time, one
+// per SIMD lane; all state lives in fixed arrays, so process() never allocates.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class SharedTables;
+
+/** Per-formulation coefficients, normalised as above. */
+struct TapeFormulation
+{
+    const char* name;
+    float drive;    // h per unit input at 0 dB record level and 250 nWb/m
+    float kappa;    // pinning / loop width (k / a)
+    float c;        // reversible fraction
+    float alpha;    // mean-field coupling (alpha * Ms / a)
+};
+
+class TapeHysteresis
+{
+public:
+    enum class Solver
+    {
+        rk2,        // 2 model evaluations per sample
+        rk4,        // 4 evaluations
+        newton4,    // implicit trapezoidal, 4 Newton-Raphson iterations
+        newton8     // ... 8 iterations
+    };
+
+    static constexpr int kMaxChannels  = 16;
+    static constexpr int kNumTapeTypes = 6;     // 406, 456, 499, GP9, SM900, SM911
+    static constexpr int kNumBiasSteps = 11;    // -5 .. +5 in 1 dB steps
+    static constexpr float kReferenceFluxivity = 250.0f;
+
+    // The repro head doesn't reproduce DC, so remanent magnetisation left behind
+    // when the input stops decays out instead of sitting on the output.
+    static constexpr float kReproHighPassHz = 5.0f;
+
+    static const TapeFormulation& getFormulation (int tapeType) noexcept;
+
+    /** Operating-level dm/dh per tape type and bias step. */
+    using CalibrationTable = std::array<float, kNumTapeTypes * kNumBiasSteps>;
+
+    /** Measures the calibration table on the model itself. The same for every instance and
+        sample rate, and far from free: build it once per process (see SharedTables).
+    */
+    static CalibrationTable measureCalibration();
+
+    /** measureCalibration()'s table from the process-wide cache, built on first use. */
+    static std::shared_ptr<const CalibrationTable> getSharedCalibration (SharedTables& tables);
+
+    struct Settings
+    {
+        int   tapeType   = 1;
+        float fluxivity  = kReferenceFluxivity;   // nWb/m
+        float bias       = 0.0f;                  // -5 .. +5
+        float recordDb   = 0.0f;
+        float reproDb    = 0.0f;
+        bool  autoCal    = true;
+        Solver solver    = Solver::rk2;
+    };
+
+    /** What a Settings comes to: the model's coefficients and the gains either side of it. */
+    struct Coeffs
+    {
+        float hGain   = 1.0f;
+        float outGain = 1.0f;
+        float kappa   = 0.5f;
+        float c       = 0.2f;
+        float alpha   = 0.01f;
+    };
+
+    /** The coefficients for some settings (tapeType clamped); a null table means unity slope. */
+    static Coeffs getCoeffs (const Settings& values, const CalibrationTable* table) noexcept;
+
+    /** Operating-level dm/dh at a bias between the table's steps (1 without a table). */
+    static float getCalibrationSlope (const CalibrationTable* table, int tapeType, float bias) noexcept;
+
+    // h is differentiated with an alpha transform: between backward Euler (0) and
+    // trapezoidal (1), damped enough not to ring at Nyquist.
+    static constexpr float kDiffAlpha = 0.75f;
+
+    /** Takes the calibration from measureCalibration(); held until the next prepare. */
+    void prepare (std::shared_ptr<const CalibrationTable> table);
+    void reset() noexcept;
+
+    /** Block-rate update; gains glide to the new values over the next block. */
+    void setSettings (const Settings& newSettings) noexcept;
+
+    /** Buffers may be float or double; the model itself runs in float (see above). */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples, double sampleRate) noexcept;
+
+    /** process() in pieces, so its groups of four channels can run on different threads:
+        beginBlock(), processChannelGroup() once per group (any threads, any order: groups
+        share only read-only settings), then endBlock(). The result is the same either way.
+    */
+    void beginBlock (double sampleRate) noexcept;
+    void endBlock() noexcept;
+
+    template <typename SampleType>
+    void processChannelGroup (int group, SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    static int getNumGroups (int numChannels) noexcept
+    {
+        const auto n = numChannels < kMaxChannels ? numChannels : kMaxChannels;
+        return (n + Float4::size - 1) / Float4::size;
+    }
+
+    Solver getSolver() const noexcept           { return settings.solver; }
+
+    /** Low-level gain from input to output with the current settings. */
+    float getSmallSignalGain() const noexcept;
+
+    /** Time for the largest possible remanence step to decay below threshold at the output. */
+    double getTailSeconds (float threshold) const noexcept;
+
+private:
+    // A cache line each, so groups on different threads don't share one
+    struct alignas (64) LaneState
+    {
+        Float4 m  = Float4::broadcast (0.0f);
+        Float4 h  = Float4::broadcast (0.0f);
+        Float4 hd = Float4::broadcast (0.0f);
+        Float4 f  = Float4::broadcast (0.0f);
+        Float4 dcIn  = Float4::broadcast (0.0f);
+        Float4 dcOut = Float4::broadcast (0.0f);
+    };
+
+    static constexpr int kMaxGroups = (kMaxChannels + Float4::size - 1) / Float4::size;
+
+    template <Solver solver, typename SampleType>
+    void processGroup (SampleType* const* channels, int numLanes, int numSamples, float T, LaneState& s) noexcept;
+
+    static Coeffs makeCoeffs (const TapeFormulation& tape, float bias) noexcept;
+    void setHighPassRate (double sampleRate) noexcept;
+
+    Settings settings;
+    Coeffs current, target;
+    bool hasTarget = false;
+
+    // Only the Newton solvers keep dm/dt (LaneState::f) up to date; after a switch to one,
+    // its first block works it out from the state before using it.
+    bool derivativeStale = false;
+
+    double highPassRate = 0.0;
+    float highPassCoeff = 0.0f;
+    float blockT = 0.0f;
+
+    std::array<LaneState, kMaxGroups> state;
+
+    // Shared with every other instance; null (unity slope) until prepared
+    std::shared_ptr<const CalibrationTable> calibration;
+};
+
+} // namespace htmltovst
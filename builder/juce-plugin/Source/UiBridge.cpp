@@ -0,0 +1,495 @@
+#include "UiBridge.h"
+#include "UiResources.h"
+
+static const juce::Identifier kInEvent     { "htv.in" };
+static const juce::Identifier kParamsEvent { "htv.params" };
+static const juce::Identifier kMetersEvent { "htv.meters" };
+static const juce::Identifier kCpuEvent    { "htv.cpu" };
+static const juce::Identifier kAckEvent    { "htv.ack" };
+static const juce::Identifier kShownEvent  { "htv.shown" };
+static const juce::Identifier kPaintEvent  { "htv.painted" };
+static const juce::Identifier kHelloFn     { "htvHello" };
+
+// [ version, seq, sentAtMs, queueAgeMs, coalesced, transportMs ] then triples
+static constexpr int kHeaderSize = 6;
+static constexpr int kOpSize = 3;
+
+// Editor diagnostics only reach the log with HTMLTOVST_UI_LOG=1 in the environment
+static bool isUiLogEnabled()
+{
+    static const bool enabled = juce::SystemStats::getEnvironmentVariable ("HTMLTOVST_UI_LOG", {}).getIntValue() > 0;
+    return enabled;
+}
+
+// Injected into every page before its own scripts run, so UIs only talk to window.htv:
+//   htv.ready()            -> Promise<{ version, ids, labels, values }>
+//   htv.set (id, value)    htv.begin (id)    htv.end (id)
+//   htv.bindRange (el, id) pointer gestures + input events for an <input type=range>
+//   htv.onParams (fn)      fn ({ id: value, ... } for the params that changed, valuesByIndex)
+//   htv.onMeters (fn)      fn ({ peak, rms, gainReductionDb, drive, overruns, bands }), bands a Float32Array in dB
+//   htv.onCpu (fn)         fn ({ blocks, mean, p99, max, meanUs, overhead }), loads as a share of the block's duration
+//   htv.stats              { rttMs, acks, batches, coalesced }
+// It also reports the first paint after load, and after each "htv.shown", as "htv.painted".
+static const char* const kBridgeScript = R"JS(
+(function () {
+  if (window.htv) return;
+
+  const VERSION = 1, SET = 0, BEGIN = 1, END = 2;
+  const stats = { rttMs: 0, acks: 0, batches: 0, coalesced: 0 };
+  const pending = new Map();
+  const paramListeners = [], meterListeners = [], cpuListeners = [], buffers = {};
+
+  let ids = [], index = new Map(), values = [];
+  let queue = [], lastSet = new Map(), oldest = 0, coalesced = 0, scheduled = false;
+  let seq = 0, transportMs = 0, nextResultId = 0, listening = false;
+
+  function backend() { return window.__JUCE__ && window.__JUCE__.backend; }
+
+  // Binary events are base64 float32, each decoded into its own reused buffer, so a
+  // steady stream creates no garbage beyond the string.
+  function decode(name, b64) {
+    const bin = atob(b64);
+    let bytes = buffers[name];
+    if (!bytes || bytes.length < bin.length) bytes = buffers[name] = new Uint8Array(bin.length);
+    for (let i = 0; i < bin.length; ++i) bytes[i] = bin.charCodeAt(i);
+    return new Float32Array(bytes.buffer, 0, bin.length >> 2);
+  }
+
+  function listen() {
+    const b = backend();
+    if (listening || !b) return !!b;
+    listening = true;
+
+    b.addEventListener("__juce__complete", (r) => {
+      const resolve = pending.get(r.promiseId);
+      if (resolve) { pending.delete(r.promiseId); resolve(r.result); }
+    });
+
+    b.addEventListener("htv.ack", (a) => {
+      stats.rttMs = performance.now() - a[1];
+      transportMs = stats.rttMs / 2;
+      ++stats.acks;
+    });
+
+    b.addEventListener("htv.shown", () => reportPaint());
+
+    b.addEventListener("htv.meters", (b64) => {
+      const f = decode("meters", b64);
+      if (f[0] !== VERSION) return;
+      const m = { peak: [f[1], f[2]], rms: [f[3], f[4]], gainReductionDb: f[5], drive: f[6],
+                  overruns: f[7], bands: f.subarray(9, 9 + f[8]) };
+      meterListeners.forEach((fn) => fn(m));
+    });
+
+    b.addEventListener("htv.cpu", (b64) => {
+      const f = decode("cpu", b64);
+      if (f[0] !== VERSION) return;
+      const c = { blocks: f[1], mean: f[2], p99: f[3], max: f[4], meanUs: f[5], overhead: f[6] };
+      cpuListeners.forEach((fn) => fn(c));
+    });
+
+    b.addEventListener("htv.params", (b64) => {
+      const f = decode("params", b64);
+      if (f[0] !== VERSION) return;
+
+      const changed = {};
+      for (let k = 0, n = f[1]; k < n; ++k) {
+        const i = f[2 + 2 * k], v = f[3 + 2 * k];
+        values[i] = v;
+        if (i < ids.length) changed[ids[i]] = v;
+      }
+      paramListeners.forEach((fn) => fn(changed, values));
+    });
+
+    return true;
+  }
+
+  // Two frames: the first callback runs before the frame is drawn, the second after.
+  function reportPaint() {
+    requestAnimationFrame(() => requestAnimationFrame(() => {
+      const b = backend();
+      if (b) b.emitEvent("htv.painted", [performance.now()]);
+    }));
+  }
+
+  if (document.readyState === "complete") reportPaint();
+  else window.addEventListener("load", reportPaint);
+
+  function call(name, params) {
+    if (!listen()) return Promise.reject(new Error("no native backend"));
+    return new Promise((resolve) => {
+      const resultId = nextResultId++;
+      pending.set(resultId, resolve);
+      backend().emitEvent("__juce__invoke", { name, params, resultId });
+    });
+  }
+
+  // One message per animation frame; repeated sets of the same parameter collapse into one.
+  function flush() {
+    scheduled = false;
+    if (!queue.length || !listen()) return;
+
+    const now = performance.now();
+    const msg = [VERSION, ++seq, now, now - oldest, coalesced, transportMs];
+    for (const op of queue) msg.push(op[0], op[1], op[2]);
+
+    stats.coalesced += coalesced;
+    ++stats.batches;
+    queue = []; lastSet.clear(); coalesced = 0;
+
+    backend().emitEvent("htv.in", msg);
+  }
+
+  function push(kind, id, value) {
+    const i = typeof id === "number" ? id : index.get(id);
+    if (i === undefined) return;
+
+    if (kind === SET && lastSet.has(i)) {
+      queue[lastSet.get(i)][2] = value;
+      ++coalesced;
+    } else {
+      if (!queue.length) oldest = performance.now();
+      if (kind === SET) lastSet.set(i, queue.length); else lastSet.delete(i);
+      queue.push([kind, i, value]);
+    }
+
+    if (!scheduled) { scheduled = true; requestAnimationFrame(flush); }
+  }
+
+  window.htv = {
+    stats,
+    ready() {
+      return call("htvHello", []).then((hello) => {
+        ids = hello.ids;
+        index = new Map(ids.map((id, i) => [id, i]));
+        values = hello.values.slice();
+        return hello;
+      });
+    },
+    set(id, value) { push(SET, id, Number(value)); },
+    begin(id) { push(BEGIN, id, 0); },
+    end(id) { push(END, id, 0); },
+    onParams(fn) { listen(); paramListeners.push(fn); },
+    onMeters(fn) { listen(); meterListeners.push(fn); },
+    onCpu(fn) { listen(); cpuListeners.push(fn); },
+    bindRange(el, id) {
+      let active = false;
+      const end = () => { if (active) { active = false; window.htv.end(id); } };
+      el.addEventListener("pointerdown", () => { active = true; window.htv.begin(id); });
+      el.addEventListener("input", () => window.htv.set(id, el.value));
+      el.addEventListener("pointerup", end);
+      el.addEventListener("pointercancel", end);
+      el.addEventListener("change", end);
+    }
+  };
+})();
+)JS";
+
+//==============================================================================
+juce::WebBrowserComponent::Options UiBridge::makeOptions (std::shared_ptr<Route> route)
+{
+    // Native integration needs WebView2 on Windows; give it a writable profile folder.
+    const auto webView2 = juce::WebBrowserComponent::Options::WinWebView2 {}
+                              .withUserDataFolder (juce::File::getSpecialLocation (juce::File::tempDirectory)
+                                                       .getChildFile ("HTMLtoVST_WebView2"));
+
+    return juce::WebBrowserComponent::Options {}
+        .withBackend (juce::WebBrowserComponent::Options::Backend::webview2)
+        .withWinWebView2Options (webView2)
+        .withKeepPageLoadedWhenBrowserIsHidden()
+        .withResourceProvider ([] (const juce::String& url) { return UiResources::get (url); })
+        .withNativeIntegrationEnabled()
+        .withUserScript (kBridgeScript)
+        .withEventListener (kInEvent, [route] (const juce::var& message)
+                                      {
+                                          if (route->bridge != nullptr)
+                                              route->bridge->handleBatch (message);
+                                      })
+        .withEventListener (kPaintEvent, [route] (const juce::var&)
+                                         {
+                                             if (route->bridge != nullptr)
+                                                 route->bridge->handlePainted();
+                                         })
+        .withNativeFunction (kHelloFn, [route] (const juce::Array<juce::var>&,
+                                                juce::WebBrowserComponent::NativeFunctionCompletion completion)
+                                       {
+                                           // A pooled page loads before any editor owns it: answer with defaults.
+                                           completion (getHello (route->bridge != nullptr ? &route->bridge->processor : nullptr));
+                                       });
+}
+
+juce::var UiBridge::getHello (const HtmlToVstPluginAudioProcessor* processor)
+{
+    juce::Array<juce::var> ids, labels, values;
+
+    for (int i = 0; i < (int) kNumHtmlToVstParams; ++i)
+    {
+        ids.add (juce::String (kHtmlToVstParams[i].id));
+        labels.add (juce::String (kHtmlToVstParams[i].label));
+        values.add (processor != nullptr ? (double) processor->getParamValue (i) : kHtmlToVstParams[i].defaultValue);
+    }
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty ("version", kProtocolVersion);
+    obj->setProperty ("ids", ids);
+    obj->setProperty ("labels", labels);
+    obj->setProperty ("values", values);
+    return juce::var (obj.release());
+}
+
+//==============================================================================
+UiBridge::UiBridge (HtmlToVstPluginAudioProcessor& processorIn)
+    : processor (processorIn)
+{
+}
+
+UiBridge::~UiBridge()
+{
+    detach();
+}
+
+void UiBridge::attach (juce::WebBrowserComponent& newBrowser, std::shared_ptr<Route> newRoute, bool wasWarm)
+{
+    // Editors opened in this process so far (message thread), so reopens show up in the log
+    static int numOpens = 0;
+
+    detach();
+    openIndex = ++numOpens;
+
+    browser = &newBrowser;
+    route = std::move (newRoute);
+    route->bridge = this;
+    openedWarm = wasWarm;
+}
+
+void UiBridge::notifyShown()
+{
+    // A warm page is already loaded and won't fire "load" again; ask it for a paint report.
+    if (browser != nullptr && openedWarm)
+        browser->emitEventIfBrowserIsVisible (kShownEvent, juce::var());
+}
+
+void UiBridge::detach()
+{
+    for (int i = 0; i < (int) kNumHtmlToVstParams; ++i)
+    {
+        if (gestureOpen[(size_t) i])
+            processor.getParameterByIndex (i)->endChangeGesture();
+
+        gestureOpen[(size_t) i] = false;
+    }
+
+    if (route != nullptr)
+        route->bridge = nullptr;
+
+    route.reset();
+    browser = nullptr;
+}
+
+void UiBridge::handlePainted()
+{
+    if (openStartTicks == 0)
+        return;
+
+    const auto ms = (double) (juce::Time::getHighResolutionTicks() - openStartTicks) * 1000.0
+                      / (double) juce::Time::getHighResolutionTicksPerSecond();
+    openStartTicks = 0;
+
+    if (isUiLogEnabled())
+        juce::Logger::writeToLog ("HTMLtoVST editor: first paint after " + juce::String (ms, 1) + " ms ("
+                                  + (openedWarm ? "warm" : "cold") + " webview, "
+                                  + (openIndex > 1 ? "reopen, open #" + juce::String (openIndex) : juce::String ("first open"))
+                                  + ")");
+}
+
+//==============================================================================
+void UiBridge::handleBatch (const juce::var& message)
+{
+    const auto* a = message.getArray();
+
+    if (a == nullptr || a->size() < kHeaderSize || (int) (*a)[0] != kProtocolVersion)
+    {
+        ++stats.malformed;
+        return;
+    }
+
+    const auto seq = (juce::int64) (*a)[1];
+
+    if (lastSeq >= 0 && seq > lastSeq + 1)
+        stats.dropped += (std::uint64_t) (seq - lastSeq - 1);
+
+    lastSeq = juce::jmax (lastSeq, seq);
+
+    const auto queueMs = (double) (*a)[3];
+    queueMsSum += queueMs;
+    stats.maxQueueMs = juce::jmax (stats.maxQueueMs, queueMs);
+    stats.coalesced += (std::uint64_t) juce::jmax (0, (int) (*a)[4]);
+    transportMsSum += (double) (*a)[5];
+    ++stats.batches;
+
+    bool anySet = false;
+
+    for (int i = kHeaderSize; i + kOpSize <= a->size(); i += kOpSize)
+    {
+        const auto kind  = (int) (*a)[i];
+        const auto index = (int) (*a)[i + 1];
+        const auto value = (float) (double) (*a)[i + 2];
+
+        if (kind < (int) OpKind::set || kind > (int) OpKind::end
+             || ! juce::isPositiveAndBelow (index, (int) kNumHtmlToVstParams))
+        {
+            ++stats.malformed;
+            continue;
+        }
+
+        applyOp ((OpKind) kind, index, value);
+        anySet = anySet || kind == (int) OpKind::set;
+        ++stats.ops;
+    }
+
+    if (anySet)
+        processor.noteUiParameterChange();
+
+    if (browser != nullptr)
+        browser->emitEventIfBrowserIsVisible (kAckEvent, juce::Array<juce::var> { juce::var (seq), (*a)[2] });
+}
+
+void UiBridge::applyOp (OpKind kind, int index, float value)
+{
+    auto* rp = processor.getParameterByIndex (index);
+    auto& open = gestureOpen[(size_t) index];
+
+    switch (kind)
+    {
+        case OpKind::begin:
+            if (! open)
+                rp->beginChangeGesture();
+
+            open = true;
+            break;
+
+        case OpKind::end:
+            if (open)
+                rp->endChangeGesture();
+
+            open = false;
+            break;
+
+        case OpKind::set:
+        {
+            // Keyboard edits and clicks arrive without a gesture; give the host one anyway.
+            const auto wrap = ! open;
+
+            if (wrap)
+                rp->beginChangeGesture();
+
+            rp->setValueNotifyingHost (juce::jlimit (0.0f, 1.0f, rp->convertTo0to1 (value)));
+
+            if (wrap)
+                rp->endChangeGesture();
+
+            break;
+        }
+    }
+}
+
+//==============================================================================
+void UiBridge::sendParamChanges (DirtyParams& dirty, const std::array<std::atomic<float>, kNumHtmlToVstParams>& values)
+{
+    if (browser == nullptr)
+        return;
+
+    int count = 0;
+
+    dirty.drain ([this, &values, &count] (int index)
+    {
+        paramPacket[(size_t) (2 + 2 * count)] = (float) index;
+        paramPacket[(size_t) (3 + 2 * count)] = values[(size_t) index].load (std::memory_order_relaxed);
+        ++count;
+    });
+
+    if (count == 0)
+        return;
+
+    paramPacket[0] = (float) kProtocolVersion;
+    paramPacket[1] = (float) count;
+
+    const auto numBytes = (size_t) (2 + 2 * count) * sizeof (float);
+    browser->emitEventIfBrowserIsVisible (kParamsEvent, juce::Base64::toBase64 (paramPacket.data(), numBytes));
+}
+
+void UiBridge::sendMeters (const htmltovst::MeterStream::Snapshot& snapshot)
+{
+    if (browser == nullptr)
+        return;
+
+    constexpr int header = 9;
+    std::array<float, header + htmltovst::MeterStream::kNumBands> packet;
+
+    packet[0] = (float) kProtocolVersion;
+    packet[1] = snapshot.peak[0];
+    packet[2] = snapshot.peak[1];
+    packet[3] = snapshot.rms[0];
+    packet[4] = snapshot.rms[1];
+    packet[5] = snapshot.gainReductionDb;
+    packet[6] = snapshot.drive;
+    packet[7] = (float) snapshot.overruns;
+    packet[8] = (float) htmltovst::MeterStream::kNumBands;
+    std::copy (snapshot.bandsDb.begin(), snapshot.bandsDb.end(), packet.begin() + header);
+
+    browser->emitEventIfBrowserIsVisible (kMetersEvent, juce::Base64::toBase64 (packet.data(), sizeof (packet)));
+}
+
+void UiBridge::sendCpu (const htmltovst::CpuTelemetry::Summary& summary)
+{
+    if (browser == nullptr)
+        return;
+
+    const std::array<float, 7> packet { (float) kProtocolVersion,
+                                        (float) summary.blocks,
+                                        (float) summary.meanLoad,
+                                        (float) summary.p99Load,
+                                        (float) summary.maxLoad,
+                                        (float) summary.meanUs,
+                                        (float) summary.overhead };
+
+    browser->emitEventIfBrowserIsVisible (kCpuEvent, juce::Base64::toBase64 (packet.data(), sizeof (packet)));
+}
+
+//==============================================================================
+UiBridge::Stats UiBridge::getStats() const
+{
+    auto s = stats;
+
+    if (s.batches > 0)
+    {
+        s.meanQueueMs     = queueMsSum / (double) s.batches;
+        s.meanTransportMs = transportMsSum / (double) s.batches;
+    }
+
+    const auto pickup = processor.getUiToDspLatency();
+    s.meanPickupMs = pickup.meanMs;
+    s.maxPickupMs  = pickup.maxMs;
+    return s;
+}
+
+void UiBridge::logStats() const
+{
+    if (! isUiLogEnabled())
+        return;
+
+    const auto s = getStats();
+
+    juce::String line;
+    line << "HTMLtoVST UI bridge: " << (juce::int64) s.batches << " batches, "
+         << (juce::int64) s.ops << " ops, "
+         << (juce::int64) s.coalesced << " coalesced, "
+         << (juce::int64) s.dropped << " dropped, "
+         << (juce::int64) s.malformed << " malformed; UI->DSP ~"
+         << juce::String (s.meanQueueMs + s.meanTransportMs + s.meanPickupMs, 2) << " ms mean (queue "
+         << juce::String (s.meanQueueMs, 2) << " / max " << juce::String (s.maxQueueMs, 2) << ", transport "
+         << juce::String (s.meanTransportMs, 2) << ", pickup "
+         << juce::String (s.meanPickupMs, 2) << " / max " << juce::String (s.maxPickupMs, 2) << ")";
+
+    juce::Logger::writeToLog (line);
+}
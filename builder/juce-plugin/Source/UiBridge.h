@@ -0,0 +1,159 @@
+#pragma once
+
+#include "PluginProcessor.h"
+#include <juce_gui_extra/juce_gui_extra.h>
+
+//==============================================================================
+// Web UI <-> processor channel over JUCE 8's native integration.
+//
+// JS -> C++: the page queues gestures, coalesces them once per animation frame and
+// emits a single "htv.in" event per frame. The payload is a flat number array:
+//
+//   [ version, seq, sentAtMs, queueAgeMs, coalesced, transportMs,
+//     kind, paramIndex, value,  kind, paramIndex, value, ... ]
+//
+// kind is 0 = set (plain value), 1 = begin gesture, 2 = end gesture; paramIndex is the
+// kHtmlToVstParams index. seq increases by one per batch, so gaps are dropped batches.
+//
+// C++ -> JS: "htv.ack" echoes [seq, sentAtMs] so the page can measure the round trip.
+// "htv.params", "htv.meters" and "htv.cpu" are each one base64 string of little-endian
+// float32, at most one of each per display frame and none while the editor is hidden:
+//
+//   htv.params  [ version, count, paramIndex, value, paramIndex, value, ... ]   changed only
+//   htv.meters  [ version, peakL, peakR, rmsL, rmsR, gainReductionDb, drive, overruns, numBands, bandsDb... ]
+//   htv.cpu     [ version, blocks, meanLoad, p99Load, maxLoad, meanUs, overhead ]   loads: 1 = the block's duration
+//
+// The page fetches ids/labels/values once through the "htvHello" native function.
+//
+// A browser is built once with makeOptions() and may outlive any one editor (see
+// WebViewPool); its callbacks go through a Route that the current editor's bridge
+// attaches to, so a warm page can be handed from one editor to the next.
+//==============================================================================
+
+class UiBridge
+{
+public:
+    static constexpr int kProtocolVersion = 1;
+
+    enum class OpKind
+    {
+        set   = 0,
+        begin = 1,
+        end   = 2
+    };
+
+    /** Where a browser's callbacks are delivered; null while no editor owns it. */
+    struct Route
+    {
+        UiBridge* bridge = nullptr;
+    };
+
+    /** Browser options with native integration, the bridge script, the BinaryData
+        resource provider and all listeners, routed through the given Route.
+    */
+    static juce::WebBrowserComponent::Options makeOptions (std::shared_ptr<Route> route);
+
+    explicit UiBridge (HtmlToVstPluginAudioProcessor& processorIn);
+    ~UiBridge();
+
+    /** Takes over a browser's callbacks. wasWarm only affects the time-to-first-paint log. */
+    void attach (juce::WebBrowserComponent& newBrowser, std::shared_ptr<Route> newRoute, bool wasWarm);
+
+    /** Releases any gesture the page left open (e.g. editor closed mid-drag) and the route. */
+    void detach();
+
+    /** Starts the editor-open clock; with HTMLTOVST_UI_LOG=1 the page's first paint after
+        this is logged, marked warm or cold and first open or reopen.
+    */
+    void startOpenTimer() noexcept     { openStartTicks = juce::Time::getHighResolutionTicks(); }
+
+    /** Call once the browser is on screen; a warm page reports its next paint. */
+    void notifyShown();
+
+    /** One bit per parameter. Set from any thread (parameter listeners can fire on the
+        audio thread), drained on the message thread by sendParamChanges().
+    */
+    class DirtyParams
+    {
+    public:
+        void set (int index) noexcept
+        {
+            words[(size_t) index >> 5].fetch_or (1u << (index & 31), std::memory_order_relaxed);
+        }
+
+        void setAll() noexcept
+        {
+            for (size_t i = 0; i < kNumHtmlToVstParams; ++i)
+                set ((int) i);
+        }
+
+        /** Clears every set bit, calling fn (index) for each in ascending order. */
+        template <typename Fn>
+        void drain (Fn&& fn) noexcept
+        {
+            for (size_t w = 0; w < words.size(); ++w)
+            {
+                for (auto bits = words[w].exchange (0, std::memory_order_acquire); bits != 0; bits &= bits - 1)
+                    fn ((int) (w << 5) + juce::findHighestSetBit (bits & (~bits + 1)));
+            }
+        }
+
+    private:
+        std::array<std::atomic<std::uint32_t>, (kNumHtmlToVstParams + 31) / 32> words {};
+    };
+
+    /** Pushes the plain values of the parameters marked dirty, and clears them.
+        values is indexed like kHtmlToVstParams. Nothing is sent if nothing changed.
+    */
+    void sendParamChanges (DirtyParams& dirty, const std::array<std::atomic<float>, kNumHtmlToVstParams>& values);
+
+    /** Pushes one meter/spectrum frame. */
+    void sendMeters (const htmltovst::MeterStream::Snapshot& snapshot);
+
+    /** Pushes the processor's CPU load over the editor's last window. */
+    void sendCpu (const htmltovst::CpuTelemetry::Summary& summary);
+
+    struct Stats
+    {
+        std::uint64_t batches   = 0;
+        std::uint64_t ops       = 0;
+        std::uint64_t coalesced = 0;    // input events merged in the page before sending
+        std::uint64_t dropped   = 0;    // batches missing from the sequence
+        std::uint64_t malformed = 0;
+
+        // UI event -> processBlock, split into the legs that can be measured
+        double meanQueueMs = 0.0, maxQueueMs = 0.0;           // in the page, waiting for the frame
+        double meanTransportMs = 0.0;                         // page -> message thread (rtt / 2)
+        double meanPickupMs = 0.0, maxPickupMs = 0.0;         // message thread -> audio thread
+    };
+
+    Stats getStats() const;
+
+    /** Writes getStats() to the log, if HTMLTOVST_UI_LOG=1 is set. */
+    void logStats() const;
+
+private:
+    void handleBatch (const juce::var& message);
+    void handlePainted();
+    void applyOp (OpKind kind, int index, float value);
+    static juce::var getHello (const HtmlToVstPluginAudioProcessor* processor);
+
+    HtmlToVstPluginAudioProcessor& processor;
+    juce::WebBrowserComponent* browser = nullptr;
+    std::shared_ptr<Route> route;
+
+    juce::int64 openStartTicks = 0;
+    bool openedWarm = false;
+    int openIndex = 0;
+
+    std::array<bool, kNumHtmlToVstParams> gestureOpen {};
+    juce::int64 lastSeq = -1;
+
+    // [ version, count, (index, value) * count ], reused for every push
+    std::array<float, 2 + 2 * kNumHtmlToVstParams> paramPacket {};
+
+    Stats stats;
+    double queueMsSum = 0.0, transportMsSum = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UiBridge)
+};
@@ -0,0 +1,89 @@
+#include "UiResources.h"
+
+#if __has_include("BinaryData.h")
+  #include "BinaryData.h"
+  #define HTMLTOVST_HAS_BINARYDATA 1
+#else
+  #define HTMLTOVST_HAS_BINARYDATA 0
+#endif
+
+namespace UiResources
+{
+
+// Served only when the build embedded no UI (ui/index.html is the real page)
+static const char* const fallbackIndexHtml = R"HTML(<!doctype html>
+<html lang="en"><head><meta charset="utf-8"/><title>HTMLtoVST</title></head>
+<body style="font-family:system-ui;margin:20px;background:#0b0e14;color:#e9eefb">
+<h2>HTMLtoVST</h2><p>This build has no UI assets: ui/index.html was not embedded.</p>
+</body></html>
+)HTML";
+
+static const char* getMimeType (const juce::String& fileName)
+{
+    static const std::pair<const char*, const char*> types[] =
+    {
+        { "html", "text/html" },
+        { "htm",  "text/html" },
+        { "js",   "text/javascript" },
+        { "mjs",  "text/javascript" },
+        { "css",  "text/css" },
+        { "json", "application/json" },
+        { "svg",  "image/svg+xml" },
+        { "png",  "image/png" },
+        { "jpg",  "image/jpeg" },
+        { "jpeg", "image/jpeg" },
+        { "gif",  "image/gif" },
+        { "webp", "image/webp" },
+        { "woff", "font/woff" },
+        { "woff2","font/woff2" },
+        { "ttf",  "font/ttf" },
+        { "wasm", "application/wasm" },
+    };
+
+    const auto ext = fileName.fromLastOccurrenceOf (".", false, false).toLowerCase();
+
+    for (const auto& t : types)
+        if (ext == t.first)
+            return t.second;
+
+    return "application/octet-stream";
+}
+
+static juce::WebBrowserComponent::Resource makeResource (const void* data, size_t size, const juce::String& fileName)
+{
+    const auto* bytes = static_cast<const std::byte*> (data);
+    return { std::vector<std::byte> (bytes, bytes + size), getMimeType (fileName) };
+}
+
+std::optional<juce::WebBrowserComponent::Resource> get (const juce::String& url)
+{
+    // Assets are flattened into BinaryData, so only the file name of the request matters.
+    auto fileName = url.upToFirstOccurrenceOf ("?", false, false)
+                       .upToFirstOccurrenceOf ("#", false, false)
+                       .fromLastOccurrenceOf ("/", false, false);
+
+    if (fileName.isEmpty())
+        fileName = "index.html";
+
+   #if HTMLTOVST_HAS_BINARYDATA
+    for (int i = 0; i < BinaryData::namedResourceListSize; ++i)
+    {
+        const auto* name = BinaryData::namedResourceList[i];
+
+        if (fileName == BinaryData::getNamedResourceOriginalFilename (name))
+        {
+            int size = 0;
+
+            if (const auto* data = BinaryData::getNamedResource (name, size))
+                return makeResource (data, (size_t) size, fileName);
+        }
+    }
+   #endif
+
+    if (fileName == "index.html")
+        return makeResource (fallbackIndexHtml, std::strlen (fallbackIndexHtml), fileName);
+
+    return std::nullopt;
+}
+
+} // namespace UiResources
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <juce_gui_extra/juce_gui_extra.h>
+
+//==============================================================================
+// Serves the editor's web UI straight from BinaryData through the browser's
+// resource provider: nothing is written to disk and every instance reads the
+// same read-only memory. "/" maps to index.html; a short error page is served if
+// the build embedded no UI.
+//==============================================================================
+
+namespace UiResources
+{
+    std::optional<juce::WebBrowserComponent::Resource> get (const juce::String& url);
+}
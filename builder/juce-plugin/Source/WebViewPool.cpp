@@ -0,0 +1,73 @@
+#include "WebViewPool.h"
+
+// Time after an editor takes the spare before its replacement is built, so the
+// new editor's own page load isn't competing with it.
+static constexpr int kRefillDelayMs = 1500;
+
+WebViewPool::~WebViewPool()
+{
+    stopTimer();
+}
+
+WebViewPool::Entry WebViewPool::create()
+{
+    Entry e;
+    e.route = std::make_shared<UiBridge::Route>();
+    e.browser = std::make_unique<juce::WebBrowserComponent> (UiBridge::makeOptions (e.route));
+    e.browser->goToURL (juce::WebBrowserComponent::getResourceProviderRoot());
+    return e;
+}
+
+WebViewPool::Entry WebViewPool::acquire()
+{
+   #if HTMLTOVST_WEBVIEW_POOL
+    if (spare.browser != nullptr)
+    {
+        auto e = std::move (spare);
+        spare = {};
+        e.warm = true;
+        prewarm (kRefillDelayMs);
+        return e;
+    }
+
+    prewarm (kRefillDelayMs);
+   #endif
+
+    return create();
+}
+
+void WebViewPool::release (Entry entry)
+{
+    if (entry.browser == nullptr)
+        return;
+
+    if (auto* parent = entry.browser->getParentComponent())
+        parent->removeChildComponent (entry.browser.get());
+
+   #if HTMLTOVST_WEBVIEW_POOL
+    if (spare.browser == nullptr)
+    {
+        entry.route->bridge = nullptr;
+        spare = std::move (entry);
+        stopTimer();
+    }
+   #endif
+}
+
+void WebViewPool::prewarm (int delayMs)
+{
+   #if HTMLTOVST_WEBVIEW_POOL
+    if (spare.browser == nullptr && ! isTimerRunning())
+        startTimer (juce::jmax (1, delayMs));
+   #else
+    juce::ignoreUnused (delayMs);
+   #endif
+}
+
+void WebViewPool::timerCallback()
+{
+    stopTimer();
+
+    if (spare.browser == nullptr)
+        spare = create();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "UiBridge.h"
+
+//==============================================================================
+// Process-wide spare WebBrowserComponent with the UI already loaded.
+//
+// Opening an editor takes the spare (and schedules a replacement) instead of
+// spinning up a webview and loading the page; closing one hands its browser back
+// if the pool is empty. Shared through juce::SharedResourcePointer by the editors
+// and the processors, so the spare outlives the window it came from and reopening
+// one is warm. Only editors ever create browsers, so a process that never opens a
+// UI (a render farm, a plug-in scan) never holds a webview. Message thread only.
+//
+// Compiled out (every editor builds its own browser) when HTMLTOVST_WEBVIEW_POOL=0.
+//==============================================================================
+
+#ifndef HTMLTOVST_WEBVIEW_POOL
+  #define HTMLTOVST_WEBVIEW_POOL 1
+#endif
+
+class WebViewPool final : private juce::Timer
+{
+public:
+    struct Entry
+    {
+        std::unique_ptr<juce::WebBrowserComponent> browser;
+        std::shared_ptr<UiBridge::Route> route;
+        bool warm = false;
+    };
+
+    WebViewPool() = default;
+    ~WebViewPool() override;
+
+    /** The warm spare if there is one, otherwise a freshly created browser. */
+    Entry acquire();
+
+    /** Keeps the browser as the spare if there is none; otherwise it is destroyed. */
+    void release (Entry entry);
+
+    /** Creates the spare after delayMs, unless one exists by then. Delayed so that
+        the editor being opened loads its own page first.
+    */
+    void prewarm (int delayMs);
+
+private:
+    void timerCallback() override;
+    static Entry create();
+
+    Entry spare;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WebViewPool)
+};
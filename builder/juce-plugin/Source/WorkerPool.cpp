@@ -0,0 +1,350 @@
+#include "WorkerPool.h"
+#include "RealtimeCheck.h"
+
+#if JUCE_WINDOWS
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+  #include <mach/mach.h>
+#else
+  #include <cerrno>
+  #include <semaphore.h>
+#endif
+
+#if JUCE_INTEL
+  #include <immintrin.h>
+#endif
+
+namespace htmltovst
+{
+
+// Roughly 50-500 us of waiting before a worker parks, depending on the CPU's pause
+static constexpr int kSpinIterations = 4096;
+
+static void pause() noexcept
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif JUCE_ARM && ! JUCE_MSVC
+    asm volatile ("yield");
+   #endif
+}
+
+static std::uint64_t packRange (int begin, int end) noexcept
+{
+    return (std::uint64_t) (std::uint32_t) end << 32 | (std::uint32_t) begin;
+}
+
+/** The owner takes from the front... */
+static bool takeFront (std::atomic<std::uint64_t>& range, int& task) noexcept
+{
+    auto r = range.load (std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto begin = (int) (std::uint32_t) r, end = (int) (r >> 32);
+
+        if (begin >= end)
+            return false;
+
+        if (range.compare_exchange_weak (r, packRange (begin + 1, end), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            task = begin;
+            return true;
+        }
+    }
+}
+
+/** ...and thieves from the back, so they only meet over the last task. */
+static bool takeBack (std::atomic<std::uint64_t>& range, int& task) noexcept
+{
+    auto r = range.load (std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto begin = (int) (std::uint32_t) r, end = (int) (r >> 32);
+
+        if (begin >= end)
+            return false;
+
+        if (range.compare_exchange_weak (r, packRange (begin, end - 1), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            task = end - 1;
+            return true;
+        }
+    }
+}
+
+//==============================================================================
+// post() is a single atomic increment plus a kernel wake when someone is waiting
+class WorkerPool::Semaphore
+{
+public:
+   #if JUCE_WINDOWS
+    Semaphore()                 : handle (CreateSemaphoreW (nullptr, 0, 0x7fffffff, nullptr)) {}
+    ~Semaphore()                { CloseHandle (handle); }
+    void post() noexcept        { ReleaseSemaphore (handle, 1, nullptr); }
+    void wait() noexcept        { WaitForSingleObject (handle, INFINITE); }
+
+   private:
+    HANDLE handle;
+   #elif JUCE_MAC || JUCE_IOS
+    Semaphore()                 { semaphore_create (mach_task_self(), &sem, SYNC_POLICY_FIFO, 0); }
+    ~Semaphore()                { semaphore_destroy (mach_task_self(), sem); }
+    void post() noexcept        { semaphore_signal (sem); }
+    void wait() noexcept        { semaphore_wait (sem); }
+
+   private:
+    semaphore_t sem;
+   #else
+    Semaphore()                 { sem_init (&sem, 0, 0); }
+    ~Semaphore()                { sem_destroy (&sem); }
+    void post() noexcept        { sem_post (&sem); }
+
+    void wait() noexcept
+    {
+        while (sem_wait (&sem) != 0 && errno == EINTR)
+        {}
+    }
+
+   private:
+    sem_t sem;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (Semaphore)
+};
+
+//==============================================================================
+class WorkerPool::Worker final : public juce::Thread
+{
+public:
+    Worker (WorkerPool& owner, int queueIndex)
+        : juce::Thread ("HtmlToVst DSP worker " + juce::String (queueIndex)),
+          pool (owner), queue (queueIndex)
+    {
+    }
+
+    /** From run(): posts only if this worker parked, and then only once. */
+    void wake() noexcept
+    {
+        if (parked.exchange (false))
+            semaphore.post();
+    }
+
+    void run() override
+    {
+        auto seen = pool.epoch.load();
+
+        while (! threadShouldExit())
+        {
+            waitForJob (seen);
+            seen = pool.epoch.load (std::memory_order_acquire);
+
+            // Harmless if woken for nothing: the queues are empty
+            pool.work (queue);
+        }
+    }
+
+private:
+    void waitForJob (std::uint32_t seen) noexcept
+    {
+        for (int i = 0; i < kSpinIterations; ++i)
+        {
+            if (pool.epoch.load (std::memory_order_acquire) != seen)
+                return;
+
+            pause();
+        }
+
+        // Park, unless a job (or stop()) came in meanwhile. Both sides go through parked:
+        // whichever clears it decides whether a post is coming, so none is lost or left over.
+        parked.store (true);
+
+        if (pool.epoch.load() != seen || threadShouldExit())
+            if (parked.exchange (false))
+                return;
+
+        semaphore.wait();
+    }
+
+    WorkerPool& pool;
+    const int queue;
+    std::atomic<bool> parked { false };
+    Semaphore semaphore;
+};
+
+//==============================================================================
+WorkerPool::WorkerPool() = default;
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start (int newNumWorkers, double sampleRate, int blockSize)
+{
+    newNumWorkers = juce::jlimit (0, kMaxWorkers, newNumWorkers);
+
+    if (newNumWorkers == numWorkers)
+        return;
+
+    stop();
+
+    const auto options = juce::Thread::RealtimeOptions().withApproximateAudioProcessingTime (juce::jmax (1, blockSize), sampleRate);
+
+    for (int i = 0; i < newNumWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker> (*this, i + 1);
+
+        // Real-time scheduling may need privileges the process doesn't have
+        if (! worker->startRealtimeThread (options))
+            worker->startThread (juce::Thread::Priority::highest);
+
+        workers[(size_t) i] = std::move (worker);
+    }
+
+    numWorkers = newNumWorkers;
+}
+
+void WorkerPool::stop()
+{
+    if (numWorkers == 0)
+        return;
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers[(size_t) i]->signalThreadShouldExit();
+
+    epoch.fetch_add (1);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers[(size_t) i]->wake();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers[(size_t) i]->stopThread (1000);
+        workers[(size_t) i].reset();
+    }
+
+    numWorkers = 0;
+}
+
+void WorkerPool::runTasks (int numTasks, TaskFunction function, void* context) noexcept
+{
+    const auto numThreads = numWorkers + 1;
+
+    // Everything a worker needs is written before the ranges it takes tasks from are
+    // published: taking a task acquires them.
+    pending.store (numTasks, std::memory_order_relaxed);
+    taskFunction.store (function, std::memory_order_relaxed);
+    taskContext.store (context, std::memory_order_relaxed);
+
+    for (int t = 0; t < numThreads; ++t)
+        queues[(size_t) t].range.store (packRange (numTasks * t / numThreads, numTasks * (t + 1) / numThreads),
+                                        std::memory_order_release);
+
+    epoch.fetch_add (1);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers[(size_t) i]->wake();
+
+    work (0);
+
+    // The join: every task has finished, and its writes are visible, before returning
+    while (pending.load (std::memory_order_acquire) > 0)
+        pause();
+}
+
+void WorkerPool::work (int queue) noexcept
+{
+    // Workers run the audio thread's work, so the checker watches them while they do
+    const RealtimeCheck::ScopedRealtime realtime;
+    const auto numThreads = numWorkers + 1;
+
+    for (;;)
+    {
+        int task = 0;
+        auto found = takeFront (queues[(size_t) queue].range, task);
+
+        for (int i = 1; i < numThreads && ! found; ++i)
+            found = takeBack (queues[(size_t) ((queue + i) % numThreads)].range, task);
+
+        if (! found)
+            return;
+
+        taskFunction.load (std::memory_order_relaxed) (taskContext.load (std::memory_order_relaxed), task);
+        pending.fetch_sub (1, std::memory_order_release);
+    }
+}
+
+//==============================================================================
+void SplitGate::reset() noexcept
+{
+    phase = Phase::trialSerial;
+    runsInPhase = 0;
+    ticks = {};
+    samples = {};
+    splitting = false;
+}
+
+bool SplitGate::shouldSplit (std::uint32_t workload) noexcept
+{
+    if (workload != currentWorkload)
+    {
+        currentWorkload = workload;
+        reset();
+    }
+
+    switch (phase)
+    {
+        case Phase::trialSerial: return false;
+        case Phase::trialSplit:  return true;
+        case Phase::settled:     break;
+    }
+
+    return splitting;
+}
+
+void SplitGate::record (bool didSplit, std::uint64_t elapsed, int numSamples) noexcept
+{
+    ++runsInPhase;
+
+    if (phase == Phase::settled)
+    {
+        if (runsInPhase >= kSettledRuns)
+        {
+            phase = Phase::trialSerial;
+            runsInPhase = 0;
+            ticks = {};
+            samples = {};
+        }
+
+        return;
+    }
+
+    if (runsInPhase > kWarmupRuns)
+    {
+        ticks[didSplit ? 1 : 0] += (double) elapsed;
+        samples[didSplit ? 1 : 0] += (double) numSamples;
+    }
+
+    if (runsInPhase < kTrialRuns)
+        return;
+
+    runsInPhase = 0;
+
+    if (phase == Phase::trialSerial)
+    {
+        phase = Phase::trialSplit;
+        return;
+    }
+
+    const auto serialPerSample = ticks[0] / juce::jmax (1.0, samples[0]);
+    const auto splitPerSample  = ticks[1] / juce::jmax (1.0, samples[1]);
+
+    splitting = splitPerSample < (1.0 - kMinSaving) * serialPerSample;
+    phase = Phase::settled;
+}
+
+} // namespace htmltovst
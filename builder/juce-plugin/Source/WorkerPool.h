@@ -0,0 +1,129 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//==============================================================================
+// Pre-spawned threads for splitting one block's work from the audio thread.
+//
+// run() hands out tasks 0..n-1 and returns once every one has finished, so the caller
+// sees exactly what running them in a loop would give. Each thread, the caller included,
+// starts with a contiguous range of tasks in its own queue, takes from the front of it and
+// steals from the back of the others' once it runs dry. A queue is one 64-bit word updated
+// by compare-and-swap: nothing locks, nothing allocates.
+//
+// Between jobs a worker spins for a while, then parks on a semaphore. run() only posts to
+// workers that actually parked, and posting never blocks.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class WorkerPool
+{
+public:
+    static constexpr int kMaxWorkers = 15;
+
+    WorkerPool();
+    ~WorkerPool();
+
+    /** Spawns numWorkers threads besides the caller's (0 = none: run() is a plain loop),
+        real-time if the system allows, sized for blocks like this one. Not while run()
+        may be called.
+    */
+    void start (int numWorkers, double sampleRate, int blockSize);
+    void stop();
+
+    int getNumWorkers() const noexcept          { return numWorkers; }
+
+    /** Runs fn (task) for every task in 0..numTasks-1, on the workers and the calling thread,
+        and returns when all have finished. Audio thread.
+    */
+    template <typename Fn>
+    void run (int numTasks, Fn& fn) noexcept
+    {
+        if (numWorkers == 0 || numTasks <= 1)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                fn (i);
+
+            return;
+        }
+
+        runTasks (numTasks, [] (void* context, int task) { (*static_cast<Fn*> (context)) (task); }, &fn);
+    }
+
+private:
+    using TaskFunction = void (*) (void* context, int task);
+
+    class Semaphore;
+    class Worker;
+
+    // Tasks [begin, end) as end << 32 | begin
+    struct alignas (64) TaskQueue
+    {
+        std::atomic<std::uint64_t> range { 0 };
+    };
+
+    void runTasks (int numTasks, TaskFunction function, void* context) noexcept;
+    void work (int queue) noexcept;
+
+    std::array<std::unique_ptr<Worker>, kMaxWorkers> workers;
+    int numWorkers = 0;
+
+    std::array<TaskQueue, kMaxWorkers + 1> queues;      // [0] is the caller's
+    alignas (64) std::atomic<std::uint32_t> epoch { 0 };
+    std::atomic<int> pending { 0 };
+    std::atomic<TaskFunction> taskFunction { nullptr };
+    std::atomic<void*> taskContext { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE (WorkerPool)
+};
+
+//==============================================================================
+/** Whether splitting a stage across the pool pays, by measurement: a short trial of
+    blocks run on one thread, another split, then the faster for a few thousand blocks
+    before trying again. Splitting must save kMinSaving of the stage's time, or the
+    extra threads' CPU isn't worth it. A new workload (layout, rate, solver...) starts
+    a new trial. Audio thread only.
+*/
+class SplitGate
+{
+public:
+    static constexpr double kMinSaving = 0.1;
+
+    void reset() noexcept;
+
+    /** Whether to split the next stage run of this workload. */
+    bool shouldSplit (std::uint32_t workload) noexcept;
+
+    /** The time the stage took (any clock, the same every call) for numSamples. */
+    void record (bool didSplit, std::uint64_t ticks, int numSamples) noexcept;
+
+    /** The outcome of the last trial. */
+    bool isSplitting() const noexcept           { return splitting; }
+
+private:
+    static constexpr int kWarmupRuns  = 4;      // per side, not counted
+    static constexpr int kTrialRuns   = 32;     // per side, warm-up included
+    static constexpr int kSettledRuns = 4096;
+
+    enum class Phase
+    {
+        trialSerial,
+        trialSplit,
+        settled
+    };
+
+    Phase phase = Phase::trialSerial;
+    int runsInPhase = 0;
+    std::uint32_t currentWorkload = 0;
+    std::array<double, 2> ticks {}, samples {};     // serial, split
+    bool splitting = false;
+};
+
+} // namespace htmltovst
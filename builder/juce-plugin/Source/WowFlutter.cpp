@@ -0,0 +1,354 @@
+#include "WowFlutter.h"
+#include "SharedTables.h"
+
+#include <juce_core/juce_core.h>
+
+namespace htmltovst
+{
+
+//==============================================================================
+// At 15 ips and full depth: peak speed error (fraction of nominal) and rate of each
+// component, in phasor lane order. Rates scale with speed; errors with 1 / sqrt (speed).
+static constexpr float kDeviation[Float4::size] = { 0.0010f, 0.0004f, 0.0005f, 0.0002f };
+static constexpr float kRateHz[Float4::size]    = { 0.5f,    1.3f,    6.5f,    11.3f };
+static constexpr bool kIsFlutter[Float4::size]  = { false,   false,   true,    true };
+
+// Fixed starting phases, so the components don't all cross zero together
+static constexpr float kStartPhase[Float4::size] = { 0.0f, 1.7f, 0.6f, 2.9f };
+
+// Noise: low-passed at this rate (scaled with speed), as a share of the first flutter component
+static constexpr float kNoiseHz = 40.0f;
+static constexpr float kNoiseShare = 0.3f;
+static constexpr std::uint32_t kNoiseSeed = 0x9e3779b9u;
+
+static constexpr double kSincKaiserBeta = 6.0;
+
+static double besselI0 (double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+WowFlutter::SincTable WowFlutter::makeSincTable()
+{
+    constexpr auto halfWidth = (double) kSincTaps / 2.0;
+    SincTable table {};
+
+    for (int p = 0; p <= kSincPhases; ++p)
+    {
+        // Tap j sits (j - 3) samples past the whole delay; the kernel is centred on the fraction
+        const auto frac = (double) p / (double) kSincPhases;
+        auto& row = table[(size_t) p];
+        double sum = 0.0;
+
+        for (int j = 0; j < kSincTaps; ++j)
+        {
+            const auto x = (double) (j - (kSincTaps / 2 - 1)) - frac;
+            const auto t = juce::jlimit (-1.0, 1.0, x / halfWidth);
+            const auto sincValue = std::abs (x) < 1.0e-9 ? 1.0 : std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+            const auto w = sincValue * besselI0 (kSincKaiserBeta * std::sqrt (1.0 - t * t)) / besselI0 (kSincKaiserBeta);
+
+            row[(size_t) j] = (float) w;
+            sum += w;
+        }
+
+        // Unity gain at DC for every fraction
+        for (auto& w : row)
+            w = (float) (w / sum);
+    }
+
+    return table;
+}
+
+std::shared_ptr<const WowFlutter::SincTable> WowFlutter::getSharedSincTable (SharedTables& tables)
+{
+    return tables.get<SincTable> ("wowFlutterSinc", makeSincTable);
+}
+
+//==============================================================================
+void WowFlutter::prepare (std::shared_ptr<const SincTable> table, double newSampleRate)
+{
+    sinc = std::move (table);
+    sampleRate = newSampleRate;
+
+    // The deepest modulation either side of the centre, plus the sinc's reach behind it
+    const auto deviation = (int) std::ceil (kMaxDeviationSeconds * sampleRate);
+    maxDeviation = (float) deviation;
+    centreDelay = deviation + kSincTaps / 2 + 1;
+
+    ringSize = juce::nextPowerOfTwo (2 * centreDelay + kSincTaps + 1);
+    ringMask = ringSize - 1;
+    ring.assign ((size_t) (kMaxGroups * ringSize), Float4::broadcast (0.0f));
+
+    ratesForIps = -1.0;
+    reset();
+}
+
+void WowFlutter::reset() noexcept
+{
+    std::fill (ring.begin(), ring.end(), Float4::broadcast (0.0f));
+    lastOut.fill (Float4::broadcast (0.0f));
+    writePos = 0;
+
+    float c[Float4::size], s[Float4::size];
+
+    for (int k = 0; k < Float4::size; ++k)
+    {
+        c[k] = std::cos (kStartPhase[k]);
+        s[k] = std::sin (kStartPhase[k]);
+    }
+
+    phasorCos = Float4::load (c);
+    phasorSin = Float4::load (s);
+
+    noiseState = kNoiseSeed;
+    noiseLowpass = 0.0f;
+
+    // Start at the current depth rather than gliding up from nothing
+    amplitude = amplitudeTarget;
+    noiseDepth = noiseDepthTarget;
+    glideRemaining = 0;
+}
+
+void WowFlutter::setSettings (const Settings& newSettings) noexcept
+{
+    if (sampleRate <= 0.0)
+        return;
+
+    settings = newSettings;
+
+    const auto speed = juce::jlimit (1.0, 60.0, settings.speedIps) / 15.0;
+    const auto wow = juce::jlimit (0.0f, 1.0f, settings.wow);
+    const auto flutter = juce::jlimit (0.0f, 1.0f, settings.flutter);
+
+    if (! juce::exactlyEqual (speed, ratesForIps))
+    {
+        ratesForIps = speed;
+
+        float c[Float4::size], s[Float4::size];
+
+        for (int k = 0; k < Float4::size; ++k)
+        {
+            const auto w = juce::MathConstants<double>::twoPi * kRateHz[k] * speed / sampleRate;
+            c[k] = (float) std::cos (w);
+            s[k] = (float) std::sin (w);
+        }
+
+        rotateCos = Float4::load (c);
+        rotateSin = Float4::load (s);
+
+        noiseCoeff = (float) (1.0 - std::exp (-juce::MathConstants<double>::twoPi * kNoiseHz * speed / sampleRate));
+
+        // A one-pole's output RMS for uniform white noise in [-1, 1]
+        noiseNorm = 1.0f / (0.57735f * std::sqrt (noiseCoeff / (2.0f - noiseCoeff)));
+    }
+
+    float target[Float4::size];
+
+    for (int k = 0; k < Float4::size; ++k)
+    {
+        const auto rate = (double) kRateHz[k] * speed;
+        const auto depth = kIsFlutter[k] ? flutter : wow;
+        target[k] = (float) ((double) (kDeviation[k] * depth) / std::sqrt (speed)
+                             / (juce::MathConstants<double>::twoPi * rate) * sampleRate);
+    }
+
+    const auto newTarget = Float4::load (target);
+    const auto newNoise = kNoiseShare * target[2];
+
+    float current[Float4::size];
+    amplitudeTarget.store (current);
+
+    const auto same = [] (float a, float b) { return juce::exactlyEqual (a, b); };
+
+    if (std::equal (std::begin (current), std::end (current), std::begin (target), same) && same (newNoise, noiseDepthTarget))
+        return;
+
+    const auto glide = juce::jmax (1, (int) (kGlideSeconds * sampleRate));
+    amplitudeTarget = newTarget;
+    amplitudeStep = (newTarget - amplitude) * Float4::broadcast (1.0f / (float) glide);
+    noiseDepthTarget = newNoise;
+    noiseDepthStep = (newNoise - noiseDepth) / (float) glide;
+    glideRemaining = glide;
+}
+
+//==============================================================================
+void WowFlutter::computeTaps (int numSamples) noexcept
+{
+    const auto centre = (float) centreDelay;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Rotate every phasor one sample on
+        const auto c = phasorCos * rotateCos - phasorSin * rotateSin;
+        phasorSin = phasorSin * rotateCos + phasorCos * rotateSin;
+        phasorCos = c;
+
+        if (glideRemaining > 0)
+        {
+            amplitude = amplitude + amplitudeStep;
+            noiseDepth += noiseDepthStep;
+
+            if (--glideRemaining == 0)
+            {
+                amplitude = amplitudeTarget;
+                noiseDepth = noiseDepthTarget;
+            }
+        }
+
+        float lanes[Float4::size];
+        (phasorSin * amplitude).store (lanes);
+
+        noiseState = noiseState * 1664525u + 1013904223u;
+        const auto white = (float) (std::int32_t) noiseState * (1.0f / 2147483648.0f);
+        noiseLowpass += noiseCoeff * (white - noiseLowpass);
+
+        const auto modulation = lanes[0] + lanes[1] + lanes[2] + lanes[3] + noiseDepth * noiseNorm * noiseLowpass;
+        const auto delay = centre + juce::jlimit (-maxDeviation, maxDeviation, modulation);
+
+        auto whole = (int) delay;
+        auto frac = delay - (float) whole;
+        auto& w = taps.weights[(size_t) i];
+
+        switch (settings.interpolation)
+        {
+            case Interpolation::linear:
+                taps.first[(size_t) i] = whole;
+                w[0] = 1.0f - frac;
+                w[1] = frac;
+                break;
+
+            case Interpolation::cubic:
+            {
+                const auto f2 = frac * frac, f3 = f2 * frac;
+                taps.first[(size_t) i] = whole - 1;
+                w[0] = 0.5f * (-frac + 2.0f * f2 - f3);
+                w[1] = 0.5f * (2.0f - 5.0f * f2 + 3.0f * f3);
+                w[2] = 0.5f * (frac + 4.0f * f2 - 3.0f * f3);
+                w[3] = 0.5f * (f3 - f2);
+                break;
+            }
+
+            case Interpolation::allpass:
+            {
+                // Keep the allpass's own delay in [0.5, 1.5), where it is best behaved
+                if (frac < 0.5f)
+                {
+                    --whole;
+                    frac += 1.0f;
+                }
+
+                const auto a = (1.0f - frac) / (1.0f + frac);
+                taps.first[(size_t) i] = whole;
+                taps.feedback[(size_t) i] = a;
+                w[0] = a;
+                w[1] = 1.0f;
+                break;
+            }
+
+            case Interpolation::sinc:
+            {
+                const auto position = frac * (float) kSincPhases;
+                const auto row = juce::jmin ((int) position, kSincPhases - 1);
+                const auto t = position - (float) row;
+                const auto& lo = (*sinc)[(size_t) row];
+                const auto& hi = (*sinc)[(size_t) row + 1];
+
+                taps.first[(size_t) i] = whole - (kSincTaps / 2 - 1);
+
+                for (size_t j = 0; j < (size_t) kSincTaps; ++j)
+                    w[j] = lo[j] + t * (hi[j] - lo[j]);
+
+                break;
+            }
+        }
+    }
+
+    // Pull the phasors back onto the unit circle (one Newton step) against rounding drift
+    const auto magnitude = phasorCos * phasorCos + phasorSin * phasorSin;
+    const auto correction = (Float4::broadcast (3.0f) - magnitude) * Float4::broadcast (0.5f);
+    phasorCos = phasorCos * correction;
+    phasorSin = phasorSin * correction;
+}
+
+template <int numTaps, bool recursive, typename SampleType>
+void WowFlutter::processGroup (int group, SampleType* const* lanes, int numLanes, int numSamples) noexcept
+{
+    auto* const line = ring.data() + group * ringSize;
+    auto last = lastOut[(size_t) group];
+
+    processLanes (lanes, numLanes, numSamples, [&] (Float4 x, int i) noexcept
+    {
+        const auto pos = (writePos + i) & ringMask;
+        line[pos] = x;
+
+        const auto start = pos - taps.first[(size_t) i];
+        const auto& w = taps.weights[(size_t) i];
+        auto y = line[start & ringMask] * Float4::broadcast (w[0]);
+
+        for (int t = 1; t < numTaps; ++t)
+            y = y + line[(start - t) & ringMask] * Float4::broadcast (w[(size_t) t]);
+
+        if constexpr (recursive)
+            y = y - Float4::broadcast (taps.feedback[(size_t) i]) * last;
+
+        last = y;
+        return y;
+    });
+
+    // A NaN from the host must not circulate in the allpass or stay in the line
+    if (! Float4::isFinite (last))
+    {
+        std::fill (line, line + ringSize, Float4::broadcast (0.0f));
+        last = Float4::broadcast (0.0f);
+    }
+
+    lastOut[(size_t) group] = last;
+}
+
+template <typename SampleType>
+void WowFlutter::process (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert (numChannels <= kMaxChannels);
+    numChannels = juce::jmin (numChannels, kMaxChannels);
+
+    if (ring.empty() || sinc == nullptr)
+        return;
+
+    for (int pos = 0; pos < numSamples; pos += kChunk)
+    {
+        const auto n = juce::jmin (kChunk, numSamples - pos);
+        computeTaps (n);
+
+        for (int g = 0; g * Float4::size < numChannels; ++g)
+        {
+            std::array<SampleType*, Float4::size> lanes {};
+            const auto numLanes = juce::jmin (Float4::size, numChannels - g * Float4::size);
+
+            for (int l = 0; l < numLanes; ++l)
+                lanes[(size_t) l] = channels[g * Float4::size + l] + pos;
+
+            switch (settings.interpolation)
+            {
+                case Interpolation::linear:   processGroup<2, false>         (g, lanes.data(), numLanes, n); break;
+                case Interpolation::cubic:    processGroup<4, false>         (g, lanes.data(), numLanes, n); break;
+                case Interpolation::allpass:  processGroup<2, true>          (g, lanes.data(), numLanes, n); break;
+                case Interpolation::sinc:     processGroup<kSincTaps, false> (g, lanes.data(), numLanes, n); break;
+            }
+        }
+
+        writePos = (writePos + n) & ringMask;
+    }
+}
+
+template void WowFlutter::process (float* const*, int, int) noexcept;
+template void WowFlutter::process (double* const*, int, int) noexcept;
+
+} // namespace htmltovst
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "SimdLanes.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Wow and flutter for the "ampex_102" engine: the playback read through a delay line
+// whose length follows the transport's speed error.
+//
+// The speed error is four sinusoids (two slow wow components from the reels, two
+// flutter components from the capstan and idler) plus low-passed noise, all from fixed
+// phases and a fixed seed, so every render is the same. Rates rise with tape speed and
+// the deviation falls with it. The sinusoids are one four-lane rotating phasor (no sin()
+// per sample); each shifts the delay by its speed deviation / (2 pi f), the integral of
+// the speed error.
+//
+// The line is a preallocated ring of Float4 per four channels. All channels share the
+// tape, so the read position and interpolation weights are worked out once per sample and
+// applied to every lane. The line sits at a fixed centre delay (the deepest modulation
+// plus the interpolator's reach) which is reported as latency whatever the depth, so
+// automating the depth never moves the signal in time.
+//==============================================================================
+
+namespace htmltovst
+{
+
+class SharedTables;
+
+class WowFlutter
+{
+public:
+    enum class Interpolation
+    {
+        linear  = 0,
+        cubic   = 1,    // 4-point Catmull-Rom
+        allpass = 2,    // first-order Thiran: flat magnitude, recursive
+        sinc    = 3     // 8-tap Kaiser-windowed sinc
+    };
+
+    static constexpr int kMaxChannels = 16;
+    static constexpr double kMaxDeviationSeconds = 0.0015;
+
+    static constexpr int kSincTaps = 8;
+    static constexpr int kSincPhases = 256;
+
+    /** Sinc weights per fractional delay; one row more than the phases so adjacent rows
+        can always be interpolated.
+    */
+    using SincTable = std::array<std::array<float, kSincTaps>, kSincPhases + 1>;
+
+    static SincTable makeSincTable();
+
+    /** makeSincTable()'s result from the process-wide cache. */
+    static std::shared_ptr<const SincTable> getSharedSincTable (SharedTables& tables);
+
+    struct Settings
+    {
+        float wow = 0.0f;           // 0..1
+        float flutter = 0.0f;       // 0..1
+        double speedIps = 15.0;
+        Interpolation interpolation = Interpolation::cubic;
+    };
+
+    /** Allocates the line for this rate. Not on the audio thread. */
+    void prepare (std::shared_ptr<const SincTable> table, double sampleRate);
+    void reset() noexcept;
+
+    /** Block-rate. Depth changes glide over kGlideSeconds. */
+    void setSettings (const Settings& newSettings) noexcept;
+
+    /** The fixed centre delay, in samples; 0 until prepared. */
+    int getLatencySamples() const noexcept          { return centreDelay; }
+
+    /** Buffers may be float or double; the line runs in float. Pass-through until prepared. */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    static constexpr int kMaxGroups = (kMaxChannels + Float4::size - 1) / Float4::size;
+    static constexpr int kChunk = 64;
+    static constexpr double kGlideSeconds = 0.05;
+
+    // Read positions and weights for one chunk, shared by every group of channels
+    struct Taps
+    {
+        std::array<int, kChunk> first {};                           // delay of weight 0, whole samples
+        std::array<std::array<float, kSincTaps>, kChunk> weights {};
+        std::array<float, kChunk> feedback {};                      // allpass only
+    };
+
+    void computeTaps (int numSamples) noexcept;
+
+    template <int numTaps, bool recursive, typename SampleType>
+    void processGroup (int group, SampleType* const* lanes, int numLanes, int numSamples) noexcept;
+
+    std::shared_ptr<const SincTable> sinc;
+    double sampleRate = 0.0;
+    int centreDelay = 0;
+    float maxDeviation = 0.0f;      // samples
+
+    std::vector<Float4> ring;       // kMaxGroups lines of ringSize
+    int ringSize = 0, ringMask = 0, writePos = 0;
+    std::array<Float4, kMaxGroups> lastOut {};
+
+    Settings settings;
+    double ratesForIps = -1.0;
+
+    // One lane per sinusoid: phasor, per-sample rotation and delay amplitude (samples)
+    Float4 phasorCos {}, phasorSin {}, rotateCos {}, rotateSin {};
+    Float4 amplitude {}, amplitudeTarget {}, amplitudeStep {};
+    int glideRemaining = 0;
+
+    // Low-passed white noise, scaled to unit RMS, and its share of the flutter
+    std::uint32_t noiseState = 0;
+    float noiseLowpass = 0.0f, noiseCoeff = 0.0f, noiseNorm = 0.0f;
+    float noiseDepth = 0.0f, noiseDepthTarget = 0.0f, noiseDepthStep = 0.0f;
+
+    Taps taps;
+};
+
+} // namespace htmltovst
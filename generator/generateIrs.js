@@ -0,0 +1,127 @@
+// generator/generateIrs.js
+//
+// Writes the impulse responses the "ampex_102" engine convolves with (see
+// builder/juce-plugin/Source/Convolver.h) to builder/juce-plugin/Assets/IR/:
+//
+//   headblock_stereo.wav, headblock_mono.wav   playback head contour (head bump and gap loss)
+//   transformer.wav                            output transformer
+//
+// These are modelled stand-ins built from filter designs. Measured responses saved under
+// the same names (mono, any rate, 32-bit float or PCM) drop in without code changes;
+// the plug-in resamples them and normalises each to unity at 1 kHz.
+
+const fs = require("fs");
+const path = require("path");
+
+const SAMPLE_RATE = 48000;
+const outDir = path.join(__dirname, "..", "builder", "juce-plugin", "Assets", "IR");
+
+// RBJ cookbook biquads, normalised to a0 = 1
+function peaking(f0, q, gainDb) {
+  const a = Math.pow(10, gainDb / 40);
+  const w = 2 * Math.PI * f0 / SAMPLE_RATE;
+  const alpha = Math.sin(w) / (2 * q);
+  const a0 = 1 + alpha / a;
+  return { b: [(1 + alpha * a) / a0, -2 * Math.cos(w) / a0, (1 - alpha * a) / a0],
+           a: [-2 * Math.cos(w) / a0, (1 - alpha / a) / a0] };
+}
+
+function lowShelf(f0, slope, gainDb) {
+  const a = Math.pow(10, gainDb / 40);
+  const w = 2 * Math.PI * f0 / SAMPLE_RATE;
+  const cw = Math.cos(w);
+  const alpha = Math.sin(w) / 2 * Math.sqrt((a + 1 / a) * (1 / slope - 1) + 2);
+  const s = 2 * Math.sqrt(a) * alpha;
+  const a0 = (a + 1) + (a - 1) * cw + s;
+  return { b: [a * ((a + 1) - (a - 1) * cw + s) / a0, 2 * a * ((a - 1) - (a + 1) * cw) / a0, a * ((a + 1) - (a - 1) * cw - s) / a0],
+           a: [-2 * ((a - 1) + (a + 1) * cw) / a0, ((a + 1) + (a - 1) * cw - s) / a0] };
+}
+
+function lowPass(f0, q) {
+  const w = 2 * Math.PI * f0 / SAMPLE_RATE;
+  const alpha = Math.sin(w) / (2 * q);
+  const cw = Math.cos(w);
+  const a0 = 1 + alpha;
+  return { b: [(1 - cw) / 2 / a0, (1 - cw) / a0, (1 - cw) / 2 / a0],
+           a: [-2 * cw / a0, (1 - alpha) / a0] };
+}
+
+// Impulse response of a biquad cascade, faded out over its last quarter
+function impulseResponse(sections, length) {
+  const y = new Float64Array(length);
+  y[0] = 1;
+
+  for (const s of sections) {
+    let z1 = 0, z2 = 0;
+
+    for (let i = 0; i < length; ++i) {
+      const x = y[i];
+      const out = s.b[0] * x + z1;
+      z1 = s.b[1] * x - s.a[0] * out + z2;
+      z2 = s.b[2] * x - s.a[1] * out;
+      y[i] = out;
+    }
+  }
+
+  const fadeStart = Math.floor(length * 3 / 4);
+
+  for (let i = fadeStart; i < length; ++i)
+    y[i] *= 0.5 * (1 + Math.cos(Math.PI * (i - fadeStart) / (length - fadeStart)));
+
+  // Unity at 1 kHz
+  let re = 0, im = 0;
+
+  for (let i = 0; i < length; ++i) {
+    re += y[i] * Math.cos(2 * Math.PI * 1000 * i / SAMPLE_RATE);
+    im -= y[i] * Math.sin(2 * Math.PI * 1000 * i / SAMPLE_RATE);
+  }
+
+  const gain = Math.hypot(re, im);
+  return y.map((v) => v / gain);
+}
+
+// Mono 32-bit float WAV
+function writeWav(file, samples) {
+  const dataBytes = samples.length * 4;
+  const buf = Buffer.alloc(44 + dataBytes);
+
+  buf.write("RIFF", 0);
+  buf.writeUInt32LE(36 + dataBytes, 4);
+  buf.write("WAVE", 8);
+  buf.write("fmt ", 12);
+  buf.writeUInt32LE(16, 16);
+  buf.writeUInt16LE(3, 20);               // IEEE float
+  buf.writeUInt16LE(1, 22);
+  buf.writeUInt32LE(SAMPLE_RATE, 24);
+  buf.writeUInt32LE(SAMPLE_RATE * 4, 28);
+  buf.writeUInt16LE(4, 32);
+  buf.writeUInt16LE(32, 34);
+  buf.write("data", 36);
+  buf.writeUInt32LE(dataBytes, 40);
+
+  samples.forEach((v, i) => buf.writeFloatLE(v, 44 + i * 4));
+  fs.writeFileSync(file, buf);
+  console.log(`Wrote ${file}`);
+}
+
+// Half-track stereo heads: a modest bump with the usual dip an octave below, slight gap loss.
+// The full-track mono head's wider track puts a larger bump lower down.
+const IRS = {
+  headblock_stereo: { length: 2048, sections: [peaking(85, 1.0, 2.0), peaking(40, 1.2, -1.5), peaking(16000, 0.7, -0.6)] },
+  headblock_mono:   { length: 2048, sections: [peaking(65, 1.1, 3.0), peaking(30, 1.2, -2.0), peaking(15000, 0.7, -0.8)] },
+  transformer:      { length: 1024, sections: [lowShelf(100, 0.7, 0.8), peaking(7000, 0.8, 0.4), lowPass(21000, 0.6)] },
+};
+
+function main() {
+  fs.mkdirSync(outDir, { recursive: true });
+
+  for (const [name, ir] of Object.entries(IRS))
+    writeWav(path.join(outDir, name + ".wav"), impulseResponse(ir.sections, ir.length));
+}
+
+try {
+  main();
+} catch (err) {
+  console.error(err);
+  process.exit(1);
+}
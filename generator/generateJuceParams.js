@@ -3,12 +3,83 @@
 // Reads generator/currentSpec.json and generates
 // builder/juce-plugin/Source/GeneratedParams.h
 //
-// This does NOT change DSP yet; it just emits a C++ param spec
-// that Stage 2 (the JUCE build) can use.
+// The header is a constexpr parameter table with enum indices. The plugin
+// builds its parameter layout, cached parameter pointers, editor listeners
+// and JS bridge from it, so the audio thread never looks params up by name.
 
 const fs = require("fs");
 const path = require("path");
 
+// Parameters owned by the plugin's built-in DSP chain. They are always emitted
+// first so their indices (and the session-facing IDs) never move when the spec
+// changes. Spec params with the same id are skipped.
+const CORE_PARAMS = [
+  { id: "inGain",   label: "Input Gain",          type: "knob", min: -24, max: 24, default: 0, step: 0.01 },
+  { id: "drive",    label: "Drive",               type: "knob", min: 0,   max: 1,  default: 0, step: 0.0001 },
+  { id: "outGain",  label: "Output Gain",         type: "knob", min: -24, max: 24, default: 0, step: 0.01 },
+  { id: "osFactor", label: "Oversampling",        type: "enum", options: ["1x", "2x", "4x", "8x"], values: [1, 2, 4, 8], default: "1x" },
+  { id: "osMode",   label: "Oversampling Filter", type: "enum", options: ["IIR (low latency)", "FIR (linear phase)"], default: "IIR (low latency)" },
+  { id: "quality",  label: "Quality",             type: "enum", options: ["Auto", "Eco", "Realtime", "Best"], default: "Auto" },
+];
+
+// Extra parameters a built-in engine adds on top of the spec's own.
+const ENGINE_PARAMS = {
+  ampex_102: [
+    { id: "tapeSolver", label: "Tape Solver", type: "enum", options: ["RK2", "RK4", "NR x4", "NR x8"], default: "RK2" },
+    { id: "wow",        label: "Wow",         type: "knob", min: 0, max: 1, default: 0, step: 0.001 },
+    { id: "flutter",    label: "Flutter",     type: "knob", min: 0, max: 1, default: 0, step: 0.001 },
+    { id: "wowInterp",  label: "Wow/Flutter Interpolation", type: "enum", options: ["Linear", "Cubic", "Allpass", "Sinc"], default: "Cubic" },
+  ],
+};
+
+function cppString(s) {
+  return '"' + String(s).replace(/\\/g, "\\\\").replace(/"/g, '\\"') + '"';
+}
+
+function cppNumber(v) {
+  const s = String(Number(v));
+  return /[.eE]/.test(s) ? s : s + ".0";
+}
+
+function cppIdentifier(id) {
+  const s = String(id).replace(/[^A-Za-z0-9_]/g, "_");
+  return /^[0-9]/.test(s) ? "_" + s : s;
+}
+
+// Normalises one spec param into the shape the C++ table needs.
+function toTableEntry(p) {
+  const id = String(p.id || "");
+  const label = String(p.label || id);
+  const type = String(p.type || "knob");
+
+  const entry = { id, label, kind: "knob", min: 0.0, max: 1.0, def: 0.0, step: 0.0, options: null, values: null };
+
+  if (type === "bool") {
+    entry.kind = "toggle";
+    entry.def = p.default ? 1.0 : 0.0;
+  } else if (type === "enum") {
+    // Enums are 0..N-1 indices; numeric options keep their value for the DSP
+    const opts = Array.isArray(p.options) ? p.options : [];
+    entry.kind = "choice";
+    entry.options = opts.map(String);
+    entry.values = Array.isArray(p.values)
+      ? p.values.map(Number)
+      : opts.map((o, i) => (typeof o === "number" ? o : i));
+    entry.max = opts.length > 0 ? opts.length - 1 : 0.0;
+    const defIdx = opts.length > 0 ? opts.indexOf(p.default) : -1;
+    entry.def = defIdx >= 0 ? defIdx : 0.0;
+    entry.step = 1.0;
+  } else {
+    // "knob", "slider" and anything unknown are continuous
+    if (typeof p.min === "number") entry.min = p.min;
+    if (typeof p.max === "number") entry.max = p.max;
+    if (typeof p.default === "number") entry.def = p.default;
+    if (typeof p.step === "number") entry.step = p.step;
+  }
+
+  return entry;
+}
+
 function main() {
   const specPath = path.join(__dirname, "currentSpec.json");
   const outHeaderPath = path.join(
@@ -39,12 +110,29 @@ function main() {
     throw err;
   }
 
+  // Accept the /analyze API response shape ({ ok, spec }) as well as a bare spec
+  if (spec && typeof spec.spec === "object" && spec.spec !== null) {
+    spec = spec.spec;
+  }
+
   const name = spec.name || "Unnamed Plugin";
   const engine = spec.engine || "auto";
-  const params = Array.isArray(spec.params) ? spec.params : [];
+  const specParams = Array.isArray(spec.params) ? spec.params : [];
 
   console.log(`Generating JUCE params for "${name}" (engine: ${engine})`);
-  console.log(`Found ${params.length} parameter(s).`);
+  console.log(`Found ${specParams.length} parameter(s).`);
+
+  const builtIns = CORE_PARAMS.concat(ENGINE_PARAMS[engine] || []);
+  const coreIds = new Set(builtIns.map((p) => p.id));
+  const params = builtIns.concat(
+    specParams.filter((p) => {
+      if (coreIds.has(p.id)) {
+        console.warn(`Skipping spec param '${p.id}': reserved by the built-in DSP chain.`);
+        return false;
+      }
+      return true;
+    })
+  ).map(toTableEntry);
 
   // Build C++ header
   let header = "";
@@ -56,55 +144,65 @@ function main() {
   header += "// ===================================================================\n";
   header += "\n";
   header += "#pragma once\n\n";
-  header += "#include <cstddef>\n\n";
+  header += "#include <cstddef>\n";
+  header += "#include <string_view>\n\n";
+  header += "enum class HtmlToVstParamType { knob, choice, toggle };\n\n";
   header += "struct HtmlToVstParamSpec {\n";
   header += "    const char* id;\n";
   header += "    const char* label;\n";
-  header += "    const char* type;   // \"knob\", \"enum\", \"bool\", ...\n";
+  header += "    HtmlToVstParamType type;\n";
   header += "    double minValue;\n";
   header += "    double maxValue;\n";
   header += "    double defaultValue;\n";
+  header += "    double interval;               // 0 = continuous\n";
+  header += "    const char* const* options;    // choice labels, nullptr otherwise\n";
+  header += "    const double* optionValues;    // numeric value of each choice\n";
+  header += "    int numOptions;\n";
   header += "};\n\n";
 
+  header += `static constexpr std::string_view kHtmlToVstPluginName = ${cppString(name)};\n`;
+  header += `static constexpr std::string_view kHtmlToVstEngine = ${cppString(engine)};\n\n`;
+
+  params.forEach((p) => {
+    if (p.kind !== "choice") return;
+    const ident = cppIdentifier(p.id);
+    header += `static constexpr const char* kHtmlToVstOptions_${ident}[] = { ${p.options.map(cppString).join(", ")} };\n`;
+    header += `static constexpr double kHtmlToVstOptionValues_${ident}[] = { ${p.values.map(cppNumber).join(", ")} };\n`;
+  });
+  header += "\n";
+
+  header += "namespace HtmlToVstParam {\n";
+  header += "    enum Index : int {\n";
+  params.forEach((p) => {
+    header += `        ${cppIdentifier(p.id)},\n`;
+  });
+  header += "        numParams\n";
+  header += "    };\n";
+  header += "}\n\n";
+
+  const kindNames = { knob: "knob", choice: "choice", toggle: "toggle" };
+
   header += "static constexpr HtmlToVstParamSpec kHtmlToVstParams[] = {\n";
 
   params.forEach((p, idx) => {
-    const id = String(p.id || "").replace(/"/g, '\\"');
-    const label = String(p.label || id).replace(/"/g, '\\"');
-    const type = String(p.type || "knob").replace(/"/g, '\\"');
-
-    let min = 0.0;
-    let max = 1.0;
-    let d = 0.0;
-
-    if (type === "knob" || type === "slider") {
-      if (typeof p.min === "number") min = p.min;
-      if (typeof p.max === "number") max = p.max;
-      if (typeof p.default === "number") d = p.default;
-    } else if (type === "bool") {
-      min = 0.0;
-      max = 1.0;
-      d = p.default ? 1.0 : 0.0;
-    } else if (type === "enum") {
-      // Map enums to 0..N-1 index space for now
-      const opts = Array.isArray(p.options) ? p.options : [];
-      min = 0.0;
-      max = opts.length > 0 ? opts.length - 1 : 0.0;
-      const defIdx = opts.length > 0 ? opts.indexOf(p.default) : -1;
-      d = defIdx >= 0 ? defIdx : 0.0;
-    } else {
-      // Fallback
-      if (typeof p.min === "number") min = p.min;
-      if (typeof p.max === "number") max = p.max;
-      if (typeof p.default === "number") d = p.default;
-    }
-
-    header += `    { "${id}", "${label}", "${type}", ${min}, ${max}, ${d} }`;
+    const ident = cppIdentifier(p.id);
+    const opts = p.kind === "choice" ? `kHtmlToVstOptions_${ident}, kHtmlToVstOptionValues_${ident}, ${p.options.length}` : "nullptr, nullptr, 0";
+
+    header += `    { ${cppString(p.id)}, ${cppString(p.label)}, HtmlToVstParamType::${kindNames[p.kind]}, `;
+    header += `${cppNumber(p.min)}, ${cppNumber(p.max)}, ${cppNumber(p.def)}, ${cppNumber(p.step)}, ${opts} }`;
     header += idx === params.length - 1 ? "\n" : ",\n";
   });
 
   header += "};\n\n";
   header += "static constexpr std::size_t kNumHtmlToVstParams = sizeof(kHtmlToVstParams) / sizeof(HtmlToVstParamSpec);\n";
+  header += "static_assert(kNumHtmlToVstParams == HtmlToVstParam::numParams, \"param table and index enum out of sync\");\n\n";
+  header += "// Compile-time lookup by ID; -1 if the current spec doesn't define it.\n";
+  header += "static constexpr int findHtmlToVstParam(std::string_view id) {\n";
+  header += "    for (std::size_t i = 0; i < kNumHtmlToVstParams; ++i)\n";
+  header += "        if (std::string_view(kHtmlToVstParams[i].id) == id)\n";
+  header += "            return (int) i;\n";
+  header += "    return -1;\n";
+  header += "}\n";
 
   fs.mkdirSync(path.dirname(outHeaderPath), { recursive: true });
   fs.writeFileSync(outHeaderPath, header, "utf8");